@@ -30,6 +30,11 @@ IF (${WALRUS_ASAN} STREQUAL "1")
     SET (WALRUS_LDFLAGS ${WALRUS_LDFLAGS} -lasan)
 ENDIF()
 
+# modules are parsed and instances are executed by several threads
+IF (${WALRUS_THREADS} STREQUAL "1")
+    SET (WALRUS_DEFINITIONS ${WALRUS_DEFINITIONS} -DGC_THREADS)
+ENDIF()
+
 
 # SOURCE FILES
 FILE (GLOB_RECURSE WALRUS_SRC ${WALRUS_ROOT}/src/*.cpp)
@@ -52,6 +57,11 @@ IF (WALRUS_SMALL_CONFIG)
     SET (GCUTIL_CFLAGS ${GCUTIL_CFLAGS} -DSMALL_CONFIG -DMAX_HEAP_SECTS=512)
 ENDIF()
 
+# thread local free lists keep allocation of threads from contending on the allocator lock
+IF (${WALRUS_THREADS} STREQUAL "1")
+    SET (GCUTIL_CFLAGS ${GCUTIL_CFLAGS} -DGC_THREADS -DTHREAD_LOCAL_ALLOC -DPARALLEL_MARK)
+ENDIF()
+
 SET (GCUTIL_MODE ${WALRUS_MODE})
 
 ADD_SUBDIRECTORY (third_party/GCutil)
@@ -25,6 +25,8 @@
 
 namespace Walrus {
 
+class FunctionType;
+
 class ByteCode {
 public:
     OpcodeKind opcode() const { return m_opcode; }
@@ -201,6 +203,107 @@ protected:
     uint32_t m_index;
 };
 
+class CallIndirect : public ByteCode {
+public:
+    CallIndirect(uint32_t tableIndex, FunctionType* functionType, uint32_t cacheIndex)
+        : CallIndirect(OpcodeKind::CallIndirectOpcode, tableIndex, functionType, cacheIndex)
+    {
+    }
+
+    uint32_t tableIndex() const { return m_tableIndex; }
+    FunctionType* functionType() const { return m_functionType; }
+    // bytecode is shared by every instance of the module, so the inline cache
+    // of the site is kept by the instance(see Instance::callIndirectCache)
+    uint32_t cacheIndex() const { return m_cacheIndex; }
+
+    // every element of the table is null or has the type of the call site(see WASMParser::EndModule)
+    void removeSignatureCheck()
+    {
+        ASSERT(m_opcode == OpcodeKind::CallIndirectOpcode);
+        m_opcode = OpcodeKind::CallIndirectWithoutSignatureCheckOpcode;
+    }
+
+    // used by ModuleCache, which stores the index of the type instead of the pointer
+    void setFunctionType(FunctionType* functionType)
+    {
+        m_functionType = functionType;
+    }
+
+    // used by ModuleCache, which numbers the sites of a module again when it is read
+    void setCacheIndex(uint32_t cacheIndex)
+    {
+        m_cacheIndex = cacheIndex;
+    }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("tableIndex: %" PRId32 " functionType: %p", m_tableIndex, m_functionType);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(CallIndirect);
+    }
+#endif
+
+protected:
+    CallIndirect(OpcodeKind opcode, uint32_t tableIndex, FunctionType* functionType, uint32_t cacheIndex)
+        : ByteCode(opcode)
+        , m_tableIndex(tableIndex)
+        , m_cacheIndex(cacheIndex)
+        , m_functionType(functionType)
+    {
+    }
+
+    uint32_t m_tableIndex;
+    uint32_t m_cacheIndex;
+    FunctionType* m_functionType;
+};
+
+// call_indirect with a constant element index
+// rewritten to CallDevirtualized when the element is known statically(see WASMParser::EndModule)
+class CallIndirectConstant : public CallIndirect {
+public:
+    CallIndirectConstant(uint32_t tableIndex, FunctionType* functionType, uint32_t cacheIndex, uint32_t elementIndex)
+        : CallIndirect(OpcodeKind::CallIndirectConstantOpcode, tableIndex, functionType, cacheIndex)
+        , m_elementIndex(elementIndex)
+        , m_functionIndex(0)
+    {
+    }
+
+    uint32_t elementIndex() const { return m_elementIndex; }
+    uint32_t functionIndex() const { return m_functionIndex; }
+
+    void devirtualize(uint32_t functionIndex)
+    {
+        ASSERT(m_opcode == OpcodeKind::CallIndirectConstantOpcode);
+        m_opcode = OpcodeKind::CallDevirtualizedOpcode;
+        m_functionIndex = functionIndex;
+    }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        CallIndirect::dump(pos);
+        if (m_opcode == OpcodeKind::CallDevirtualizedOpcode) {
+            printf(" functionIndex: %" PRId32, m_functionIndex);
+        } else {
+            printf(" elementIndex: %" PRId32, m_elementIndex);
+        }
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(CallIndirectConstant);
+    }
+#endif
+
+protected:
+    uint32_t m_elementIndex;
+    uint32_t m_functionIndex;
+};
+
 class LocalGet4 : public ByteCode {
 public:
     LocalGet4(uint32_t offset)
@@ -585,6 +688,380 @@ public:
 protected:
 };
 
+class MemorySize64 : public ByteCode {
+public:
+    MemorySize64(uint32_t index)
+        : ByteCode(OpcodeKind::MemorySize64Opcode)
+    {
+        ASSERT(index == 0);
+    }
+
+
+#if !defined(NDEBUG)
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemorySize64);
+    }
+#endif
+
+protected:
+};
+
+class MemoryGrow64 : public ByteCode {
+public:
+    MemoryGrow64(uint32_t index)
+        : ByteCode(OpcodeKind::MemoryGrow64Opcode)
+    {
+        ASSERT(index == 0);
+    }
+
+
+#if !defined(NDEBUG)
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryGrow64);
+    }
+#endif
+
+protected:
+};
+
+class MemoryLoad : public ByteCode {
+public:
+    MemoryLoad(OpcodeKind opcode, uint32_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryLoad);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+class MemoryStore : public ByteCode {
+public:
+    MemoryStore(OpcodeKind opcode, uint32_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryStore);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+// memory access with the address read directly from a local, so
+// local.get + load needs a single dispatch
+class MemoryLoadFromLocal : public ByteCode {
+public:
+    MemoryLoadFromLocal(OpcodeKind opcode, uint32_t offset, uint32_t localOffset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+        , m_localOffset(localOffset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+    uint32_t localOffset() const { return m_localOffset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32 " local offset: %" PRIu32, m_offset, m_localOffset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryLoadFromLocal);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+    uint32_t m_localOffset;
+};
+
+// memory store with both the address and the value read directly from locals
+class MemoryStoreFromLocals : public ByteCode {
+public:
+    MemoryStoreFromLocals(OpcodeKind opcode, uint32_t offset, uint32_t addressLocalOffset, uint32_t valueLocalOffset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+        , m_addressLocalOffset(addressLocalOffset)
+        , m_valueLocalOffset(valueLocalOffset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+    uint32_t addressLocalOffset() const { return m_addressLocalOffset; }
+    uint32_t valueLocalOffset() const { return m_valueLocalOffset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32 " address local offset: %" PRIu32 " value local offset: %" PRIu32, m_offset, m_addressLocalOffset, m_valueLocalOffset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryStoreFromLocals);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+    uint32_t m_addressLocalOffset;
+    uint32_t m_valueLocalOffset;
+};
+
+class Memory64Load : public ByteCode {
+public:
+    Memory64Load(OpcodeKind opcode, uint64_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint64_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu64, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(Memory64Load);
+    }
+#endif
+
+protected:
+    uint64_t m_offset;
+};
+
+class Memory64Store : public ByteCode {
+public:
+    Memory64Store(OpcodeKind opcode, uint64_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint64_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu64, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(Memory64Store);
+    }
+#endif
+
+protected:
+    uint64_t m_offset;
+};
+
+class AtomicRmw : public ByteCode {
+public:
+    AtomicRmw(OpcodeKind opcode, uint32_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(AtomicRmw);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+class AtomicRmwCmpxchg : public ByteCode {
+public:
+    AtomicRmwCmpxchg(OpcodeKind opcode, uint32_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(AtomicRmwCmpxchg);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+class MemoryAtomicWait : public ByteCode {
+public:
+    MemoryAtomicWait(OpcodeKind opcode, uint32_t offset)
+        : ByteCode(opcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryAtomicWait);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+class MemoryAtomicNotify : public ByteCode {
+public:
+    MemoryAtomicNotify(uint32_t offset)
+        : ByteCode(OpcodeKind::MemoryAtomicNotifyOpcode)
+        , m_offset(offset)
+    {
+    }
+
+    uint32_t offset() const { return m_offset; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("offset: %" PRIu32, m_offset);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(MemoryAtomicNotify);
+    }
+#endif
+
+protected:
+    uint32_t m_offset;
+};
+
+class AtomicFence : public ByteCode {
+public:
+    AtomicFence()
+        : ByteCode(OpcodeKind::AtomicFenceOpcode)
+    {
+    }
+};
+
+class RefFunc : public ByteCode {
+public:
+    RefFunc(uint32_t funcIndex)
+        : ByteCode(OpcodeKind::RefFuncOpcode)
+        , m_funcIndex(funcIndex)
+    {
+    }
+
+    uint32_t funcIndex() const { return m_funcIndex; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("funcIndex: %" PRId32, m_funcIndex);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(RefFunc);
+    }
+#endif
+
+protected:
+    uint32_t m_funcIndex;
+};
+
+class RefNull : public ByteCode {
+public:
+    RefNull()
+        : ByteCode(OpcodeKind::RefNullOpcode)
+    {
+    }
+
+#if !defined(NDEBUG)
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(RefNull);
+    }
+#endif
+};
+
+class RefIsNull : public ByteCode {
+public:
+    RefIsNull()
+        : ByteCode(OpcodeKind::RefIsNullOpcode)
+    {
+    }
+
+#if !defined(NDEBUG)
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(RefIsNull);
+    }
+#endif
+};
+
 class TableGet : public ByteCode {
 public:
     TableGet(uint32_t index)
@@ -714,6 +1191,61 @@ protected:
     uint32_t m_tableIndex;
 };
 
+class TableInit : public ByteCode {
+public:
+    TableInit(uint32_t tableIndex, uint32_t segmentIndex)
+        : ByteCode(OpcodeKind::TableInitOpcode)
+        , m_tableIndex(tableIndex)
+        , m_segmentIndex(segmentIndex)
+    {
+    }
+
+    uint32_t tableIndex() const { return m_tableIndex; }
+    uint32_t segmentIndex() const { return m_segmentIndex; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("tableIndex: %" PRId32 " segmentIndex: %" PRId32, m_tableIndex, m_segmentIndex);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(TableInit);
+    }
+#endif
+
+protected:
+    uint32_t m_tableIndex;
+    uint32_t m_segmentIndex;
+};
+
+class ElemDrop : public ByteCode {
+public:
+    ElemDrop(uint32_t segmentIndex)
+        : ByteCode(OpcodeKind::ElemDropOpcode)
+        , m_segmentIndex(segmentIndex)
+    {
+    }
+
+    uint32_t segmentIndex() const { return m_segmentIndex; }
+
+#if !defined(NDEBUG)
+    virtual void dump(size_t pos)
+    {
+        printf("segmentIndex: %" PRId32, m_segmentIndex);
+    }
+
+    virtual size_t byteCodeSize()
+    {
+        return sizeof(ElemDrop);
+    }
+#endif
+
+protected:
+    uint32_t m_segmentIndex;
+};
+
 class GlobalGet4 : public ByteCode {
 public:
     GlobalGet4(uint32_t index)
@@ -184,6 +184,160 @@ void Interpreter::interpret(ExecutionState& state,
         NEXT_INSTRUCTION();                                       \
     }
 
+#define MEMORY_LOAD_OPERATION(opcodeName, readTypeName, writeTypeName)                                             \
+    DEFINE_OPCODE(opcodeName)                                                                                      \
+        :                                                                                                          \
+    {                                                                                                              \
+        MemoryLoad* code = (MemoryLoad*)programCounter;                                                            \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                 \
+        readTypeName value;                                                                                        \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->load(offset, code->offset(), &value); \
+        writeValue<writeTypeName>(sp, value);                                                                      \
+        ADD_PROGRAM_COUNTER(MemoryLoad);                                                                           \
+        NEXT_INSTRUCTION();                                                                                        \
+    }
+
+#define MEMORY_STORE_OPERATION(opcodeName, readTypeName, writeTypeName)                                            \
+    DEFINE_OPCODE(opcodeName)                                                                                      \
+        :                                                                                                          \
+    {                                                                                                              \
+        MemoryStore* code = (MemoryStore*)programCounter;                                                          \
+        writeTypeName value = static_cast<writeTypeName>(readValue<readTypeName>(sp));                             \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                 \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->store(offset, code->offset(), value); \
+        ADD_PROGRAM_COUNTER(MemoryStore);                                                                          \
+        NEXT_INSTRUCTION();                                                                                        \
+    }
+
+#define MEMORY_LOAD_UNCHECKED_OPERATION(opcodeName, readTypeName, writeTypeName)                                            \
+    DEFINE_OPCODE(opcodeName)                                                                                               \
+        :                                                                                                                   \
+    {                                                                                                                       \
+        MemoryLoad* code = (MemoryLoad*)programCounter;                                                                     \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                          \
+        readTypeName value;                                                                                                 \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->loadUnchecked(offset, code->offset(), &value); \
+        writeValue<writeTypeName>(sp, value);                                                                               \
+        ADD_PROGRAM_COUNTER(MemoryLoad);                                                                                    \
+        NEXT_INSTRUCTION();                                                                                                 \
+    }
+
+#define MEMORY_STORE_UNCHECKED_OPERATION(opcodeName, readTypeName, writeTypeName)                                           \
+    DEFINE_OPCODE(opcodeName)                                                                                               \
+        :                                                                                                                   \
+    {                                                                                                                       \
+        MemoryStore* code = (MemoryStore*)programCounter;                                                                   \
+        writeTypeName value = static_cast<writeTypeName>(readValue<readTypeName>(sp));                                      \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                          \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->storeUnchecked(offset, code->offset(), value); \
+        ADD_PROGRAM_COUNTER(MemoryStore);                                                                                   \
+        NEXT_INSTRUCTION();                                                                                                 \
+    }
+
+#define MEMORY_LOAD_FROM_LOCAL_OPERATION(opcodeName, readTypeName, writeTypeName, loadFunction)                            \
+    DEFINE_OPCODE(opcodeName)                                                                                              \
+        :                                                                                                                  \
+    {                                                                                                                      \
+        MemoryLoadFromLocal* code = (MemoryLoadFromLocal*)programCounter;                                                  \
+        uint32_t offset = *reinterpret_cast<uint32_t*>(&bp[code->localOffset()]);                                          \
+        readTypeName value;                                                                                                \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->loadFunction(offset, code->offset(), &value); \
+        writeValue<writeTypeName>(sp, value);                                                                              \
+        ADD_PROGRAM_COUNTER(MemoryLoadFromLocal);                                                                          \
+        NEXT_INSTRUCTION();                                                                                                \
+    }
+
+#define MEMORY_STORE_FROM_LOCALS_OPERATION(opcodeName, readTypeName, writeTypeName, storeFunction)                         \
+    DEFINE_OPCODE(opcodeName)                                                                                              \
+        :                                                                                                                  \
+    {                                                                                                                      \
+        MemoryStoreFromLocals* code = (MemoryStoreFromLocals*)programCounter;                                              \
+        writeTypeName value = static_cast<writeTypeName>(*reinterpret_cast<readTypeName*>(&bp[code->valueLocalOffset()])); \
+        uint32_t offset = *reinterpret_cast<uint32_t*>(&bp[code->addressLocalOffset()]);                                   \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->storeFunction(offset, code->offset(), value); \
+        ADD_PROGRAM_COUNTER(MemoryStoreFromLocals);                                                                        \
+        NEXT_INSTRUCTION();                                                                                                \
+    }
+
+#define MEMORY64_LOAD_OPERATION(opcodeName, readTypeName, writeTypeName)                                             \
+    DEFINE_OPCODE(opcodeName)                                                                                        \
+        :                                                                                                            \
+    {                                                                                                                \
+        Memory64Load* code = (Memory64Load*)programCounter;                                                          \
+        uint64_t offset = readValue<uint64_t>(sp);                                                                   \
+        readTypeName value;                                                                                          \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->load64(offset, code->offset(), &value); \
+        writeValue<writeTypeName>(sp, value);                                                                        \
+        ADD_PROGRAM_COUNTER(Memory64Load);                                                                           \
+        NEXT_INSTRUCTION();                                                                                          \
+    }
+
+#define MEMORY64_STORE_OPERATION(opcodeName, readTypeName, writeTypeName)                                            \
+    DEFINE_OPCODE(opcodeName)                                                                                        \
+        :                                                                                                            \
+    {                                                                                                                \
+        Memory64Store* code = (Memory64Store*)programCounter;                                                        \
+        writeTypeName value = static_cast<writeTypeName>(readValue<readTypeName>(sp));                               \
+        uint64_t offset = readValue<uint64_t>(sp);                                                                   \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->store64(offset, code->offset(), value); \
+        ADD_PROGRAM_COUNTER(Memory64Store);                                                                          \
+        NEXT_INSTRUCTION();                                                                                          \
+    }
+
+#define ATOMIC_LOAD_OPERATION(opcodeName, readTypeName, writeTypeName)                                                   \
+    DEFINE_OPCODE(opcodeName)                                                                                            \
+        :                                                                                                                \
+    {                                                                                                                    \
+        MemoryLoad* code = (MemoryLoad*)programCounter;                                                                  \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                       \
+        readTypeName value;                                                                                              \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicLoad(offset, code->offset(), &value); \
+        writeValue<writeTypeName>(sp, value);                                                                            \
+        ADD_PROGRAM_COUNTER(MemoryLoad);                                                                                 \
+        NEXT_INSTRUCTION();                                                                                              \
+    }
+
+#define ATOMIC_STORE_OPERATION(opcodeName, readTypeName, writeTypeName)                                                  \
+    DEFINE_OPCODE(opcodeName)                                                                                            \
+        :                                                                                                                \
+    {                                                                                                                    \
+        MemoryStore* code = (MemoryStore*)programCounter;                                                                \
+        writeTypeName value = static_cast<writeTypeName>(readValue<readTypeName>(sp));                                   \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                       \
+        state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicStore(offset, code->offset(), value); \
+        ADD_PROGRAM_COUNTER(MemoryStore);                                                                                \
+        NEXT_INSTRUCTION();                                                                                              \
+    }
+
+#define ATOMIC_RMW_OPERATION(opcodeName, valueTypeName, memoryTypeName, atomicFunction)                                                                       \
+    DEFINE_OPCODE(opcodeName)                                                                                                                                 \
+        :                                                                                                                                                     \
+    {                                                                                                                                                         \
+        AtomicRmw* code = (AtomicRmw*)programCounter;                                                                                                         \
+        memoryTypeName value = static_cast<memoryTypeName>(readValue<valueTypeName>(sp));                                                                     \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                                                            \
+        memoryTypeName* address = state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicAddress<memoryTypeName>(offset, code->offset()); \
+        writeValue<valueTypeName>(sp, static_cast<valueTypeName>(atomicFunction(address, value, __ATOMIC_SEQ_CST)));                                          \
+        ADD_PROGRAM_COUNTER(AtomicRmw);                                                                                                                       \
+        NEXT_INSTRUCTION();                                                                                                                                   \
+    }
+
+#define ATOMIC_RMW_CMPXCHG_OPERATION(opcodeName, valueTypeName, memoryTypeName)                                                                               \
+    DEFINE_OPCODE(opcodeName)                                                                                                                                 \
+        :                                                                                                                                                     \
+    {                                                                                                                                                         \
+        AtomicRmwCmpxchg* code = (AtomicRmwCmpxchg*)programCounter;                                                                                           \
+        memoryTypeName replacement = static_cast<memoryTypeName>(readValue<valueTypeName>(sp));                                                               \
+        memoryTypeName expected = static_cast<memoryTypeName>(readValue<valueTypeName>(sp));                                                                  \
+        uint32_t offset = readValue<uint32_t>(sp);                                                                                                            \
+        memoryTypeName* address = state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicAddress<memoryTypeName>(offset, code->offset()); \
+        /* expected is overwritten by the current value when the exchange fails */                                                                            \
+        __atomic_compare_exchange_n(address, &expected, replacement, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);                                              \
+        writeValue<valueTypeName>(sp, static_cast<valueTypeName>(expected));                                                                                  \
+        ADD_PROGRAM_COUNTER(AtomicRmwCmpxchg);                                                                                                                \
+        NEXT_INSTRUCTION();                                                                                                                                   \
+    }
+
 NextInstruction:
     OpcodeKind currentOpcode = ((ByteCode*)programCounter)->opcode();
 
@@ -508,6 +662,40 @@ NextInstruction:
             NEXT_INSTRUCTION();
         }
 
+        DEFINE_OPCODE(CallIndirect)
+            :
+        {
+            uint32_t index = readValue<uint32_t>(sp);
+            callIndirectOperation(state, programCounter, index, sp);
+            ADD_PROGRAM_COUNTER(CallIndirect);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(CallIndirectConstant)
+            :
+        {
+            CallIndirectConstant* code = (CallIndirectConstant*)programCounter;
+            callIndirectOperation(state, programCounter, code->elementIndex(), sp);
+            ADD_PROGRAM_COUNTER(CallIndirectConstant);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(CallIndirectWithoutSignatureCheck)
+            :
+        {
+            callIndirectWithoutSignatureCheckOperation(state, programCounter, sp);
+            ADD_PROGRAM_COUNTER(CallIndirect);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(CallDevirtualized)
+            :
+        {
+            callDevirtualizedOperation(state, programCounter, sp);
+            ADD_PROGRAM_COUNTER(CallIndirectConstant);
+            NEXT_INSTRUCTION();
+        }
+
         DEFINE_OPCODE(BrTable)
             :
         {
@@ -571,9 +759,9 @@ NextInstruction:
             :
         {
             Memory* m = state.currentFunction()->asDefinedFunction()->instance()->memory(0);
-            auto oldSize = m->sizeInPageSize();
-            if (m->grow(readValue<int32_t>(sp) * Memory::s_memoryPageSize)) {
-                writeValue<int32_t>(sp, oldSize);
+            size_t oldSize;
+            if (m->grow(static_cast<uint64_t>(readValue<uint32_t>(sp)) * Memory::s_memoryPageSize, &oldSize)) {
+                writeValue<int32_t>(sp, oldSize / Memory::s_memoryPageSize);
             } else {
                 writeValue<int32_t>(sp, -1);
             }
@@ -581,6 +769,295 @@ NextInstruction:
             NEXT_INSTRUCTION();
         }
 
+        DEFINE_OPCODE(MemorySize64)
+            :
+        {
+            writeValue<int64_t>(sp, state.currentFunction()->asDefinedFunction()->instance()->memory(0)->sizeInPageSize());
+            ADD_PROGRAM_COUNTER(MemorySize64);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(MemoryGrow64)
+            :
+        {
+            Memory* m = state.currentFunction()->asDefinedFunction()->instance()->memory(0);
+            size_t oldSize;
+            uint64_t growSize = readValue<uint64_t>(sp);
+            if (growSize <= std::numeric_limits<uint64_t>::max() / Memory::s_memoryPageSize && m->grow(growSize * Memory::s_memoryPageSize, &oldSize)) {
+                writeValue<int64_t>(sp, oldSize / Memory::s_memoryPageSize);
+            } else {
+                writeValue<int64_t>(sp, -1);
+            }
+            ADD_PROGRAM_COUNTER(MemoryGrow64);
+            NEXT_INSTRUCTION();
+        }
+
+        MEMORY_LOAD_OPERATION(I32Load, int32_t, int32_t)
+        MEMORY_LOAD_OPERATION(I64Load, int64_t, int64_t)
+        MEMORY_LOAD_OPERATION(F32Load, float, float)
+        MEMORY_LOAD_OPERATION(F64Load, double, double)
+        MEMORY_LOAD_OPERATION(I32Load8S, int8_t, int32_t)
+        MEMORY_LOAD_OPERATION(I32Load8U, uint8_t, int32_t)
+        MEMORY_LOAD_OPERATION(I32Load16S, int16_t, int32_t)
+        MEMORY_LOAD_OPERATION(I32Load16U, uint16_t, int32_t)
+        MEMORY_LOAD_OPERATION(I64Load8S, int8_t, int64_t)
+        MEMORY_LOAD_OPERATION(I64Load8U, uint8_t, int64_t)
+        MEMORY_LOAD_OPERATION(I64Load16S, int16_t, int64_t)
+        MEMORY_LOAD_OPERATION(I64Load16U, uint16_t, int64_t)
+        MEMORY_LOAD_OPERATION(I64Load32S, int32_t, int64_t)
+        MEMORY_LOAD_OPERATION(I64Load32U, uint32_t, int64_t)
+
+        MEMORY_STORE_OPERATION(I32Store, int32_t, int32_t)
+        MEMORY_STORE_OPERATION(I64Store, int64_t, int64_t)
+        MEMORY_STORE_OPERATION(F32Store, float, float)
+        MEMORY_STORE_OPERATION(F64Store, double, double)
+        MEMORY_STORE_OPERATION(I32Store8, int32_t, int8_t)
+        MEMORY_STORE_OPERATION(I32Store16, int32_t, int16_t)
+        MEMORY_STORE_OPERATION(I64Store8, int64_t, int8_t)
+        MEMORY_STORE_OPERATION(I64Store16, int64_t, int16_t)
+        MEMORY_STORE_OPERATION(I64Store32, int64_t, int32_t)
+
+        MEMORY_LOAD_UNCHECKED_OPERATION(I32LoadUnchecked, int32_t, int32_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64LoadUnchecked, int64_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(F32LoadUnchecked, float, float)
+        MEMORY_LOAD_UNCHECKED_OPERATION(F64LoadUnchecked, double, double)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I32Load8SUnchecked, int8_t, int32_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I32Load8UUnchecked, uint8_t, int32_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I32Load16SUnchecked, int16_t, int32_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I32Load16UUnchecked, uint16_t, int32_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load8SUnchecked, int8_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load8UUnchecked, uint8_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load16SUnchecked, int16_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load16UUnchecked, uint16_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load32SUnchecked, int32_t, int64_t)
+        MEMORY_LOAD_UNCHECKED_OPERATION(I64Load32UUnchecked, uint32_t, int64_t)
+
+        MEMORY_STORE_UNCHECKED_OPERATION(I32StoreUnchecked, int32_t, int32_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(I64StoreUnchecked, int64_t, int64_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(F32StoreUnchecked, float, float)
+        MEMORY_STORE_UNCHECKED_OPERATION(F64StoreUnchecked, double, double)
+        MEMORY_STORE_UNCHECKED_OPERATION(I32Store8Unchecked, int32_t, int8_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(I32Store16Unchecked, int32_t, int16_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(I64Store8Unchecked, int64_t, int8_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(I64Store16Unchecked, int64_t, int16_t)
+        MEMORY_STORE_UNCHECKED_OPERATION(I64Store32Unchecked, int64_t, int32_t)
+
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32LoadFromLocal, int32_t, int32_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64LoadFromLocal, int64_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(F32LoadFromLocal, float, float, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(F64LoadFromLocal, double, double, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load8SFromLocal, int8_t, int32_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load8UFromLocal, uint8_t, int32_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load16SFromLocal, int16_t, int32_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load16UFromLocal, uint16_t, int32_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load8SFromLocal, int8_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load8UFromLocal, uint8_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load16SFromLocal, int16_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load16UFromLocal, uint16_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load32SFromLocal, int32_t, int64_t, load)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load32UFromLocal, uint32_t, int64_t, load)
+
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32StoreFromLocals, int32_t, int32_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64StoreFromLocals, int64_t, int64_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(F32StoreFromLocals, float, float, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(F64StoreFromLocals, double, double, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32Store8FromLocals, int32_t, int8_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32Store16FromLocals, int32_t, int16_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store8FromLocals, int64_t, int8_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store16FromLocals, int64_t, int16_t, store)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store32FromLocals, int64_t, int32_t, store)
+
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32LoadFromLocalUnchecked, int32_t, int32_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64LoadFromLocalUnchecked, int64_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(F32LoadFromLocalUnchecked, float, float, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(F64LoadFromLocalUnchecked, double, double, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load8SFromLocalUnchecked, int8_t, int32_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load8UFromLocalUnchecked, uint8_t, int32_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load16SFromLocalUnchecked, int16_t, int32_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I32Load16UFromLocalUnchecked, uint16_t, int32_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load8SFromLocalUnchecked, int8_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load8UFromLocalUnchecked, uint8_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load16SFromLocalUnchecked, int16_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load16UFromLocalUnchecked, uint16_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load32SFromLocalUnchecked, int32_t, int64_t, loadUnchecked)
+        MEMORY_LOAD_FROM_LOCAL_OPERATION(I64Load32UFromLocalUnchecked, uint32_t, int64_t, loadUnchecked)
+
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32StoreFromLocalsUnchecked, int32_t, int32_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64StoreFromLocalsUnchecked, int64_t, int64_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(F32StoreFromLocalsUnchecked, float, float, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(F64StoreFromLocalsUnchecked, double, double, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32Store8FromLocalsUnchecked, int32_t, int8_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I32Store16FromLocalsUnchecked, int32_t, int16_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store8FromLocalsUnchecked, int64_t, int8_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store16FromLocalsUnchecked, int64_t, int16_t, storeUnchecked)
+        MEMORY_STORE_FROM_LOCALS_OPERATION(I64Store32FromLocalsUnchecked, int64_t, int32_t, storeUnchecked)
+
+        MEMORY64_LOAD_OPERATION(I32LoadMemory64, int32_t, int32_t)
+        MEMORY64_LOAD_OPERATION(I64LoadMemory64, int64_t, int64_t)
+        MEMORY64_LOAD_OPERATION(F32LoadMemory64, float, float)
+        MEMORY64_LOAD_OPERATION(F64LoadMemory64, double, double)
+        MEMORY64_LOAD_OPERATION(I32Load8SMemory64, int8_t, int32_t)
+        MEMORY64_LOAD_OPERATION(I32Load8UMemory64, uint8_t, int32_t)
+        MEMORY64_LOAD_OPERATION(I32Load16SMemory64, int16_t, int32_t)
+        MEMORY64_LOAD_OPERATION(I32Load16UMemory64, uint16_t, int32_t)
+        MEMORY64_LOAD_OPERATION(I64Load8SMemory64, int8_t, int64_t)
+        MEMORY64_LOAD_OPERATION(I64Load8UMemory64, uint8_t, int64_t)
+        MEMORY64_LOAD_OPERATION(I64Load16SMemory64, int16_t, int64_t)
+        MEMORY64_LOAD_OPERATION(I64Load16UMemory64, uint16_t, int64_t)
+        MEMORY64_LOAD_OPERATION(I64Load32SMemory64, int32_t, int64_t)
+        MEMORY64_LOAD_OPERATION(I64Load32UMemory64, uint32_t, int64_t)
+
+        MEMORY64_STORE_OPERATION(I32StoreMemory64, int32_t, int32_t)
+        MEMORY64_STORE_OPERATION(I64StoreMemory64, int64_t, int64_t)
+        MEMORY64_STORE_OPERATION(F32StoreMemory64, float, float)
+        MEMORY64_STORE_OPERATION(F64StoreMemory64, double, double)
+        MEMORY64_STORE_OPERATION(I32Store8Memory64, int32_t, int8_t)
+        MEMORY64_STORE_OPERATION(I32Store16Memory64, int32_t, int16_t)
+        MEMORY64_STORE_OPERATION(I64Store8Memory64, int64_t, int8_t)
+        MEMORY64_STORE_OPERATION(I64Store16Memory64, int64_t, int16_t)
+        MEMORY64_STORE_OPERATION(I64Store32Memory64, int64_t, int32_t)
+
+        DEFINE_OPCODE(MemoryAtomicNotify)
+            :
+        {
+            MemoryAtomicNotify* code = (MemoryAtomicNotify*)programCounter;
+            uint32_t count = readValue<uint32_t>(sp);
+            uint32_t offset = readValue<uint32_t>(sp);
+            writeValue<uint32_t>(sp, state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicNotify(offset, code->offset(), count));
+            ADD_PROGRAM_COUNTER(MemoryAtomicNotify);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(MemoryAtomicWait32)
+            :
+        {
+            MemoryAtomicWait* code = (MemoryAtomicWait*)programCounter;
+            int64_t timeout = readValue<int64_t>(sp);
+            uint32_t expected = readValue<uint32_t>(sp);
+            uint32_t offset = readValue<uint32_t>(sp);
+            writeValue<uint32_t>(sp, state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicWait(offset, code->offset(), expected, timeout));
+            ADD_PROGRAM_COUNTER(MemoryAtomicWait);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(MemoryAtomicWait64)
+            :
+        {
+            MemoryAtomicWait* code = (MemoryAtomicWait*)programCounter;
+            int64_t timeout = readValue<int64_t>(sp);
+            uint64_t expected = readValue<uint64_t>(sp);
+            uint32_t offset = readValue<uint32_t>(sp);
+            writeValue<uint32_t>(sp, state.currentFunction()->asDefinedFunction()->instance()->memory(0)->atomicWait(offset, code->offset(), expected, timeout));
+            ADD_PROGRAM_COUNTER(MemoryAtomicWait);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(AtomicFence)
+            :
+        {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            ADD_PROGRAM_COUNTER(AtomicFence);
+            NEXT_INSTRUCTION();
+        }
+
+        ATOMIC_LOAD_OPERATION(I32AtomicLoad, uint32_t, int32_t)
+        ATOMIC_LOAD_OPERATION(I64AtomicLoad, uint64_t, int64_t)
+        ATOMIC_LOAD_OPERATION(I32AtomicLoad8U, uint8_t, int32_t)
+        ATOMIC_LOAD_OPERATION(I32AtomicLoad16U, uint16_t, int32_t)
+        ATOMIC_LOAD_OPERATION(I64AtomicLoad8U, uint8_t, int64_t)
+        ATOMIC_LOAD_OPERATION(I64AtomicLoad16U, uint16_t, int64_t)
+        ATOMIC_LOAD_OPERATION(I64AtomicLoad32U, uint32_t, int64_t)
+
+        ATOMIC_STORE_OPERATION(I32AtomicStore, int32_t, uint32_t)
+        ATOMIC_STORE_OPERATION(I64AtomicStore, int64_t, uint64_t)
+        ATOMIC_STORE_OPERATION(I32AtomicStore8, int32_t, uint8_t)
+        ATOMIC_STORE_OPERATION(I32AtomicStore16, int32_t, uint16_t)
+        ATOMIC_STORE_OPERATION(I64AtomicStore8, int64_t, uint8_t)
+        ATOMIC_STORE_OPERATION(I64AtomicStore16, int64_t, uint16_t)
+        ATOMIC_STORE_OPERATION(I64AtomicStore32, int64_t, uint32_t)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwAdd, int32_t, uint32_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwAdd, int64_t, uint64_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8AddU, int32_t, uint8_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16AddU, int32_t, uint16_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8AddU, int64_t, uint8_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16AddU, int64_t, uint16_t, __atomic_fetch_add)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32AddU, int64_t, uint32_t, __atomic_fetch_add)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwSub, int32_t, uint32_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwSub, int64_t, uint64_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8SubU, int32_t, uint8_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16SubU, int32_t, uint16_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8SubU, int64_t, uint8_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16SubU, int64_t, uint16_t, __atomic_fetch_sub)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32SubU, int64_t, uint32_t, __atomic_fetch_sub)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwAnd, int32_t, uint32_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwAnd, int64_t, uint64_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8AndU, int32_t, uint8_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16AndU, int32_t, uint16_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8AndU, int64_t, uint8_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16AndU, int64_t, uint16_t, __atomic_fetch_and)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32AndU, int64_t, uint32_t, __atomic_fetch_and)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwOr, int32_t, uint32_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwOr, int64_t, uint64_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8OrU, int32_t, uint8_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16OrU, int32_t, uint16_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8OrU, int64_t, uint8_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16OrU, int64_t, uint16_t, __atomic_fetch_or)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32OrU, int64_t, uint32_t, __atomic_fetch_or)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwXor, int32_t, uint32_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwXor, int64_t, uint64_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8XorU, int32_t, uint8_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16XorU, int32_t, uint16_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8XorU, int64_t, uint8_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16XorU, int64_t, uint16_t, __atomic_fetch_xor)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32XorU, int64_t, uint32_t, __atomic_fetch_xor)
+
+        ATOMIC_RMW_OPERATION(I32AtomicRmwXchg, int32_t, uint32_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I64AtomicRmwXchg, int64_t, uint64_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw8XchgU, int32_t, uint8_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I32AtomicRmw16XchgU, int32_t, uint16_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw8XchgU, int64_t, uint8_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw16XchgU, int64_t, uint16_t, __atomic_exchange_n)
+        ATOMIC_RMW_OPERATION(I64AtomicRmw32XchgU, int64_t, uint32_t, __atomic_exchange_n)
+
+        ATOMIC_RMW_CMPXCHG_OPERATION(I32AtomicRmwCmpxchg, int32_t, uint32_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I64AtomicRmwCmpxchg, int64_t, uint64_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I32AtomicRmw8CmpxchgU, int32_t, uint8_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I32AtomicRmw16CmpxchgU, int32_t, uint16_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I64AtomicRmw8CmpxchgU, int64_t, uint8_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I64AtomicRmw16CmpxchgU, int64_t, uint16_t)
+        ATOMIC_RMW_CMPXCHG_OPERATION(I64AtomicRmw32CmpxchgU, int64_t, uint32_t)
+
+        DEFINE_OPCODE(RefFunc)
+            :
+        {
+            RefFunc* code = (RefFunc*)programCounter;
+            writeValue<void*>(sp, state.currentFunction()->asDefinedFunction()->instance()->function(code->funcIndex()));
+            ADD_PROGRAM_COUNTER(RefFunc);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(RefNull)
+            :
+        {
+            writeValue<void*>(sp, nullptr);
+            ADD_PROGRAM_COUNTER(RefNull);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(RefIsNull)
+            :
+        {
+            void* ref = readValue<void*>(sp);
+            writeValue<int32_t>(sp, ref == nullptr);
+            ADD_PROGRAM_COUNTER(RefIsNull);
+            NEXT_INSTRUCTION();
+        }
+
         DEFINE_OPCODE(TableGet)
             :
         {
@@ -588,11 +1065,10 @@ NextInstruction:
             Table* table = state.currentFunction()->asDefinedFunction()->instance()->table(code->tableIndex());
             uint32_t index = readValue<uint32_t>(sp);
             if (index >= table->size()) {
-                // TODO Trap
+                Trap::throwException(new String("out of bounds table access"));
             }
 
-            Value val = table->getElement(index);
-            val.writeToStack(sp);
+            writeValue<void*>(sp, table->getElement(index));
 
             ADD_PROGRAM_COUNTER(TableGet);
             NEXT_INSTRUCTION();
@@ -604,15 +1080,14 @@ NextInstruction:
             TableSet* code = (TableSet*)programCounter;
             Table* table = state.currentFunction()->asDefinedFunction()->instance()->table(code->tableIndex());
 
-            // FIXME read reference
-            Value val(reinterpret_cast<Function*>(readValue<void*>(sp)));
+            void* ref = readValue<void*>(sp);
             uint32_t index = readValue<uint32_t>(sp);
 
             if (index >= table->size()) {
-                // TODO Trap
+                Trap::throwException(new String("out of bounds table access"));
             }
 
-            table->setElement(index, val);
+            table->setElement(index, ref);
 
             ADD_PROGRAM_COUNTER(TableSet);
             NEXT_INSTRUCTION();
@@ -626,14 +1101,13 @@ NextInstruction:
 
             size_t size = table->size();
 
-            int32_t n = readValue<int32_t>(sp);
-            size_t newSize = n + size;
+            uint32_t n = readValue<uint32_t>(sp);
+            uint64_t newSize = static_cast<uint64_t>(n) + size;
 
-            // FIXME read reference
-            Value val(reinterpret_cast<Function*>(readValue<void*>(sp)));
+            void* ref = readValue<void*>(sp);
 
             if (newSize <= table->maximumSize()) {
-                table->grow(newSize, val);
+                table->grow(newSize, ref);
                 writeValue<int32_t>(sp, size);
             } else {
                 writeValue<int32_t>(sp, -1);
@@ -656,6 +1130,31 @@ NextInstruction:
             NEXT_INSTRUCTION();
         }
 
+        DEFINE_OPCODE(TableInit)
+            :
+        {
+            TableInit* code = (TableInit*)programCounter;
+            Instance* instance = state.currentFunction()->asDefinedFunction()->instance();
+
+            uint32_t n = readValue<uint32_t>(sp);
+            uint32_t s = readValue<uint32_t>(sp);
+            uint32_t d = readValue<uint32_t>(sp);
+            instance->table(code->tableIndex())->init(instance->elementSegment(code->segmentIndex()), d, s, n);
+
+            ADD_PROGRAM_COUNTER(TableInit);
+            NEXT_INSTRUCTION();
+        }
+
+        DEFINE_OPCODE(ElemDrop)
+            :
+        {
+            ElemDrop* code = (ElemDrop*)programCounter;
+            state.currentFunction()->asDefinedFunction()->instance()->elementSegment(code->segmentIndex())->drop();
+
+            ADD_PROGRAM_COUNTER(ElemDrop);
+            NEXT_INSTRUCTION();
+        }
+
         DEFINE_OPCODE(TableCopy)
             :
         {
@@ -663,27 +1162,10 @@ NextInstruction:
             Table* dstTable = state.currentFunction()->asDefinedFunction()->instance()->table(code->dstIndex());
             Table* srcTable = state.currentFunction()->asDefinedFunction()->instance()->table(code->srcIndex());
 
-            int32_t dstSize = dstTable->size();
-            int32_t srcSize = srcTable->size();
-
-            int32_t n = readValue<int32_t>(sp);
-            int32_t s = readValue<int32_t>(sp);
-            int32_t d = readValue<int32_t>(sp);
-
-            if ((s + n > srcSize) || (d + n > dstSize)) {
-                // Trap
-            }
-
-            while (n > 0) {
-                if (d <= s) {
-                    dstTable->setElement(d, srcTable->getElement(s));
-                    d++;
-                    s++;
-                } else {
-                    dstTable->setElement(d + n - 1, srcTable->getElement(s + n - 1));
-                }
-                n--;
-            }
+            uint32_t n = readValue<uint32_t>(sp);
+            uint32_t s = readValue<uint32_t>(sp);
+            uint32_t d = readValue<uint32_t>(sp);
+            dstTable->copy(srcTable, d, s, n);
 
             ADD_PROGRAM_COUNTER(TableCopy);
             NEXT_INSTRUCTION();
@@ -695,21 +1177,10 @@ NextInstruction:
             TableFill* code = (TableFill*)programCounter;
             Table* table = state.currentFunction()->asDefinedFunction()->instance()->table(code->tableIndex());
 
-            int32_t size = table->size();
-
-            int32_t n = readValue<int32_t>(sp);
-            Value val(reinterpret_cast<Function*>(readValue<void*>(sp)));
-            int32_t i = readValue<int32_t>(sp);
-
-            if (i + n > size) {
-                // Trap
-            }
-
-            while (n > 0) {
-                table->setElement(i, val);
-                n--;
-                i++;
-            }
+            uint32_t n = readValue<uint32_t>(sp);
+            void* ref = readValue<void*>(sp);
+            uint32_t i = readValue<uint32_t>(sp);
+            table->fill(i, ref, n);
 
             ADD_PROGRAM_COUNTER(TableFill);
             NEXT_INSTRUCTION();
@@ -727,16 +1198,16 @@ NextInstruction:
     }
 }
 
-NEVER_INLINE void Interpreter::callOperation(
-    ExecutionState& state,
-    size_t programCounter,
-    uint8_t* bp,
-    uint8_t*& sp)
+static ALWAYS_INLINE void callFunction(ExecutionState& state, Function* target, FunctionType* ft, uint8_t*& sp)
 {
-    Call* code = (Call*)programCounter;
+    // host functions with a stack callback use the operand stack directly
+    if (target->isImportedFunction() && target->asImportedFunction()->hasStackCallback()) {
+        sp = sp - ft->paramStackSize();
+        target->asImportedFunction()->callWithStack(state, sp);
+        sp = sp + ft->resultStackSize();
+        return;
+    }
 
-    Function* target = state.currentFunction()->asDefinedFunction()->instance()->function(code->index());
-    FunctionType* ft = target->functionType();
     const FunctionType::FunctionTypeVector& param = ft->param();
     Value* paramVector = ALLOCA(sizeof(Value) * param.size(), Value);
 
@@ -756,4 +1227,82 @@ NEVER_INLINE void Interpreter::callOperation(
     }
 }
 
+NEVER_INLINE void Interpreter::callOperation(
+    ExecutionState& state,
+    size_t programCounter,
+    uint8_t* bp,
+    uint8_t*& sp)
+{
+    Call* code = (Call*)programCounter;
+
+    Function* target = state.currentFunction()->asDefinedFunction()->instance()->function(code->index());
+    callFunction(state, target, target->functionType(), sp);
+}
+
+NEVER_INLINE void Interpreter::callIndirectOperation(
+    ExecutionState& state,
+    size_t programCounter,
+    uint32_t index,
+    uint8_t*& sp)
+{
+    CallIndirect* code = (CallIndirect*)programCounter;
+    Instance* instance = state.currentFunction()->asDefinedFunction()->instance();
+    Table* table = instance->table(code->tableIndex());
+
+    // monomorphic call sites skip the bounds and signature checks
+    Instance::CallIndirectCache& cache = instance->callIndirectCache(code->cacheIndex());
+    Function* target = cache.m_function;
+    if (UNLIKELY(cache.m_tableVersion != table->version() || cache.m_elementIndex != index)) {
+        if (index >= table->size()) {
+            Trap::throwException(new String("undefined element"));
+        }
+        // null elements never match, so the common case is a single compare
+        if (table->signature(index) != code->functionType()->canonicalIndex()) {
+            if (!table->getElement(index)) {
+                Trap::throwException(new String("uninitialized element"));
+            }
+            Trap::throwException(new String("indirect call type mismatch"));
+        }
+        target = reinterpret_cast<Function*>(table->getElement(index));
+        cache.m_tableVersion = table->version();
+        cache.m_elementIndex = index;
+        cache.m_function = target;
+    }
+
+    callFunction(state, target, code->functionType(), sp);
+}
+
+NEVER_INLINE void Interpreter::callIndirectWithoutSignatureCheckOperation(
+    ExecutionState& state,
+    size_t programCounter,
+    uint8_t*& sp)
+{
+    CallIndirect* code = (CallIndirect*)programCounter;
+    Table* table = state.currentFunction()->asDefinedFunction()->instance()->table(code->tableIndex());
+    uint32_t index = readValue<uint32_t>(sp);
+
+    if (index >= table->size()) {
+        Trap::throwException(new String("undefined element"));
+    }
+    Function* target = reinterpret_cast<Function*>(table->getElement(index));
+    if (!target) {
+        Trap::throwException(new String("uninitialized element"));
+    }
+    ASSERT(target->functionType()->canonicalIndex() == code->functionType()->canonicalIndex());
+
+    callFunction(state, target, code->functionType(), sp);
+}
+
+NEVER_INLINE void Interpreter::callDevirtualizedOperation(
+    ExecutionState& state,
+    size_t programCounter,
+    uint8_t*& sp)
+{
+    CallIndirectConstant* code = (CallIndirectConstant*)programCounter;
+    Function* target = state.currentFunction()->asDefinedFunction()->instance()->function(code->functionIndex());
+    ASSERT(target == state.currentFunction()->asDefinedFunction()->instance()->table(code->tableIndex())->getElement(code->elementIndex()));
+
+    callFunction(state, target, code->functionType(), sp);
+}
+
 } // namespace Walrus
@@ -31,6 +31,16 @@ public:
                               size_t programCounter,
                               uint8_t* bp,
                               uint8_t*& sp);
+    static void callIndirectOperation(ExecutionState& state,
+                                      size_t programCounter,
+                                      uint32_t index,
+                                      uint8_t*& sp);
+    static void callIndirectWithoutSignatureCheckOperation(ExecutionState& state,
+                                                           size_t programCounter,
+                                                           uint8_t*& sp);
+    static void callDevirtualizedOperation(ExecutionState& state,
+                                           size_t programCounter,
+                                           uint8_t*& sp);
 };
 
 } // namespace Walrus
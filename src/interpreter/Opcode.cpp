@@ -26,6 +26,7 @@ ByteCodeInfo g_byteCodeInfo[OpcodeKind::InvalidOpcode] = {
     { name##Opcode,                                                          \
       ByteCodeInfo::rtype,                                                   \
       { ByteCodeInfo::type1, ByteCodeInfo::type2, ByteCodeInfo::type3 },     \
+      memSize,                                                               \
       text },
 #include "interpreter/opcode.def"
 #undef WABT_OPCODE
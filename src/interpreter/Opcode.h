@@ -40,6 +40,8 @@ struct ByteCodeInfo {
     OpcodeKind m_code;
     ByteCodeType m_resultType;
     ByteCodeType m_paramTypes[3];
+    // size of the accessed memory for memory operations
+    uint8_t m_memorySize;
     const char* m_name;
 
     size_t stackShrinkSize() const
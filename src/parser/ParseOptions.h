@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusParseOptions__
+#define __WalrusParseOptions__
+
+namespace Walrus {
+
+struct ParseOptions {
+    enum NameSection {
+        SkipNameSection,
+        ReadNameSection,
+        // the name section is kept, and read when a name is requested first
+        ReadNameSectionLazily,
+    };
+
+    // in the order of third_party/wabt/include/wabt/feature.def
+    enum Feature : uint32_t {
+        ExceptionsFeature = 1 << 0,
+        MutableGlobalsFeature = 1 << 1,
+        SaturatingFloatToIntFeature = 1 << 2,
+        SignExtensionFeature = 1 << 3,
+        SIMDFeature = 1 << 4,
+        ThreadsFeature = 1 << 5,
+        FunctionReferencesFeature = 1 << 6,
+        MultiValueFeature = 1 << 7,
+        TailCallFeature = 1 << 8,
+        BulkMemoryFeature = 1 << 9,
+        ReferenceTypesFeature = 1 << 10,
+        AnnotationsFeature = 1 << 11,
+        CodeMetadataFeature = 1 << 12,
+        GCFeature = 1 << 13,
+        Memory64Feature = 1 << 14,
+        MultiMemoryFeature = 1 << 15,
+        ExtendedConstFeature = 1 << 16,
+        AllFeatures = (1 << 17) - 1,
+    };
+
+    ParseOptions()
+        : m_nameSection(SkipNameSection)
+        , m_skipCustomSections(true)
+        , m_features(AllFeatures)
+        , m_isTrusted(false)
+    {
+    }
+
+    NameSection m_nameSection;
+    // skip custom sections other than the name section without reading them
+    // (e.g. DWARF or linking sections), otherwise the known ones are checked
+    bool m_skipCustomSections;
+    // Feature bits of the proposals whose instructions and types are accepted
+    uint32_t m_features;
+    // the module was validated before (e.g. at build time), so checks which
+    // only reject invalid modules are skipped
+    bool m_isTrusted;
+};
+
+} // namespace Walrus
+
+#endif // __WalrusParseOptions__
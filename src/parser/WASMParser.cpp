@@ -19,9 +19,14 @@
 #include "interpreter/ByteCode.h"
 #include "interpreter/Opcode.h"
 #include "runtime/Module.h"
+#include "runtime/Store.h"
+#include "runtime/GCThreadScope.h"
 
 #include "wabt/walrus/binary-reader-walrus.h"
 
+#include <atomic>
+#include <thread>
+
 namespace wabt {
 
 static Walrus::Value::Type toValueKindForFunctionType(Type type)
@@ -69,7 +74,8 @@ public:
         BlockType m_blockType;
         Type m_returnValueType;
         size_t m_position;
-        size_t m_stackPushCount;
+        // m_functionStackSizeSoFar when the block begins
+        size_t m_stackPushSize;
 
         static_assert(sizeof(Walrus::JumpIfTrue) == sizeof(Walrus::JumpIfFalse), "");
         struct JumpToEndBrInfo {
@@ -83,17 +89,40 @@ public:
             : m_blockType(type)
             , m_returnValueType(returnValueType)
             , m_position(0)
-            , m_stackPushCount(0)
+            , m_stackPushSize(0)
         {
         }
     };
 
-    WASMBinaryReader(Walrus::Module* module)
+    struct LocalGetInfo {
+        size_t m_position;
+        uint32_t m_localOffset;
+        uint32_t m_size;
+    };
+
+    struct LocalInfo {
+        uint32_t m_offset;
+        uint32_t m_size;
+    };
+
+    struct CallIndirectSite {
+        Walrus::ModuleFunction* m_function;
+        size_t m_position;
+        Index m_tableIndex;
+        bool m_isConstantIndex;
+    };
+
+    static constexpr size_t s_invalidByteCodePosition = std::numeric_limits<size_t>::max();
+
+    WASMBinaryReader(Walrus::Module* module, bool hasSkippedFunctionBodies = false)
         : m_module(module)
+        , m_hasSkippedFunctionBodies(hasSkippedFunctionBodies)
         , m_currentFunction(nullptr)
         , m_currentFunctionType(nullptr)
+        , m_constExpression(nullptr)
         , m_functionStackSizeSoFar(0)
     {
+        resetFoldingInfo();
     }
 
     virtual void BeginModule(uint32_t version) override
@@ -101,11 +130,35 @@ public:
         m_module->m_version = version;
     }
 
-    virtual void EndModule() override {}
+    virtual void EndModule() override
+    {
+        if (!m_hasSkippedFunctionBodies) {
+            endModuleWithFunctionBodies();
+        }
+    }
+
+    // collect what readers of skipped function bodies found
+    void mergeFunctionBodyReader(const WASMBinaryReader& reader)
+    {
+        m_callIndirectSite.insert(m_callIndirectSite.end(), reader.m_callIndirectSite.begin(), reader.m_callIndirectSite.end());
+        m_callEdge.insert(m_callEdge.end(), reader.m_callEdge.begin(), reader.m_callEdge.end());
+        for (size_t i = 0; i < reader.m_mutableTable.size(); i++) {
+            if (reader.m_mutableTable[i]) {
+                markTableAsMutable(i);
+            }
+        }
+    }
+
+    // called once every function body is read
+    void endModuleWithFunctionBodies()
+    {
+        devirtualizeCallIndirect();
+        buildByteCodeArena();
+    }
 
     virtual void OnTypeCount(Index count) override
     {
-        // TODO reserve vector if possible
+        m_module->m_functionType.reserve(count);
     }
 
     virtual void OnFuncType(Index index,
@@ -123,8 +176,10 @@ public:
         for (size_t i = 0; i < resultCount; i++) {
             result.push_back(toValueKindForFunctionType(resultTypes[i]));
         }
-        m_module->m_functionType.push_back(
-            new Walrus::FunctionType(index, std::move(param), std::move(result)));
+        ASSERT(index == m_module->m_functionType.size());
+        auto functionType = new Walrus::FunctionType(index, std::move(param), std::move(result));
+        m_module->m_store->internFunctionType(functionType);
+        m_module->m_functionType.push_back(functionType);
     }
 
     virtual void OnImportCount(Index count) override
@@ -133,35 +188,41 @@ public:
     }
 
     virtual void OnImportFunc(Index importIndex,
-                              std::string moduleName,
-                              std::string fieldName,
+                              const char* moduleName,
+                              size_t moduleNameLength,
+                              const char* fieldName,
+                              size_t fieldNameLength,
                               Index funcIndex,
                               Index sigIndex) override
     {
+        ASSERT(funcIndex == m_module->m_function.size());
         m_module->m_function.push_back(
             new Walrus::ModuleFunction(m_module, funcIndex, sigIndex));
         m_module->m_import.push_back(new Walrus::ModuleImport(
-            importIndex, new Walrus::String(moduleName),
-            new Walrus::String(fieldName), funcIndex, sigIndex));
+            importIndex, m_module->m_store->internString(moduleName, moduleNameLength),
+            m_module->m_store->internString(fieldName, fieldNameLength), funcIndex, sigIndex));
     }
 
-    virtual void OnImportGlobal(Index importIndex, std::string moduleName, std::string fieldName, Index globalIndex, Type type, bool mutable_) override
+    virtual void OnImportGlobal(Index importIndex, const char* moduleName, size_t moduleNameLength, const char* fieldName, size_t fieldNameLength, Index globalIndex, Type type, bool mutable_) override
     {
         ASSERT(m_module->m_global.size() == globalIndex);
         m_module->m_global.pushBack(std::make_tuple(toValueKindForLocalType(type), mutable_));
         m_module->m_import.push_back(new Walrus::ModuleImport(
-            importIndex, new Walrus::String(moduleName),
-            new Walrus::String(fieldName), globalIndex));
+            importIndex, m_module->m_store->internString(moduleName, moduleNameLength),
+            m_module->m_store->internString(fieldName, fieldNameLength), globalIndex));
     }
 
     virtual void OnExportCount(Index count) override
     {
-        m_module->m_export.reserve(count);
+        m_module->reserveExport(count);
     }
 
-    virtual void OnExport(int kind, Index exportIndex, std::string name, Index itemIndex) override
+    virtual void OnExport(int kind, Index exportIndex, const char* name, size_t nameLength, Index itemIndex) override
     {
-        m_module->m_export.pushBack(new Walrus::ModuleExport(static_cast<Walrus::ModuleExport::Type>(kind), new Walrus::String(name), exportIndex, itemIndex));
+        if (kind == Walrus::ModuleExport::Table) {
+            markTableAsMutable(itemIndex);
+        }
+        m_module->appendExport(new Walrus::ModuleExport(static_cast<Walrus::ModuleExport::Type>(kind), m_module->m_store->internString(name, nameLength), exportIndex, itemIndex));
     }
 
     /* Table section */
@@ -183,72 +244,58 @@ public:
         m_module->m_memory.reserve(count);
     }
 
-    virtual void OnMemory(Index index, size_t initialSize, size_t maximumSize) override
+    virtual void OnMemory(Index index, uint64_t initialSize, uint64_t maximumSize, bool is64, bool isShared) override
     {
         ASSERT(index == m_module->m_memory.size());
-        m_module->m_memory.pushBack(std::make_pair(initialSize, maximumSize));
+        m_module->m_memory.pushBack(std::make_tuple(initialSize, maximumSize, is64, isShared));
     }
 
     /* Function section */
     virtual void OnFunctionCount(Index count) override
     {
-        m_module->m_function.reserve(count);
+        m_module->m_function.reserve(m_module->m_function.size() + count);
     }
 
     virtual void OnFunction(Index index, Index sigIndex) override
     {
         ASSERT(m_currentFunction == nullptr);
         ASSERT(m_currentFunctionType == nullptr);
+        ASSERT(index == m_module->m_function.size());
         m_module->m_function.push_back(new Walrus::ModuleFunction(m_module, index, sigIndex));
     }
 
     virtual void OnGlobalCount(Index count) override
     {
-        m_module->m_global.reserve(count);
-        m_module->m_globalInitBlock = new Walrus::ModuleFunction(m_module,
-                                                                 std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max());
+        m_module->m_global.reserve(m_module->m_global.size() + count);
+        m_module->m_globalInit.reserve(m_module->m_global.size() + count);
     }
 
     virtual void BeginGlobal(Index index, Type type, bool mutable_) override
     {
         ASSERT(m_module->m_global.size() == index);
         m_module->m_global.pushBack(std::make_tuple(toValueKindForLocalType(type), mutable_));
-        m_currentFunction = m_module->m_globalInitBlock.value();
     }
 
     virtual void BeginGlobalInitExpr(Index index) override
     {
+        beginConstExpression();
     }
 
     virtual void EndGlobalInitExpr(Index index) override
     {
-        ASSERT(m_currentFunction->peekByteCode<Walrus::End>(
-                                    m_currentFunction->currentByteCodeSize() - sizeof(Walrus::End))
-                   ->opcode()
-               == Walrus::OpcodeKind::EndOpcode);
-
-        m_currentFunction->shrinkByteCode(sizeof(Walrus::End));
-
-        auto sz = Walrus::valueSizeInStack(std::get<0>(m_module->m_global[index]));
-        if (sz == 4) {
-            ASSERT(peekVMStack() == 4);
-            m_currentFunction->pushByteCode(Walrus::GlobalSet4(index));
-        } else {
-            ASSERT(sz == 8);
-            ASSERT(peekVMStack() == 8);
-            m_currentFunction->pushByteCode(Walrus::GlobalSet8(index));
+        // imported globals have no initializer
+        if (m_module->m_globalInit.size() < index) {
+            m_module->m_globalInit.resize(index, nullptr);
         }
-        popVMStack();
+        m_module->m_globalInit.pushBack(endConstExpression());
     }
 
     virtual void EndGlobal(Index index) override
     {
-        m_currentFunction = nullptr;
     }
 
     virtual void EndGlobalSection() override
     {
-        m_module->m_globalInitBlock->pushByteCode(Walrus::End());
     }
 
     virtual void OnStartFunction(Index funcIndex) override
@@ -257,6 +304,88 @@ public:
         m_module->m_start = funcIndex;
     }
 
+    /* Elem section */
+    virtual void OnElemSegmentCount(Index count) override
+    {
+        m_module->m_element.reserve(count);
+    }
+
+    virtual void BeginElemSegment(Index index, Index tableIndex, bool isPassive, bool isDeclared) override
+    {
+        ASSERT(index == m_module->m_element.size());
+        Walrus::ModuleElement::Mode mode = Walrus::ModuleElement::Active;
+        if (isDeclared) {
+            mode = Walrus::ModuleElement::Declarative;
+        } else if (isPassive) {
+            mode = Walrus::ModuleElement::Passive;
+        }
+        m_module->m_element.pushBack(new Walrus::ModuleElement(mode, tableIndex));
+    }
+
+    virtual void BeginElemSegmentInitExpr(Index index) override
+    {
+        beginConstExpression();
+    }
+
+    virtual void EndElemSegmentInitExpr(Index index) override
+    {
+        Walrus::ConstExpression* offset = endConstExpression();
+        m_module->m_element[index]->m_offset = offset;
+
+        // remember i32.const offsets for devirtualizeCallIndirect
+        if (offset->isI32Const()) {
+            if (m_elementConstantOffset.size() <= index) {
+                m_elementConstantOffset.resize(index + 1, kInvalidIndex);
+            }
+            m_elementConstantOffset[index] = static_cast<uint32_t>(offset->instruction()[0].m_operand);
+        }
+    }
+
+    virtual void OnElemSegmentElemExprCount(Index index, Index count) override
+    {
+        m_module->m_element[index]->m_functionIndex.reserve(count);
+        m_module->m_element[index]->m_signature.reserve(count);
+    }
+
+    virtual void OnElemSegmentElemExpr_RefNull(Index segmentIndex, Type type) override
+    {
+        m_module->m_element[segmentIndex]->m_functionIndex.pushBack(Walrus::ModuleElement::s_nullFunctionIndex);
+        m_module->m_element[segmentIndex]->m_signature.pushBack(Walrus::FunctionType::s_invalidCanonicalIndex);
+    }
+
+    virtual void OnElemSegmentElemExpr_RefFunc(Index segmentIndex, Index funcIndex) override
+    {
+        auto functionType = m_module->functionType(m_module->function(funcIndex)->functionTypeIndex());
+        m_module->m_element[segmentIndex]->m_functionIndex.pushBack(funcIndex);
+        m_module->m_element[segmentIndex]->m_signature.pushBack(functionType->canonicalIndex());
+    }
+
+    virtual void EndElemSegment(Index index) override
+    {
+    }
+
+    virtual void OnCustomSection(std::string name, const uint8_t* data, size_t size) override
+    {
+        if (name == "name" && m_module->m_parseOptions.m_nameSection == Walrus::ParseOptions::ReadNameSectionLazily) {
+            m_module->m_nameSection.resizeWithUninitializedValues(size);
+            memcpy(m_module->m_nameSection.data(), data, size);
+            m_module->m_hasUnreadNameSection.store(size != 0, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void OnModuleName(std::string name) override
+    {
+        m_module->m_name = new Walrus::String(name);
+    }
+
+    virtual void OnFunctionName(Index index, std::string name) override
+    {
+        if (m_module->m_functionName.size() <= index) {
+            m_module->m_functionName.resize(m_module->m_function.size(), nullptr);
+        }
+        m_module->m_functionName[index] = new Walrus::String(name);
+    }
+
     virtual void BeginFunctionBody(Index index, Offset size) override
     {
         ASSERT(m_currentFunction == nullptr);
@@ -264,6 +393,17 @@ public:
         m_currentFunction = m_module->function(index);
         m_currentFunctionType = m_module->functionType(m_currentFunction->functionTypeIndex());
         m_functionStackSizeSoFar = m_currentFunctionType->paramStackSize();
+        resetFoldingInfo();
+        m_byteCodeBuffer.clear();
+
+        m_localInfo.clear();
+        m_localInfo.reserve(m_currentFunctionType->param().size());
+        uint32_t offset = 0;
+        for (size_t i = 0; i < m_currentFunctionType->param().size(); i++) {
+            uint32_t size = Walrus::valueSizeInStack(m_currentFunctionType->param()[i]);
+            m_localInfo.push_back({ offset, size });
+            offset += size;
+        }
     }
 
     virtual void OnLocalDeclCount(Index count) override
@@ -277,6 +417,7 @@ public:
             auto wType = toValueKindForLocalType(type);
             m_currentFunction->m_local.pushBack(wType);
             auto sz = Walrus::valueSizeInStack(wType);
+            m_localInfo.push_back({ m_functionStackSizeSoFar, static_cast<uint32_t>(sz) });
             m_functionStackSizeSoFar += sz;
             m_currentFunction->m_requiredStackSizeDueToLocal += sz;
             count--;
@@ -285,6 +426,10 @@ public:
 
     virtual void OnOpcode(uint32_t opcode) override
     {
+        // every instruction is passed here before its own callback, which expects a function body
+        if (UNLIKELY(m_constExpression != nullptr) && !isConstExpressionOpcode(static_cast<Walrus::OpcodeKind>(opcode))) {
+            setError();
+        }
     }
 
     virtual void OnCallExpr(uint32_t index) override
@@ -298,7 +443,37 @@ public:
             ASSERT(peekVMStack() == Walrus::valueSizeInStack(functionType->param()[functionType->param().size() - i - 1]));
             popVMStack();
         }
-        m_currentFunction->pushByteCode(Walrus::Call(index));
+        m_callEdge.push_back({ m_currentFunction->functionIndex(), index });
+        pushByteCode(Walrus::Call(index));
+        for (size_t i = 0; i < functionType->result().size(); i++) {
+            pushVMStack(Walrus::valueSizeInStack(functionType->result()[i]));
+        }
+    }
+
+    virtual void OnCallIndirectExpr(Index sigIndex, Index tableIndex) override
+    {
+        auto functionType = m_module->functionType(sigIndex);
+
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::I32));
+        popVMStack();
+        for (size_t i = 0; i < functionType->param().size(); i++) {
+            ASSERT(peekVMStack() == Walrus::valueSizeInStack(functionType->param()[functionType->param().size() - i - 1]));
+            popVMStack();
+        }
+
+        if (m_lastI32ConstPosition != s_invalidByteCodePosition
+            && m_lastI32ConstPosition + sizeof(Walrus::I32Const) == currentByteCodeSize()) {
+            uint32_t elementIndex = peekByteCode<Walrus::I32Const>(m_lastI32ConstPosition)->value();
+            shrinkByteCode(sizeof(Walrus::I32Const));
+            m_lastI32ConstPosition = s_invalidByteCodePosition;
+            m_callIndirectSite.push_back({ m_currentFunction, currentByteCodeSize(), tableIndex, true });
+            m_currentFunction->m_callIndirectPosition.pushBack(currentByteCodeSize());
+            pushByteCode(Walrus::CallIndirectConstant(tableIndex, functionType, m_module->newCallIndirectCacheIndex(), elementIndex));
+        } else {
+            m_callIndirectSite.push_back({ m_currentFunction, currentByteCodeSize(), tableIndex, false });
+            m_currentFunction->m_callIndirectPosition.pushBack(currentByteCodeSize());
+            pushByteCode(Walrus::CallIndirect(tableIndex, functionType, m_module->newCallIndirectCacheIndex()));
+        }
         for (size_t i = 0; i < functionType->result().size(); i++) {
             pushVMStack(Walrus::valueSizeInStack(functionType->result()[i]));
         }
@@ -306,97 +481,112 @@ public:
 
     virtual void OnI32ConstExpr(uint32_t value) override
     {
-        m_currentFunction->pushByteCode(Walrus::I32Const(value));
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::I32Const, value);
+            return;
+        }
+        m_lastI32ConstPosition = currentByteCodeSize();
+        pushByteCode(Walrus::I32Const(value));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
     }
 
     virtual void OnI64ConstExpr(uint64_t value) override
     {
-        m_currentFunction->pushByteCode(Walrus::I64Const(value));
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::I64Const, value);
+            return;
+        }
+        pushByteCode(Walrus::I64Const(value));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I64));
     }
 
     virtual void OnF32ConstExpr(uint32_t value) override
     {
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::F32Const, value);
+            return;
+        }
         float* f = reinterpret_cast<float*>(&value);
-        m_currentFunction->pushByteCode(Walrus::F32Const(*f));
+        pushByteCode(Walrus::F32Const(*f));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::F32));
     }
 
     virtual void OnF64ConstExpr(uint64_t value) override
     {
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::F64Const, value);
+            return;
+        }
         double* f = reinterpret_cast<double*>(&value);
-        m_currentFunction->pushByteCode(Walrus::F64Const(*f));
+        pushByteCode(Walrus::F64Const(*f));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::F64));
     }
 
     std::pair<uint32_t, uint32_t> resolveLocalOffsetAndSize(Index localIndex)
     {
-        if (localIndex < m_currentFunctionType->param().size()) {
-            size_t offset = 0;
-            for (Index i = 0; i < localIndex; i++) {
-                offset += Walrus::valueSizeInStack(m_currentFunctionType->param()[i]);
-            }
-            return std::make_pair(offset, Walrus::valueSizeInStack(m_currentFunctionType->param()[localIndex]));
-        } else {
-            localIndex -= m_currentFunctionType->param().size();
-            size_t offset = m_currentFunctionType->paramStackSize();
-            for (Index i = 0; i < localIndex; i++) {
-                offset += Walrus::valueSizeInStack(m_currentFunction->m_local[i]);
-            }
-            return std::make_pair(offset, Walrus::valueSizeInStack(m_currentFunction->m_local[localIndex]));
-        }
+        ASSERT(localIndex < m_localInfo.size());
+        return std::make_pair(m_localInfo[localIndex].m_offset, m_localInfo[localIndex].m_size);
     }
 
     virtual void OnLocalGetExpr(Index localIndex) override
     {
         auto r = resolveLocalOffsetAndSize(localIndex);
+        m_previousLocalGet = m_lastLocalGet;
+        m_lastLocalGet = { currentByteCodeSize(), r.first, r.second };
         if (r.second == 4) {
-            m_currentFunction->pushByteCode(Walrus::LocalGet4(r.first));
+            pushByteCode(Walrus::LocalGet4(r.first));
         } else if (r.second == 8) {
-            m_currentFunction->pushByteCode(Walrus::LocalGet8(r.first));
+            pushByteCode(Walrus::LocalGet8(r.first));
         } else {
             RELEASE_ASSERT_NOT_REACHED();
         }
 
         pushVMStack(r.second);
+        m_vmStackLocalIndex.back() = localIndex;
     }
 
     virtual void OnLocalSetExpr(Index localIndex) override
     {
         auto r = resolveLocalOffsetAndSize(localIndex);
         if (r.second == 4) {
-            m_currentFunction->pushByteCode(Walrus::LocalSet4(r.first));
+            pushByteCode(Walrus::LocalSet4(r.first));
         } else if (r.second == 8) {
-            m_currentFunction->pushByteCode(Walrus::LocalSet8(r.first));
+            pushByteCode(Walrus::LocalSet8(r.first));
         } else {
             RELEASE_ASSERT_NOT_REACHED();
         }
         ASSERT(r.second == peekVMStack());
         popVMStack();
+        invalidateCheckedMemoryAccess(localIndex);
     }
 
     virtual void OnLocalTeeExpr(Index localIndex) override
     {
         auto r = resolveLocalOffsetAndSize(localIndex);
         if (r.second == 4) {
-            m_currentFunction->pushByteCode(Walrus::LocalTee4(r.first));
+            pushByteCode(Walrus::LocalTee4(r.first));
         } else if (r.second == 8) {
-            m_currentFunction->pushByteCode(Walrus::LocalTee8(r.first));
+            pushByteCode(Walrus::LocalTee8(r.first));
         } else {
             RELEASE_ASSERT_NOT_REACHED();
         }
+        invalidateCheckedMemoryAccess(localIndex);
+        m_vmStackLocalIndex.back() = localIndex;
     }
 
     virtual void OnGlobalGetExpr(Index index) override
     {
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::GlobalGet, index);
+            return;
+        }
         auto sz = Walrus::valueSizeInStack(std::get<0>(m_module->m_global[index]));
         pushVMStack(sz);
         if (sz == 4) {
-            m_currentFunction->pushByteCode(Walrus::GlobalGet4(index));
+            pushByteCode(Walrus::GlobalGet4(index));
         } else {
             ASSERT(sz == 8);
-            m_currentFunction->pushByteCode(Walrus::GlobalGet8(index));
+            pushByteCode(Walrus::GlobalGet8(index));
         }
     }
 
@@ -405,29 +595,33 @@ public:
         auto sz = Walrus::valueSizeInStack(std::get<0>(m_module->m_global[index]));
         if (sz == 4) {
             ASSERT(peekVMStack() == 4);
-            m_currentFunction->pushByteCode(Walrus::GlobalSet4(index));
+            pushByteCode(Walrus::GlobalSet4(index));
         } else {
             ASSERT(sz == 8);
             ASSERT(peekVMStack() == 8);
-            m_currentFunction->pushByteCode(Walrus::GlobalSet8(index));
+            pushByteCode(Walrus::GlobalSet8(index));
         }
         popVMStack();
     }
 
     virtual void OnDropExpr() override
     {
-        m_currentFunction->pushByteCode(Walrus::Drop(popVMStack()));
+        pushByteCode(Walrus::Drop(popVMStack()));
     }
 
     virtual void OnBinaryExpr(uint32_t opcode) override
     {
         auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        if (m_constExpression) {
+            appendConstExpression(constExpressionOpcode(code));
+            return;
+        }
         ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_paramTypes[0]) == peekVMStack());
         popVMStack();
         ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_paramTypes[1]) == peekVMStack());
         popVMStack();
         pushVMStack(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_resultType));
-        m_currentFunction->pushByteCode(Walrus::BinaryOperation(code));
+        pushByteCode(Walrus::BinaryOperation(code));
     }
 
     virtual void OnUnaryExpr(uint32_t opcode) override
@@ -437,7 +631,7 @@ public:
         popVMStack();
         pushVMStack(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_resultType));
 
-        m_currentFunction->pushByteCode(Walrus::UnaryOperation(code));
+        pushByteCode(Walrus::UnaryOperation(code));
     }
 
     virtual void OnIfExpr(Type sigType) override
@@ -446,41 +640,45 @@ public:
         popVMStack();
 
         BlockInfo b(BlockInfo::IfElse, sigType);
-        b.m_position = m_currentFunction->currentByteCodeSize();
+        b.m_position = currentByteCodeSize();
         b.m_jumpToEndBrInfo.push_back({ true, b.m_position });
-        b.m_stackPushCount = m_vmStack.size();
+        b.m_stackPushSize = m_functionStackSizeSoFar;
         m_blockInfo.push_back(b);
-        m_currentFunction->pushByteCode(Walrus::JumpIfFalse());
+        pushByteCode(Walrus::JumpIfFalse());
     }
 
     virtual void OnElseExpr() override
     {
+        m_checkedMemoryAccessEnd.clear();
+        resetFoldingInfo();
         BlockInfo& blockInfo = m_blockInfo.back();
         blockInfo.m_jumpToEndBrInfo.erase(blockInfo.m_jumpToEndBrInfo.begin());
-        blockInfo.m_jumpToEndBrInfo.push_back({ false, m_currentFunction->currentByteCodeSize() });
-        m_currentFunction->pushByteCode(Walrus::Jump());
+        blockInfo.m_jumpToEndBrInfo.push_back({ false, currentByteCodeSize() });
+        pushByteCode(Walrus::Jump());
         ASSERT(blockInfo.m_blockType == BlockInfo::IfElse);
         if (blockInfo.m_returnValueType != Type::Void) {
             ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(blockInfo.m_returnValueType)));
             popVMStack();
         }
-        m_currentFunction->peekByteCode<Walrus::JumpIfFalse>(blockInfo.m_position)
-            ->setOffset(m_currentFunction->currentByteCodeSize() - blockInfo.m_position);
+        peekByteCode<Walrus::JumpIfFalse>(blockInfo.m_position)
+            ->setOffset(currentByteCodeSize() - blockInfo.m_position);
     }
 
     virtual void OnLoopExpr(Type sigType) override
     {
+        m_checkedMemoryAccessEnd.clear();
+        resetFoldingInfo();
         BlockInfo b(BlockInfo::Loop, sigType);
-        b.m_position = m_currentFunction->currentByteCodeSize();
-        b.m_stackPushCount = m_vmStack.size();
+        b.m_position = currentByteCodeSize();
+        b.m_stackPushSize = m_functionStackSizeSoFar;
         m_blockInfo.push_back(b);
     }
 
     virtual void OnBlockExpr(Type sigType) override
     {
         BlockInfo b(BlockInfo::Block, sigType);
-        b.m_position = m_currentFunction->currentByteCodeSize();
-        b.m_stackPushCount = m_vmStack.size();
+        b.m_position = currentByteCodeSize();
+        b.m_stackPushSize = m_functionStackSizeSoFar;
         m_blockInfo.push_back(b);
     }
 
@@ -501,19 +699,15 @@ public:
         if (depth < m_blockInfo.size()) {
             auto iter = m_blockInfo.rbegin() + depth;
 
-            size_t start = iter->m_stackPushCount;
-            for (size_t i = start; i < m_vmStack.size(); i++) {
-                dropValueSize += m_vmStack[i];
-            }
+            ASSERT(m_functionStackSizeSoFar >= iter->m_stackPushSize);
+            dropValueSize = m_functionStackSizeSoFar - iter->m_stackPushSize;
             if (iter->m_returnValueType != Type::Void && iter->m_blockType != BlockInfo::Loop) {
                 dropValueSize -= Walrus::valueSizeInStack(toValueKindForLocalType(iter->m_returnValueType));
             }
         } else if (m_blockInfo.size()) {
             auto iter = m_blockInfo.begin();
-            size_t start = iter->m_stackPushCount;
-            for (size_t i = start; i < m_vmStack.size(); i++) {
-                dropValueSize += m_vmStack[i];
-            }
+            ASSERT(m_functionStackSizeSoFar >= iter->m_stackPushSize);
+            dropValueSize = m_functionStackSizeSoFar - iter->m_stackPushSize;
         }
         return dropValueSize;
     }
@@ -523,7 +717,7 @@ public:
         for (size_t i = 0; i < m_currentFunctionType->result().size(); i++) {
             ASSERT(*(m_vmStack.rbegin() + i) == Walrus::valueSizeInStack(m_currentFunctionType->result()[m_currentFunctionType->result().size() - i - 1]));
         }
-        m_currentFunction->pushByteCode(Walrus::End());
+        pushByteCode(Walrus::End());
         if (shouldClearVMStack) {
             auto dropSize = dropStackValuesBeforeBrIfNeeds(m_blockInfo.size());
             while (dropSize) {
@@ -549,15 +743,15 @@ public:
             return;
         }
         auto& blockInfo = findBlockInfoInBr(depth);
-        auto offset = (int32_t)blockInfo.m_position - (int32_t)m_currentFunction->currentByteCodeSize();
+        auto offset = (int32_t)blockInfo.m_position - (int32_t)currentByteCodeSize();
         auto dropSize = dropStackValuesBeforeBrIfNeeds(depth);
         if (dropSize) {
-            m_currentFunction->pushByteCode(Walrus::Drop(dropSize));
+            pushByteCode(Walrus::Drop(dropSize));
         }
         if (blockInfo.m_blockType == BlockInfo::Block) {
-            blockInfo.m_jumpToEndBrInfo.push_back({ false, m_currentFunction->currentByteCodeSize() });
+            blockInfo.m_jumpToEndBrInfo.push_back({ false, currentByteCodeSize() });
         }
-        m_currentFunction->pushByteCode(Walrus::Jump(offset));
+        pushByteCode(Walrus::Jump(offset));
     }
 
     virtual void OnBrIfExpr(Index depth) override
@@ -565,9 +759,9 @@ public:
         if (m_blockInfo.size() == depth) {
             // this case acts like return
             ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
-            size_t pos = m_currentFunction->currentByteCodeSize();
-            m_currentFunction->pushByteCode(Walrus::JumpIfFalse(sizeof(Walrus::JumpIfFalse) + sizeof(Walrus::End)));
-            m_currentFunction->pushByteCode(Walrus::End());
+            size_t pos = currentByteCodeSize();
+            pushByteCode(Walrus::JumpIfFalse(sizeof(Walrus::JumpIfFalse) + sizeof(Walrus::End)));
+            pushByteCode(Walrus::End());
             for (size_t i = 0; i < m_currentFunctionType->result().size(); i++) {
                 ASSERT(*(m_vmStack.rbegin() + i) == Walrus::valueSizeInStack(m_currentFunctionType->result()[m_currentFunctionType->result().size() - i - 1]));
             }
@@ -581,22 +775,22 @@ public:
         auto& blockInfo = findBlockInfoInBr(depth);
         auto dropSize = dropStackValuesBeforeBrIfNeeds(depth);
         if (dropSize) {
-            size_t pos = m_currentFunction->currentByteCodeSize();
-            m_currentFunction->pushByteCode(Walrus::JumpIfFalse());
-            m_currentFunction->pushByteCode(Walrus::Drop(dropSize));
-            auto offset = (int32_t)blockInfo.m_position - (int32_t)m_currentFunction->currentByteCodeSize();
+            size_t pos = currentByteCodeSize();
+            pushByteCode(Walrus::JumpIfFalse());
+            pushByteCode(Walrus::Drop(dropSize));
+            auto offset = (int32_t)blockInfo.m_position - (int32_t)currentByteCodeSize();
             if (blockInfo.m_blockType == BlockInfo::Block) {
-                blockInfo.m_jumpToEndBrInfo.push_back({ false, m_currentFunction->currentByteCodeSize() });
+                blockInfo.m_jumpToEndBrInfo.push_back({ false, currentByteCodeSize() });
             }
-            m_currentFunction->pushByteCode(Walrus::Jump(offset));
-            m_currentFunction->peekByteCode<Walrus::JumpIfFalse>(pos)
-                ->setOffset(m_currentFunction->currentByteCodeSize() - pos);
+            pushByteCode(Walrus::Jump(offset));
+            peekByteCode<Walrus::JumpIfFalse>(pos)
+                ->setOffset(currentByteCodeSize() - pos);
         } else {
-            auto offset = (int32_t)blockInfo.m_position - (int32_t)m_currentFunction->currentByteCodeSize();
+            auto offset = (int32_t)blockInfo.m_position - (int32_t)currentByteCodeSize();
             if (blockInfo.m_blockType == BlockInfo::Block) {
-                blockInfo.m_jumpToEndBrInfo.push_back({ true, m_currentFunction->currentByteCodeSize() });
+                blockInfo.m_jumpToEndBrInfo.push_back({ true, currentByteCodeSize() });
             }
-            m_currentFunction->pushByteCode(Walrus::JumpIfTrue(offset));
+            pushByteCode(Walrus::JumpIfTrue(offset));
         }
     }
 
@@ -605,27 +799,27 @@ public:
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
 
-        size_t brTableCode = m_currentFunction->currentByteCodeSize();
-        m_currentFunction->pushByteCode(Walrus::BrTable(numTargets));
+        size_t brTableCode = currentByteCodeSize();
+        pushByteCode(Walrus::BrTable(numTargets));
 
         if (numTargets) {
-            m_currentFunction->expandByteCode(sizeof(int32_t) * numTargets);
+            expandByteCode(sizeof(int32_t) * numTargets);
             std::vector<size_t> offsets;
 
             for (Index i = 0; i < numTargets; i++) {
-                offsets.push_back(m_currentFunction->currentByteCodeSize() - brTableCode);
+                offsets.push_back(currentByteCodeSize() - brTableCode);
                 OnBrExpr(targetDepths[i]);
             }
 
             for (Index i = 0; i < numTargets; i++) {
-                m_currentFunction->peekByteCode<Walrus::BrTable>(brTableCode)->jumpOffsets()[i] = offsets[i];
+                peekByteCode<Walrus::BrTable>(brTableCode)->jumpOffsets()[i] = offsets[i];
             }
         }
 
         // generate default
-        size_t pos = m_currentFunction->currentByteCodeSize();
+        size_t pos = currentByteCodeSize();
         OnBrExpr(defaultTargetDepth);
-        m_currentFunction->peekByteCode<Walrus::BrTable>(brTableCode)->setDefaultOffset(pos - brTableCode);
+        peekByteCode<Walrus::BrTable>(brTableCode)->setDefaultOffset(pos - brTableCode);
     }
 
     virtual void OnSelectExpr(Index resultCount, Type* resultTypes) override
@@ -639,75 +833,535 @@ public:
         size_t size = popVMStack();
         popVMStack();
 
-        m_currentFunction->pushByteCode(Walrus::Select(size));
+        pushByteCode(Walrus::Select(size));
         pushVMStack(size);
     }
 
+    bool isMemory64(Index memidx)
+    {
+        return std::get<2>(m_module->m_memory[memidx]);
+    }
+
     virtual void OnMemoryGrowExpr(Index memidx) override
     {
+        if (isMemory64(memidx)) {
+            ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I64)));
+            popVMStack();
+            pushByteCode(Walrus::MemoryGrow64(memidx));
+            pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I64));
+            return;
+        }
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
-        m_currentFunction->pushByteCode(Walrus::MemoryGrow(memidx));
+        pushByteCode(Walrus::MemoryGrow(memidx));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
     }
 
     virtual void OnMemorySizeExpr(Index memidx) override
     {
-        m_currentFunction->pushByteCode(Walrus::MemorySize(memidx));
+        if (isMemory64(memidx)) {
+            pushByteCode(Walrus::MemorySize64(memidx));
+            pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I64));
+            return;
+        }
+        pushByteCode(Walrus::MemorySize(memidx));
+        pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
+    }
+
+    // local.get bytecodes can be folded into a following memory access, unless a
+    // jump target(loop, else, end) has been bound between them
+    // bytecodes emitted before a jump target are never folded into later ones
+    void resetFoldingInfo()
+    {
+        m_lastLocalGet = { s_invalidByteCodePosition, 0, 0 };
+        m_previousLocalGet = m_lastLocalGet;
+        m_lastI32ConstPosition = s_invalidByteCodePosition;
+    }
+
+    void markTableAsMutable(Index tableIndex)
+    {
+        if (m_mutableTable.size() <= tableIndex) {
+            m_mutableTable.resize(tableIndex + 1, false);
+        }
+        m_mutableTable[tableIndex] = true;
+    }
+
+    // A table which is not exported and is never written by table.set, table.grow, table.fill,
+    // table.copy or table.init holds exactly what its active element segments put into it
+    // for the lifetime of every instance. When all of those segments have constant offsets,
+    // - call_indirect sites with a constant index are turned into direct calls
+    // - other sites skip the signature check if every function in the table has the expected type
+    // Embedders must not modify such tables through Instance::table either.
+    void devirtualizeCallIndirect()
+    {
+        if (m_callIndirectSite.empty()) {
+            return;
+        }
+
+        const auto& elements = m_module->m_element;
+        const uint32_t invalidSignature = Walrus::FunctionType::s_invalidCanonicalIndex;
+        const uint32_t mixedSignature = invalidSignature - 1;
+
+        // whether the contents are known, and the signature shared by every function in the table
+        // (invalidSignature for a table of nulls, mixedSignature if they differ)
+        std::vector<bool> isKnownTable(m_module->m_table.size());
+        std::vector<uint32_t> tableSignature(m_module->m_table.size(), invalidSignature);
+        for (size_t t = 0; t < m_module->m_table.size(); t++) {
+            isKnownTable[t] = t >= m_mutableTable.size() || !m_mutableTable[t];
+        }
+        for (size_t e = 0; e < elements.size(); e++) {
+            Index t = elements[e]->tableIndex();
+            if (elements[e]->mode() != Walrus::ModuleElement::Active || !isKnownTable[t]) {
+                continue;
+            }
+            // a non constant offset, or a segment which makes instantiation trap
+            if (e >= m_elementConstantOffset.size() || m_elementConstantOffset[e] == kInvalidIndex
+                || static_cast<uint64_t>(m_elementConstantOffset[e]) + elements[e]->functionIndex().size() > std::get<1>(m_module->m_table[t])) {
+                isKnownTable[t] = false;
+                continue;
+            }
+            for (size_t j = 0; j < elements[e]->signature().size(); j++) {
+                uint32_t signature = elements[e]->signature()[j];
+                if (signature != invalidSignature && signature != tableSignature[t]) {
+                    tableSignature[t] = tableSignature[t] == invalidSignature ? signature : mixedSignature;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < m_callIndirectSite.size(); i++) {
+            const CallIndirectSite& site = m_callIndirectSite[i];
+            if (!isKnownTable[site.m_tableIndex]) {
+                continue;
+            }
+
+            auto code = site.m_function->peekByteCode<Walrus::CallIndirect>(site.m_position);
+            uint32_t expected = code->functionType()->canonicalIndex();
+            if (!site.m_isConstantIndex) {
+                uint32_t signature = tableSignature[site.m_tableIndex];
+                if (signature == expected || signature == invalidSignature) {
+                    code->removeSignatureCheck();
+                }
+                continue;
+            }
+
+            // the last segment covering the element wins
+            auto constantCode = site.m_function->peekByteCode<Walrus::CallIndirectConstant>(site.m_position);
+            uint32_t elementIndex = constantCode->elementIndex();
+            for (size_t e = elements.size(); e > 0; e--) {
+                Walrus::ModuleElement* element = elements[e - 1];
+                if (element->mode() != Walrus::ModuleElement::Active || element->tableIndex() != site.m_tableIndex) {
+                    continue;
+                }
+                uint32_t offset = m_elementConstantOffset[e - 1];
+                if (elementIndex >= offset && elementIndex - offset < element->functionIndex().size()) {
+                    uint32_t functionIndex = element->functionIndex()[elementIndex - offset];
+                    // null and mismatching elements trap at runtime
+                    if (functionIndex != Walrus::ModuleElement::s_nullFunctionIndex
+                        && element->signature()[elementIndex - offset] == expected) {
+                        constantCode->devirtualize(functionIndex);
+                        m_callEdge.push_back({ site.m_function->functionIndex(), functionIndex });
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Moves the bytecode of every function into one exactly sized arena.
+    // Functions are placed in depth first order of the call graph, starting from the
+    // start function, exports and element segments, so callees follow their callers.
+    void buildByteCodeArena()
+    {
+        const auto& functions = m_module->m_function;
+        size_t functionCount = functions.size();
+
+        // callees of function i are callee[calleeStart[i] .. calleeStart[i + 1]), in call order
+        std::vector<uint32_t> calleeStart(functionCount + 1, 0);
+        for (size_t i = 0; i < m_callEdge.size(); i++) {
+            calleeStart[m_callEdge[i].first + 1]++;
+        }
+        for (size_t i = 0; i < functionCount; i++) {
+            calleeStart[i + 1] += calleeStart[i];
+        }
+        std::vector<uint32_t> callee(m_callEdge.size());
+        std::vector<uint32_t> calleeEnd(calleeStart.begin(), calleeStart.end() - 1);
+        for (size_t i = 0; i < m_callEdge.size(); i++) {
+            callee[calleeEnd[m_callEdge[i].first]++] = m_callEdge[i].second;
+        }
+
+        std::vector<uint32_t> order;
+        order.reserve(functionCount);
+        std::vector<bool> visited(functionCount, false);
+        std::vector<uint32_t> stack;
+        auto visit = [&](uint32_t root) {
+            stack.push_back(root);
+            while (!stack.empty()) {
+                uint32_t index = stack.back();
+                stack.pop_back();
+                if (visited[index]) {
+                    continue;
+                }
+                visited[index] = true;
+                order.push_back(index);
+                // pushed in reverse, so the first callee is placed next
+                for (size_t i = calleeStart[index + 1]; i > calleeStart[index]; i--) {
+                    if (!visited[callee[i - 1]]) {
+                        stack.push_back(callee[i - 1]);
+                    }
+                }
+            }
+        };
+
+        if (m_module->m_seenStartAttribute) {
+            visit(m_module->m_start);
+        }
+        for (size_t i = 0; i < m_module->m_export.size(); i++) {
+            if (m_module->m_export[i]->type() == Walrus::ModuleExport::Function) {
+                visit(m_module->m_export[i]->itemIndex());
+            }
+        }
+        for (size_t i = 0; i < m_module->m_element.size(); i++) {
+            const auto& functionIndex = m_module->m_element[i]->functionIndex();
+            for (size_t j = 0; j < functionIndex.size(); j++) {
+                if (functionIndex[j] != Walrus::ModuleElement::s_nullFunctionIndex) {
+                    visit(functionIndex[j]);
+                }
+            }
+        }
+        for (size_t i = 0; i < functionCount; i++) {
+            visit(i);
+        }
+
+        // imported functions have no bytecode
+        std::vector<size_t> offset(functionCount);
+        size_t arenaSize = 0;
+        for (size_t i = 0; i < order.size(); i++) {
+            if (functions[order[i]]->m_byteCode) {
+                offset[order[i]] = alignByteCodeSize(arenaSize);
+                arenaSize = offset[order[i]] + functions[order[i]]->m_byteCodeSize;
+            }
+        }
+        if (!arenaSize) {
+            return;
+        }
+
+        uint8_t* arena = reinterpret_cast<uint8_t*>(GC_MALLOC_ATOMIC(arenaSize));
+        for (size_t i = 0; i < functionCount; i++) {
+            Walrus::ModuleFunction* function = functions[i];
+            if (function->m_byteCode) {
+                memcpy(arena + offset[i], function->m_byteCode, function->m_byteCodeSize);
+                GC_FREE(function->m_byteCode);
+                function->m_byteCode = arena + offset[i];
+            }
+        }
+        m_module->m_byteCodeArena = arena;
+        m_module->m_byteCodeArenaSize = arenaSize;
+    }
+
+    static size_t alignByteCodeSize(size_t size)
+    {
+        return (size + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+    }
+
+    bool isFollowedBy(const LocalGetInfo& info, size_t position)
+    {
+        if (info.m_position == s_invalidByteCodePosition) {
+            return false;
+        }
+        size_t size = info.m_size == 4 ? sizeof(Walrus::LocalGet4) : sizeof(Walrus::LocalGet8);
+        return info.m_position + size == position;
+    }
+
+    bool isLastByteCode(const LocalGetInfo& info)
+    {
+        return isFollowedBy(info, currentByteCodeSize());
+    }
+
+    // Bounds check elimination for memory32: once an access to [local + offset, local + offset + size)
+    // has been checked, every later access in the same basic block from the same local value
+    // ending below local + offset + size is in bounds too, since a memory never shrinks.
+    // The checked range is reset on control flow joins(loop, else, end) and when the local changes.
+    bool isMemoryAccessChecked(Index localIndex, Address offset, Walrus::OpcodeKind code)
+    {
+        if (localIndex == kInvalidIndex) {
+            return false;
+        }
+
+        uint64_t end = offset + Walrus::g_byteCodeInfo[code].m_memorySize;
+        auto iter = m_checkedMemoryAccessEnd.find(localIndex);
+        if (iter != m_checkedMemoryAccessEnd.end() && end <= iter->second) {
+            return true;
+        }
+        // the checked access we are going to emit proves this range for the following accesses
+        m_checkedMemoryAccessEnd[localIndex] = end;
+        return false;
+    }
+
+    void invalidateCheckedMemoryAccess(Index localIndex)
+    {
+        m_checkedMemoryAccessEnd.erase(localIndex);
+        // the values already copied to the stack are not the value of the local anymore
+        for (size_t i = 0; i < m_vmStackLocalIndex.size(); i++) {
+            if (m_vmStackLocalIndex[i] == localIndex) {
+                m_vmStackLocalIndex[i] = kInvalidIndex;
+            }
+        }
+    }
+
+    virtual void OnLoadExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        ASSERT(memidx == 0);
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        ASSERT(code >= Walrus::I32LoadOpcode && code <= Walrus::I64Load32UOpcode);
+        if (isMemory64(memidx)) {
+            // memory64 variants are declared in the same order as memory32 ones
+            code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32LoadOpcode + Walrus::I32LoadMemory64Opcode);
+            pushByteCode(Walrus::Memory64Load(code, offset));
+        } else {
+            ASSERT(offset <= std::numeric_limits<uint32_t>::max());
+            bool isChecked = isMemoryAccessChecked(m_vmStackLocalIndex.back(), offset, code);
+            if (isLastByteCode(m_lastLocalGet)) {
+                // local.get $address; load -> load with the address read from the local
+                auto localOffset = m_lastLocalGet.m_localOffset;
+                shrinkByteCode(currentByteCodeSize() - m_lastLocalGet.m_position);
+                resetFoldingInfo();
+                code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32LoadOpcode + (isChecked ? Walrus::I32LoadFromLocalUncheckedOpcode : Walrus::I32LoadFromLocalOpcode));
+                pushByteCode(Walrus::MemoryLoadFromLocal(code, offset, localOffset));
+            } else {
+                if (isChecked) {
+                    code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32LoadOpcode + Walrus::I32LoadUncheckedOpcode);
+                }
+                pushByteCode(Walrus::MemoryLoad(code, offset));
+            }
+        }
+        ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_paramTypes[0]) == peekVMStack());
+        popVMStack();
+        pushVMStack(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_resultType));
+    }
+
+    virtual void OnStoreExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        ASSERT(memidx == 0);
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        ASSERT(code >= Walrus::I32StoreOpcode && code <= Walrus::I64Store32Opcode);
+        if (isMemory64(memidx)) {
+            code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32StoreOpcode + Walrus::I32StoreMemory64Opcode);
+            pushByteCode(Walrus::Memory64Store(code, offset));
+        } else {
+            ASSERT(offset <= std::numeric_limits<uint32_t>::max());
+            bool isChecked = isMemoryAccessChecked(*(m_vmStackLocalIndex.rbegin() + 1), offset, code);
+            if (isLastByteCode(m_lastLocalGet) && isFollowedBy(m_previousLocalGet, m_lastLocalGet.m_position)) {
+                // local.get $address; local.get $value; store -> store with both operands read from the locals
+                auto addressLocalOffset = m_previousLocalGet.m_localOffset;
+                auto valueLocalOffset = m_lastLocalGet.m_localOffset;
+                shrinkByteCode(currentByteCodeSize() - m_previousLocalGet.m_position);
+                resetFoldingInfo();
+                code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32StoreOpcode + (isChecked ? Walrus::I32StoreFromLocalsUncheckedOpcode : Walrus::I32StoreFromLocalsOpcode));
+                pushByteCode(Walrus::MemoryStoreFromLocals(code, offset, addressLocalOffset, valueLocalOffset));
+            } else {
+                if (isChecked) {
+                    code = static_cast<Walrus::OpcodeKind>(code - Walrus::I32StoreOpcode + Walrus::I32StoreUncheckedOpcode);
+                }
+                pushByteCode(Walrus::MemoryStore(code, offset));
+            }
+        }
+        ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_paramTypes[1]) == peekVMStack());
+        popVMStack();
+        ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(Walrus::g_byteCodeInfo[code].m_paramTypes[0]) == peekVMStack());
+        popVMStack();
+    }
+
+    void updateVMStackForAtomicOperation(Walrus::OpcodeKind code)
+    {
+        const auto& info = Walrus::g_byteCodeInfo[code];
+        for (size_t i = 3; i > 0; i--) {
+            if (info.m_paramTypes[i - 1] != Walrus::ByteCodeInfo::___) {
+                ASSERT(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(info.m_paramTypes[i - 1]) == peekVMStack());
+                popVMStack();
+            }
+        }
+        if (info.m_resultType != Walrus::ByteCodeInfo::___) {
+            pushVMStack(Walrus::ByteCodeInfo::byteCodeTypeToMemorySize(info.m_resultType));
+        }
+    }
+
+    // atomic operations are only supported on the first memory when it is a memory32,
+    // other modules are rejected
+    bool checkAtomicMemory(Index memidx)
+    {
+        if (UNLIKELY(memidx != 0 || m_module->m_memory.empty() || isMemory64(memidx))) {
+            setError();
+            return false;
+        }
+        return true;
+    }
+
+    virtual void OnAtomicLoadExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        pushByteCode(Walrus::MemoryLoad(code, offset));
+        updateVMStackForAtomicOperation(code);
+    }
+
+    virtual void OnAtomicStoreExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        pushByteCode(Walrus::MemoryStore(code, offset));
+        updateVMStackForAtomicOperation(code);
+    }
+
+    virtual void OnAtomicRmwExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        pushByteCode(Walrus::AtomicRmw(code, offset));
+        updateVMStackForAtomicOperation(code);
+    }
+
+    virtual void OnAtomicRmwCmpxchgExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        pushByteCode(Walrus::AtomicRmwCmpxchg(code, offset));
+        updateVMStackForAtomicOperation(code);
+    }
+
+    virtual void OnAtomicWaitExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        auto code = static_cast<Walrus::OpcodeKind>(opcode);
+        pushByteCode(Walrus::MemoryAtomicWait(code, offset));
+        updateVMStackForAtomicOperation(code);
+    }
+
+    virtual void OnAtomicNotifyExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) override
+    {
+        if (!checkAtomicMemory(memidx)) {
+            return;
+        }
+        pushByteCode(Walrus::MemoryAtomicNotify(offset));
+        updateVMStackForAtomicOperation(Walrus::MemoryAtomicNotifyOpcode);
+    }
+
+    virtual void OnAtomicFenceExpr(uint32_t consistencyModel) override
+    {
+        pushByteCode(Walrus::AtomicFence());
+    }
+
+    virtual void OnRefFuncExpr(Index funcIndex) override
+    {
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::RefFunc, funcIndex);
+            return;
+        }
+        pushByteCode(Walrus::RefFunc(funcIndex));
+        pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
+    }
+
+    virtual void OnRefNullExpr(Type type) override
+    {
+        if (m_constExpression) {
+            appendConstExpression(Walrus::ConstExpression::RefNull, type == Type::ExternRef ? Walrus::Value::ExternRef : Walrus::Value::FuncRef);
+            return;
+        }
+        pushByteCode(Walrus::RefNull());
+        pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
+    }
+
+    virtual void OnRefIsNullExpr() override
+    {
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
+        popVMStack();
+        pushByteCode(Walrus::RefIsNull());
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
     }
 
+    virtual void OnTableInitExpr(Index segmentIndex, Index tableIndex) override
+    {
+        markTableAsMutable(tableIndex);
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::I32));
+        popVMStack();
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::I32));
+        popVMStack();
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::I32));
+        popVMStack();
+        pushByteCode(Walrus::TableInit(tableIndex, segmentIndex));
+    }
+
+    virtual void OnElemDropExpr(Index segmentIndex) override
+    {
+        pushByteCode(Walrus::ElemDrop(segmentIndex));
+    }
+
     virtual void OnTableGetExpr(Index table_index) override
     {
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
-        m_currentFunction->pushByteCode(Walrus::TableGet(table_index));
+        pushByteCode(Walrus::TableGet(table_index));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
     }
 
     virtual void OnTableSetExpr(Index table_index) override
     {
-        ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::FuncRef)));
+        markTableAsMutable(table_index);
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
         popVMStack();
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
-        m_currentFunction->pushByteCode(Walrus::TableSet(table_index));
+        pushByteCode(Walrus::TableSet(table_index));
     }
 
     virtual void OnTableGrowExpr(Index table_index) override
     {
+        markTableAsMutable(table_index);
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
-        ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::FuncRef)));
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
         popVMStack();
-        m_currentFunction->pushByteCode(Walrus::TableGrow(table_index));
+        pushByteCode(Walrus::TableGrow(table_index));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
     }
 
     virtual void OnTableSizeExpr(Index table_index) override
     {
-        m_currentFunction->pushByteCode(Walrus::TableSize(table_index));
+        pushByteCode(Walrus::TableSize(table_index));
         pushVMStack(Walrus::valueSizeInStack(Walrus::Value::Type::I32));
     }
 
     virtual void OnTableCopyExpr(Index dst_index, Index src_index) override
     {
+        markTableAsMutable(dst_index);
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
+        pushByteCode(Walrus::TableCopy(dst_index, src_index));
     }
 
     virtual void OnTableFillExpr(Index table_index) override
     {
+        markTableAsMutable(table_index);
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
-        ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::FuncRef)));
+        ASSERT(peekVMStack() == Walrus::valueSizeInStack(Walrus::Value::Type::FuncRef));
         popVMStack();
         ASSERT(peekVMStack() == Walrus::valueSizeInStack(toValueKindForLocalType(Type::I32)));
         popVMStack();
+        pushByteCode(Walrus::TableFill(table_index));
     }
 
     virtual void OnNopExpr() override
@@ -721,6 +1375,11 @@ public:
 
     virtual void OnEndExpr() override
     {
+        if (m_constExpression) {
+            return;
+        }
+        m_checkedMemoryAccessEnd.clear();
+        resetFoldingInfo();
         if (m_blockInfo.size()) {
             auto blockInfo = m_blockInfo.back();
             m_blockInfo.pop_back();
@@ -732,20 +1391,21 @@ public:
 
             for (size_t i = 0; i < blockInfo.m_jumpToEndBrInfo.size(); i++) {
                 if (blockInfo.m_jumpToEndBrInfo[i].m_isJumpIf) {
-                    m_currentFunction->peekByteCode<Walrus::JumpIfFalse>(blockInfo.m_jumpToEndBrInfo[i].m_position)
-                        ->setOffset(m_currentFunction->currentByteCodeSize() - blockInfo.m_jumpToEndBrInfo[i].m_position);
+                    peekByteCode<Walrus::JumpIfFalse>(blockInfo.m_jumpToEndBrInfo[i].m_position)
+                        ->setOffset(currentByteCodeSize() - blockInfo.m_jumpToEndBrInfo[i].m_position);
                 } else {
-                    m_currentFunction->peekByteCode<Walrus::Jump>(blockInfo.m_jumpToEndBrInfo[i].m_position)->setOffset(m_currentFunction->currentByteCodeSize() - blockInfo.m_jumpToEndBrInfo[i].m_position);
+                    peekByteCode<Walrus::Jump>(blockInfo.m_jumpToEndBrInfo[i].m_position)->setOffset(currentByteCodeSize() - blockInfo.m_jumpToEndBrInfo[i].m_position);
                 }
             }
 
         } else {
-            m_currentFunction->pushByteCode(Walrus::End());
+            pushByteCode(Walrus::End());
         }
     }
 
     virtual void EndFunctionBody(Index index) override
     {
+        m_currentFunction->commitByteCode(m_byteCodeBuffer.data(), m_byteCodeBuffer.size());
 #if !defined(NDEBUG)
         if (getenv("DUMP_BYTECODE") && strlen(getenv("DUMP_BYTECODE"))) {
             m_currentFunction->dumpByteCode();
@@ -760,12 +1420,107 @@ public:
         m_currentFunction = nullptr;
         m_currentFunctionType = nullptr;
         m_vmStack.clear();
+        m_vmStackLocalIndex.clear();
+        m_checkedMemoryAccessEnd.clear();
     }
 
 private:
+    // constant expressions are evaluated by the runtime instead of being compiled to bytecode
+    void beginConstExpression()
+    {
+        ASSERT(m_currentFunction == nullptr);
+        ASSERT(m_constExpression == nullptr);
+        m_constExpression = new Walrus::ConstExpression();
+    }
+
+    Walrus::ConstExpression* endConstExpression()
+    {
+        Walrus::ConstExpression* expression = m_constExpression;
+        if (UNLIKELY(!expression->isComplete())) {
+            setError();
+        }
+        m_constExpression = nullptr;
+        return expression;
+    }
+
+    // OnOpcode rejects the instructions which are not constant,
+    // but an operation can still be short of operands
+    void appendConstExpression(Walrus::ConstExpression::Opcode opcode, uint64_t operand = 0)
+    {
+        if (UNLIKELY(!m_constExpression->append(opcode, operand))) {
+            setError();
+        }
+    }
+
+    static bool isConstExpressionOpcode(Walrus::OpcodeKind code)
+    {
+        switch (code) {
+        case Walrus::OpcodeKind::I32ConstOpcode:
+        case Walrus::OpcodeKind::I64ConstOpcode:
+        case Walrus::OpcodeKind::F32ConstOpcode:
+        case Walrus::OpcodeKind::F64ConstOpcode:
+        case Walrus::OpcodeKind::GlobalGetOpcode:
+        case Walrus::OpcodeKind::RefNullOpcode:
+        case Walrus::OpcodeKind::RefFuncOpcode:
+        case Walrus::OpcodeKind::EndOpcode:
+            return true;
+        default:
+            return constExpressionOpcode(code) != Walrus::ConstExpression::InvalidOpcode;
+        }
+    }
+
+    static Walrus::ConstExpression::Opcode constExpressionOpcode(Walrus::OpcodeKind code)
+    {
+        switch (code) {
+        case Walrus::OpcodeKind::I32AddOpcode:
+            return Walrus::ConstExpression::I32Add;
+        case Walrus::OpcodeKind::I32SubOpcode:
+            return Walrus::ConstExpression::I32Sub;
+        case Walrus::OpcodeKind::I32MulOpcode:
+            return Walrus::ConstExpression::I32Mul;
+        case Walrus::OpcodeKind::I64AddOpcode:
+            return Walrus::ConstExpression::I64Add;
+        case Walrus::OpcodeKind::I64SubOpcode:
+            return Walrus::ConstExpression::I64Sub;
+        case Walrus::OpcodeKind::I64MulOpcode:
+            return Walrus::ConstExpression::I64Mul;
+        default:
+            return Walrus::ConstExpression::InvalidOpcode;
+        }
+    }
+
+    template <typename CodeType>
+    void pushByteCode(const CodeType& code)
+    {
+        const uint8_t* first = reinterpret_cast<const uint8_t*>(&code);
+        m_byteCodeBuffer.insert(m_byteCodeBuffer.end(), first, first + sizeof(CodeType));
+    }
+
+    template <typename CodeType>
+    CodeType* peekByteCode(size_t position)
+    {
+        return reinterpret_cast<CodeType*>(&m_byteCodeBuffer[position]);
+    }
+
+    void expandByteCode(size_t s)
+    {
+        m_byteCodeBuffer.resize(m_byteCodeBuffer.size() + s);
+    }
+
+    void shrinkByteCode(size_t s)
+    {
+        m_byteCodeBuffer.resize(m_byteCodeBuffer.size() - s);
+    }
+
+    size_t currentByteCodeSize() const
+    {
+        return m_byteCodeBuffer.size();
+    }
+
     void pushVMStack(size_t s)
     {
         m_vmStack.push_back(s);
+        m_vmStackLocalIndex.push_back(kInvalidIndex);
         m_functionStackSizeSoFar += s;
         m_currentFunction->m_requiredStackSize = std::max(
             m_currentFunction->m_requiredStackSize, m_functionStackSizeSoFar);
@@ -776,6 +1531,7 @@ private:
         auto s = m_vmStack.back();
         m_functionStackSizeSoFar -= s;
         m_vmStack.pop_back();
+        m_vmStackLocalIndex.pop_back();
         return s;
     }
 
@@ -785,24 +1541,373 @@ private:
     }
 
     Walrus::Module* m_module;
+    bool m_hasSkippedFunctionBodies;
     Walrus::ModuleFunction* m_currentFunction;
     Walrus::FunctionType* m_currentFunctionType;
+    // the global initializer or segment offset which is being read
+    Walrus::ConstExpression* m_constExpression;
     uint32_t m_functionStackSizeSoFar;
     std::vector<unsigned char> m_vmStack;
+    // the local which was copied to each VM stack slot by local.get (or kInvalidIndex)
+    std::vector<Index> m_vmStackLocalIndex;
+    // stack offset and size of each param and local of the current function
+    std::vector<LocalInfo> m_localInfo;
     std::vector<BlockInfo> m_blockInfo;
+    // local index -> end of the range [local, local + end) of the memory32
+    // which is already bounds checked in the current basic block
+    std::unordered_map<Index, uint64_t> m_checkedMemoryAccessEnd;
+    // the latest two local.get bytecodes
+    LocalGetInfo m_lastLocalGet;
+    LocalGetInfo m_previousLocalGet;
+    size_t m_lastI32ConstPosition;
+
+    // bytecode of the current function, reused for every function
+    std::vector<uint8_t> m_byteCodeBuffer;
+    // caller and callee function index of each direct call, for buildByteCodeArena
+    std::vector<std::pair<uint32_t, uint32_t>> m_callEdge;
+
+    // data for devirtualizeCallIndirect
+    std::vector<CallIndirectSite> m_callIndirectSite;
+    std::vector<bool> m_mutableTable;
+    // i32.const offset of each active element segment (or kInvalidIndex)
+    std::vector<Index> m_elementConstantOffset;
 };
 
 } // namespace wabt
 
 namespace Walrus {
 
-Optional<Module*> WASMParser::parseBinary(Store* store, const uint8_t* data, size_t len)
+static wabt::WASMReadOptions readOptions(const ParseOptions& options)
 {
-    Module* module = new Module(store);
-    wabt::WASMBinaryReader delegate(module);
+    wabt::WASMReadOptions result;
+    result.m_features = options.m_features;
+    // a lazily read name section is recorded by OnCustomSection
+    result.m_readDebugNames = options.m_nameSection == ParseOptions::ReadNameSection;
+    result.m_skipCustomSections = options.m_skipCustomSections;
+    result.m_isTrusted = options.m_isTrusted;
+    return result;
+}
+
+#if defined(GC_THREADS)
+static bool readFunctionBodiesInParallel(const uint8_t* data, size_t len, const wabt::WASMFunctionBodies& bodies,
+                                         wabt::WASMBinaryReader& delegate, Module* module, size_t threadCount)
+{
+    // bodies are handed out one by one since their sizes vary a lot
+    std::atomic<size_t> nextBody(0);
+    std::atomic<bool> hasError(false);
+    std::vector<wabt::WASMBinaryReader*> readers;
+    std::vector<std::thread> threads;
+
+    GCThreadScope::allowRegistration();
+    for (size_t i = 0; i < threadCount; i++) {
+        readers.push_back(new wabt::WASMBinaryReader(module));
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        wabt::WASMBinaryReader* reader = readers[i];
+        threads.push_back(std::thread([&, reader]() {
+            GCThreadScope scope;
+
+            size_t index;
+            while (!hasError.load(std::memory_order_relaxed) && (index = nextBody.fetch_add(1, std::memory_order_relaxed)) < bodies.m_body.size()) {
+                if (!ReadWasmFunctionBody(data, len, readOptions(module->parseOptions()), bodies, index, reader)) {
+                    hasError.store(true, std::memory_order_relaxed);
+                }
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        threads[i].join();
+        delegate.mergeFunctionBodyReader(*readers[i]);
+        delete readers[i];
+    }
+    return !hasError.load(std::memory_order_relaxed);
+}
+#endif
+
+Optional<Module*> WASMParser::parseBinary(Store* store, const uint8_t* data, size_t len, const ParseOptions& options)
+{
+    Module* module = new Module(store, options);
+
+    if (store->engine()->useLazyCompilation()) {
+        wabt::WASMFunctionBodies bodies;
+        wabt::WASMBinaryReader delegate(module, true);
+        if (!ReadWasmBinary(data, len, readOptions(options), &delegate, &bodies)) {
+            return nullptr;
+        }
+        // bodies are decoded without generating bytecode, so a module is rejected here
+        // like in eager mode, and only a trusted module can fail to compile on the first call
+        if (!options.m_isTrusted) {
+            for (size_t i = 0; i < bodies.m_body.size(); i++) {
+                if (!CheckWasmFunctionBody(data, len, readOptions(options), bodies, i)) {
+                    return nullptr;
+                }
+            }
+        }
 
-    ReadWasmBinary(data, len, &delegate);
+        module->m_binary.resizeWithUninitializedValues(len);
+        memcpy(module->m_binary.data(), data, len);
+        module->m_dataCount = bodies.m_dataCount;
+        for (size_t i = 0; i < bodies.m_body.size(); i++) {
+            ModuleFunction* function = module->function(bodies.m_body[i].m_functionIndex);
+            function->m_bodyOffset = bodies.m_body[i].m_offset;
+            function->m_bodySize = bodies.m_body[i].m_size;
+            function->m_isCompiled.store(false, std::memory_order_relaxed);
+        }
+        // functions are compiled one by one, so which tables they write is never known
+        // and call_indirect is not devirtualized
+        return module;
+    }
+
+#if defined(GC_THREADS)
+    // every thread which allocates from the GC heap must be registered,
+    // so function bodies can be read in parallel only if bdwgc supports threads
+    size_t threadCount = store->engine()->compilationThreadCount();
+    if (threadCount > 1) {
+        wabt::WASMFunctionBodies bodies;
+        wabt::WASMBinaryReader delegate(module, true);
+        if (!ReadWasmBinary(data, len, readOptions(options), &delegate, &bodies)) {
+            return nullptr;
+        }
+
+        threadCount = std::min(threadCount, bodies.m_body.size());
+        if (threadCount > 1) {
+            if (!readFunctionBodiesInParallel(data, len, bodies, delegate, module, threadCount)) {
+                return nullptr;
+            }
+        } else {
+            for (size_t i = 0; i < bodies.m_body.size(); i++) {
+                if (!ReadWasmFunctionBody(data, len, readOptions(options), bodies, i, &delegate)) {
+                    return nullptr;
+                }
+            }
+        }
+        delegate.endModuleWithFunctionBodies();
+        return module;
+    }
+#endif
+
+    wabt::WASMBinaryReader delegate(module);
+    if (!ReadWasmBinary(data, len, readOptions(options), &delegate)) {
+        return nullptr;
+    }
     return module;
 }
 
+WASMStreamingParser::WASMStreamingParser(Store* store, const ParseOptions& options)
+    : m_store(store)
+    , m_options(options)
+    , m_module(nullptr)
+    , m_state(ModuleHeader)
+    , m_position(0)
+    , m_sectionEnd(0)
+    , m_codeSectionStart(0)
+    , m_functionBodyCount(0)
+    , m_functionBodyIndex(0)
+    , m_hasSectionAfterCodeSection(false)
+    , m_delegate(nullptr)
+    , m_functionBodies(nullptr)
+{
+}
+
+WASMStreamingParser::~WASMStreamingParser()
+{
+    delete m_delegate;
+    delete m_functionBodies;
+}
+
+void WASMStreamingParser::append(const uint8_t* data, size_t len)
+{
+    m_buffer.insert(m_buffer.end(), data, data + len);
+    // lazy compilation does not generate bytecode while parsing, so there is nothing to overlap
+    if (!m_store->engine()->useLazyCompilation()) {
+        process();
+    }
+}
+
+Optional<Module*> WASMStreamingParser::finish()
+{
+    if (!m_module) {
+        // no code section was seen
+        if (m_state == Error) {
+            return nullptr;
+        }
+        return WASMParser::parseBinary(m_store, m_buffer.data(), m_buffer.size(), m_options);
+    }
+
+    if (m_state != SectionHeader || m_position != m_buffer.size()) {
+        return nullptr;
+    }
+
+    // sections after the code section are rare, so the whole binary is parsed again
+    if (m_hasSectionAfterCodeSection) {
+        return WASMParser::parseBinary(m_store, m_buffer.data(), m_buffer.size(), m_options);
+    }
+
+    m_delegate->endModuleWithFunctionBodies();
+    return m_module;
+}
+
+bool WASMStreamingParser::readU32Leb128(size_t& position, uint32_t& value)
+{
+    value = 0;
+    for (size_t i = 0; i < 5; i++) {
+        if (position + i >= m_buffer.size()) {
+            return false;
+        }
+        uint8_t byte = m_buffer[position + i];
+        value |= static_cast<uint32_t>(byte & 0x7f) << (i * 7);
+        if (!(byte & 0x80)) {
+            position += i + 1;
+            return true;
+        }
+    }
+    m_state = Error;
+    return false;
+}
+
+void WASMStreamingParser::readSectionsBeforeCodeSection()
+{
+    // the sections before the code section are read as a module on their own
+    // followed by a code section of empty bodies, which only give the index of each body
+    auto pushU32Leb128 = [](std::vector<uint8_t>& out, uint32_t value) {
+        do {
+            uint8_t byte = value & 0x7f;
+            value >>= 7;
+            out.push_back(value ? (byte | 0x80) : byte);
+        } while (value);
+    };
+    const uint8_t emptyBody[] = { 0x02, 0x00, 0x0b }; // size, local declaration count, end
+    std::vector<uint8_t> codeSection;
+    pushU32Leb128(codeSection, m_functionBodyCount);
+    for (uint32_t i = 0; i < m_functionBodyCount; i++) {
+        codeSection.insert(codeSection.end(), emptyBody, emptyBody + sizeof(emptyBody));
+    }
+
+    std::vector<uint8_t> prefix(m_buffer.begin(), m_buffer.begin() + m_codeSectionStart);
+    prefix.push_back(10); // section code
+    pushU32Leb128(prefix, codeSection.size());
+    prefix.insert(prefix.end(), codeSection.begin(), codeSection.end());
+
+    m_module = new Module(m_store, m_options);
+    m_delegate = new wabt::WASMBinaryReader(m_module, true);
+    m_functionBodies = new wabt::WASMFunctionBodies();
+    if (!ReadWasmBinary(prefix.data(), prefix.size(), readOptions(m_options), m_delegate, m_functionBodies)
+        || m_functionBodies->m_body.size() != m_functionBodyCount) {
+        m_state = Error;
+    }
+}
+
+void WASMStreamingParser::process()
+{
+    while (m_state != Error) {
+        switch (m_state) {
+        case ModuleHeader:
+            if (m_buffer.size() < 8) {
+                return;
+            }
+            m_position = 8;
+            m_state = SectionHeader;
+            break;
+        case SectionHeader: {
+            size_t position = m_position;
+            if (position >= m_buffer.size()) {
+                return;
+            }
+            uint8_t sectionCode = m_buffer[position++];
+            uint32_t sectionSize;
+            if (!readU32Leb128(position, sectionSize)) {
+                return;
+            }
+            // custom sections which would be skipped do not change the module
+            bool isSkippedSection = sectionCode == 0 && m_options.m_skipCustomSections && m_options.m_nameSection == ParseOptions::SkipNameSection;
+            if (m_module && !isSkippedSection) {
+                m_hasSectionAfterCodeSection = true;
+            }
+            if (sectionCode == 10 && !m_module) {
+                m_codeSectionStart = m_position;
+                m_state = CodeSectionCount;
+            } else {
+                m_state = SectionPayload;
+            }
+            m_sectionEnd = position + sectionSize;
+            m_position = position;
+            break;
+        }
+        case SectionPayload:
+            if (m_buffer.size() < m_sectionEnd) {
+                return;
+            }
+            m_position = m_sectionEnd;
+            m_state = SectionHeader;
+            break;
+        case CodeSectionCount: {
+            size_t position = m_position;
+            if (!readU32Leb128(position, m_functionBodyCount)) {
+                return;
+            }
+            m_position = position;
+            m_functionBodyIndex = 0;
+            readSectionsBeforeCodeSection();
+            if (m_state != Error) {
+                m_state = FunctionBody;
+            }
+            break;
+        }
+        case FunctionBody: {
+            if (m_functionBodyIndex == m_functionBodyCount) {
+                m_state = m_position == m_sectionEnd ? SectionHeader : Error;
+                break;
+            }
+            size_t position = m_position;
+            uint32_t bodySize;
+            if (!readU32Leb128(position, bodySize)) {
+                return;
+            }
+            if (position + bodySize > m_sectionEnd) {
+                m_state = Error;
+                break;
+            }
+            if (position + bodySize > m_buffer.size()) {
+                return;
+            }
+            wabt::WASMFunctionBodies::Body& body = m_functionBodies->m_body[m_functionBodyIndex];
+            body.m_offset = position;
+            body.m_size = bodySize;
+            if (!ReadWasmFunctionBody(m_buffer.data(), m_buffer.size(), readOptions(m_options), *m_functionBodies, m_functionBodyIndex, m_delegate)) {
+                m_state = Error;
+                break;
+            }
+            m_functionBodyIndex++;
+            m_position = position + bodySize;
+            break;
+        }
+        default:
+            RELEASE_ASSERT_NOT_REACHED();
+        }
+    }
+}
+
+bool WASMParser::compileFunction(ModuleFunction* function)
+{
+    Module* module = function->module();
+    ASSERT(module->m_binary.size());
+
+    wabt::WASMFunctionBodies bodies;
+    bodies.m_body.push_back({ function->functionIndex(), function->m_bodyOffset, function->m_bodySize });
+    for (size_t i = 0; i < module->m_memory.size(); i++) {
+        bodies.m_memoryIs64.push_back(std::get<2>(module->m_memory[i]));
+    }
+    bodies.m_dataCount = module->m_dataCount;
+
+    wabt::WASMBinaryReader reader(module);
+    return ReadWasmFunctionBody(module->m_binary.data(), module->m_binary.size(), readOptions(module->parseOptions()), bodies, 0, &reader);
+}
+
+void WASMParser::readNameSection(Module* module)
+{
+    wabt::WASMBinaryReader reader(module);
+    ReadWasmNameSection(module->m_nameSection.data(), module->m_nameSection.size(), readOptions(module->parseOptions()), module->m_function.size(), &reader);
+}
+
 } // namespace Walrus
@@ -18,6 +18,12 @@
 #define __WalrusWASMParser__
 
 #include "runtime/Module.h"
+#include "parser/ParseOptions.h"
+
+namespace wabt {
+class WASMBinaryReader;
+struct WASMFunctionBodies;
+}
 
 namespace Walrus {
 
@@ -27,7 +33,57 @@ class Store;
 class WASMParser {
 public:
     // may return null when there is error on data
-    static Optional<Module*> parseBinary(Store* store, const uint8_t* data, size_t len);
+    static Optional<Module*> parseBinary(Store* store, const uint8_t* data, size_t len, const ParseOptions& options = ParseOptions());
+
+    // generate bytecode of a function whose body was skipped by lazy compilation
+    // returns false when the body is rejected
+    static bool compileFunction(ModuleFunction* function);
+    // read the name section kept by ParseOptions::ReadNameSectionLazily
+    static void readNameSection(Module* module);
+};
+
+// parses a binary which arrives in chunks
+// the sections before the code section are parsed once they are complete,
+// then each function body is compiled as soon as all of its bytes arrived
+// keep it on the stack (or in memory scanned by the GC) since it holds the Module being built
+class WASMStreamingParser {
+public:
+    WASMStreamingParser(Store* store, const ParseOptions& options = ParseOptions());
+    ~WASMStreamingParser();
+
+    void append(const uint8_t* data, size_t len);
+    // call after the last chunk is appended
+    // may return null when there is error on data
+    Optional<Module*> finish();
+
+private:
+    enum State {
+        ModuleHeader,
+        SectionHeader,
+        SectionPayload,
+        CodeSectionCount,
+        FunctionBody,
+        Error,
+    };
+
+    void process();
+    bool readU32Leb128(size_t& position, uint32_t& value);
+    void readSectionsBeforeCodeSection();
+
+    Store* m_store;
+    ParseOptions m_options;
+    Module* m_module;
+    State m_state;
+    std::vector<uint8_t> m_buffer;
+    // everything before m_position is processed
+    size_t m_position;
+    size_t m_sectionEnd;
+    size_t m_codeSectionStart;
+    uint32_t m_functionBodyCount;
+    uint32_t m_functionBodyIndex;
+    bool m_hasSectionAfterCodeSection;
+    wabt::WASMBinaryReader* m_delegate;
+    wabt::WASMFunctionBodies* m_functionBodies;
 };
 
 } // namespace Walrus
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Walrus.h"
+
+#include "Walrus.h"
+
+#include "runtime/Engine.h"
+#include "runtime/Module.h"
+#include "runtime/SharedModuleCache.h"
+
+namespace Walrus {
+
+Engine::Engine()
+    : m_useHugePageForMemory(false)
+    , m_compilationThreadCount(1)
+    , m_useLazyCompilation(false)
+    , m_moduleCache(new SharedModuleCache())
+{
+    GC_REGISTER_FINALIZER_NO_ORDER(this, [](void* obj, void* cd) {
+        Engine* engine = reinterpret_cast<Engine*>(obj);
+        engine->m_functionTypeLock.~mutex();
+        engine->m_functionTypeIndex.~unordered_map();
+    },
+                                   nullptr, nullptr, nullptr);
+}
+
+uint32_t Engine::internFunctionType(FunctionType* functionType)
+{
+    const FunctionType::FunctionTypeVector& param = functionType->param();
+    const FunctionType::FunctionTypeVector& result = functionType->result();
+
+    std::string signature;
+    signature.reserve(param.size() + result.size() + 1);
+    for (size_t i = 0; i < param.size(); i++) {
+        signature.push_back(static_cast<char>(param[i]));
+    }
+    signature.push_back(static_cast<char>(Value::Type::Void));
+    for (size_t i = 0; i < result.size(); i++) {
+        signature.push_back(static_cast<char>(result[i]));
+    }
+
+    std::lock_guard<std::mutex> guard(m_functionTypeLock);
+    auto iter = m_functionTypeIndex.insert(std::make_pair(signature, static_cast<uint32_t>(m_functionTypeIndex.size())));
+    functionType->m_canonicalIndex = iter.first->second;
+    return functionType->m_canonicalIndex;
+}
+
+} // namespace Walrus
@@ -17,11 +17,83 @@
 #ifndef __WalrusEngine__
 #define __WalrusEngine__
 
+#include <mutex>
+
 namespace Walrus {
 
+class FunctionType;
+class SharedModuleCache;
+
+// threading model(walrus must be built with WALRUS_THREADS=1, which enables GC_THREADS of bdwgc)
+// - Engine is configured before it is used by other threads, its function type table
+//   and module cache are locked
+// - Store can be shared by threads, its interning tables are locked
+// - Module is immutable after parsing and shared by threads, including lazily compiled functions
+//   and the lazily read name section, which are generated once
+// - an Instance, and the ExecutionStates of the calls into it belong to one thread at a time
+//   (except shared memories), InstancePool can hand out instances to threads
+// - every thread other than the one which called GC_INIT must be registered to bdwgc(see GCThreadScope)
 class Engine : public gc {
+public:
+    Engine();
+
+    // back large linear memories with transparent huge pages (linux only)
+    bool useHugePageForMemory() const
+    {
+        return m_useHugePageForMemory;
+    }
+
+    void setUseHugePageForMemory(bool use)
+    {
+        m_useHugePageForMemory = use;
+    }
+
+    // number of threads which generate bytecode of function bodies
+    // while parsing a module (1 means no worker threads are used)
+    // walrus built without WALRUS_THREADS=1 always parses on the calling thread
+    size_t compilationThreadCount() const
+    {
+        return m_compilationThreadCount;
+    }
+
+    void setCompilationThreadCount(size_t count)
+    {
+        m_compilationThreadCount = count ? count : 1;
+    }
+
+    // generate bytecode of each function on its first call instead of while parsing
+    bool useLazyCompilation() const
+    {
+        return m_useLazyCompilation;
+    }
+
+    void setUseLazyCompilation(bool use)
+    {
+        m_useLazyCompilation = use;
+    }
+
+    // in-memory cache of the modules parsed by the stores of the engine
+    // it is disabled until its capacity is set
+    SharedModuleCache* moduleCache() const
+    {
+        return m_moduleCache;
+    }
+
+    // assign the canonical index of functionType
+    // canonical indexes are shared by the stores of the engine, so a module
+    // can be used by every store of the engine(see SharedModuleCache)
+    uint32_t internFunctionType(FunctionType* functionType);
+
+private:
+    bool m_useHugePageForMemory;
+    size_t m_compilationThreadCount;
+    bool m_useLazyCompilation;
+    SharedModuleCache* m_moduleCache;
+    std::mutex m_functionTypeLock;
+    // signature(params, Void, results) -> canonical index
+    std::unordered_map<std::string, uint32_t> m_functionTypeIndex;
 };
 
 } // namespace Walrus
 
-#endif // __WalrusInstance__
+#endif // __WalrusEngine__
@@ -43,6 +43,11 @@ public:
         return m_currentFunction;
     }
 
+    Optional<ExecutionState*> parent() const
+    {
+        return m_parent;
+    }
+
 private:
     ExecutionState()
     {
@@ -25,6 +25,8 @@ namespace Walrus {
 
 void DefinedFunction::call(ExecutionState& state, const uint32_t argc, Value* argv, Value* result)
 {
+    m_moduleFunction->compileIfNeeded();
+
     ExecutionState newState(state, this);
     uint8_t* functionStackBase = ALLOCA(m_moduleFunction->requiredStackSize(), uint8_t);
     uint8_t* functionStackPointer = functionStackBase;
@@ -53,6 +55,25 @@ void DefinedFunction::call(ExecutionState& state, const uint32_t argc, Value* ar
 
 void ImportedFunction::call(ExecutionState& state, const uint32_t argc, Value* argv, Value* result)
 {
+    if (m_stackCallback) {
+        FunctionType* ft = functionType();
+        uint8_t* stack = ALLOCA(std::max(ft->paramStackSize(), ft->resultStackSize()), uint8_t);
+
+        uint8_t* stackPointer = stack;
+        for (size_t i = 0; i < argc; i++) {
+            argv[i].writeToStack(stackPointer);
+        }
+        callWithStack(state, stack);
+
+        const FunctionType::FunctionTypeVector& resultTypeInfo = ft->result();
+        stackPointer = stack;
+        for (size_t i = 0; i < resultTypeInfo.size(); i++) {
+            result[i] = Value(resultTypeInfo[i], stackPointer);
+            stackPointer += valueSizeInStack(resultTypeInfo[i]);
+        }
+        return;
+    }
+
     ExecutionState newState(state, this);
     m_callback(newState, argc, argv, result, m_data);
 }
@@ -96,6 +96,10 @@ protected:
 class ImportedFunction : public Function {
 public:
     typedef void (*ImportedFunctionCallback)(ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data);
+    // reads the parameters from the operand stack of the caller in stack layout,
+    // and writes the results over them starting from the same address
+    // the type of the function is available from state.currentFunction()
+    typedef void (*ImportedFunctionStackCallback)(ExecutionState& state, uint8_t* stack, void* data);
 
     ImportedFunction(Store* store,
                      FunctionType* functionType,
@@ -103,6 +107,18 @@ public:
                      void* data)
         : Function(store, functionType)
         , m_callback(callback)
+        , m_stackCallback(nullptr)
+        , m_data(data)
+    {
+    }
+
+    ImportedFunction(Store* store,
+                     FunctionType* functionType,
+                     ImportedFunctionStackCallback callback,
+                     void* data)
+        : Function(store, functionType)
+        , m_callback(nullptr)
+        , m_stackCallback(callback)
         , m_data(data)
     {
     }
@@ -113,8 +129,17 @@ public:
     }
     virtual void call(ExecutionState& state, const uint32_t argc, Value* argv, Value* result) override;
 
+    bool hasStackCallback() const { return m_stackCallback; }
+    void callWithStack(ExecutionState& state, uint8_t* stack)
+    {
+        ASSERT(hasStackCallback());
+        ExecutionState newState(state, this);
+        m_stackCallback(newState, stack, m_data);
+    }
+
 protected:
     ImportedFunctionCallback m_callback;
+    ImportedFunctionStackCallback m_stackCallback;
     void* m_data;
 };
 
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusFunctionType__
+#define __WalrusFunctionType__
+
+#include "runtime/Value.h"
+#include "util/Vector.h"
+
+namespace Walrus {
+
+class FunctionType : public gc {
+    friend class Engine;
+
+public:
+    static constexpr uint32_t s_invalidCanonicalIndex = std::numeric_limits<uint32_t>::max();
+    // index of the types which do not belong to a module, such as the types of host functions
+    static constexpr uint32_t s_noModuleIndex = std::numeric_limits<uint32_t>::max();
+
+    typedef Vector<Value::Type, GCUtil::gc_malloc_atomic_allocator<Value::Type>>
+        FunctionTypeVector;
+    FunctionType(uint32_t index,
+                 FunctionTypeVector&& param,
+                 FunctionTypeVector&& result)
+        : m_index(index)
+        , m_canonicalIndex(s_invalidCanonicalIndex)
+        , m_param(std::move(param))
+        , m_result(std::move(result))
+        , m_paramStackSize(computeStackSize(m_param))
+        , m_resultStackSize(computeStackSize(m_result))
+    {
+    }
+
+    uint32_t index() const { return m_index; }
+
+    // structurally equal types have the same canonical index in an Engine
+    uint32_t canonicalIndex() const
+    {
+        ASSERT(m_canonicalIndex != s_invalidCanonicalIndex);
+        return m_canonicalIndex;
+    }
+
+    const FunctionTypeVector& param() const { return m_param; }
+
+    const FunctionTypeVector& result() const { return m_result; }
+
+    size_t paramStackSize() const { return m_paramStackSize; }
+
+    size_t resultStackSize() const { return m_resultStackSize; }
+
+private:
+    uint32_t m_index;
+    uint32_t m_canonicalIndex;
+    FunctionTypeVector m_param;
+    FunctionTypeVector m_result;
+    size_t m_paramStackSize;
+    size_t m_resultStackSize;
+
+    static size_t computeStackSize(const FunctionTypeVector& v)
+    {
+        size_t s = 0;
+        for (size_t i = 0; i < v.size(); i++) {
+            s += valueSizeInStack(v[i]);
+        }
+        return s;
+    }
+};
+
+} // namespace Walrus
+
+#endif // __WalrusFunctionType__
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __WalrusGCThreadScope__
+#define __WalrusGCThreadScope__
+
+namespace Walrus {
+
+// registers the current thread to bdwgc while the scope is alive
+// threads which are not created by bdwgc must be registered before they allocate from the GC heap
+// or keep references to GC objects on their stack, and must not touch GC objects after unregistering
+// does nothing when walrus is built without thread support(GC_THREADS)
+class GCThreadScope {
+public:
+    GCThreadScope()
+        : m_registered(false)
+    {
+#if defined(GC_THREADS)
+        struct GC_stack_base stackBase;
+        if (GC_get_stack_base(&stackBase) == GC_SUCCESS) {
+            // a thread which is registered already(e.g. the main thread) stays registered
+            m_registered = GC_register_my_thread(&stackBase) == GC_SUCCESS;
+        }
+#endif
+    }
+
+    ~GCThreadScope()
+    {
+#if defined(GC_THREADS)
+        if (m_registered) {
+            GC_unregister_my_thread();
+        }
+#endif
+    }
+
+    // must be called by a registered thread(e.g. the main thread after GC_INIT)
+    // before other threads register themselves
+    static void allowRegistration()
+    {
+#if defined(GC_THREADS)
+        GC_allow_register_threads();
+#endif
+    }
+
+private:
+    GCThreadScope(const GCThreadScope&) = delete;
+    GCThreadScope& operator=(const GCThreadScope&) = delete;
+
+    bool m_registered;
+};
+
+} // namespace Walrus
+
+#endif // __WalrusGCThreadScope__
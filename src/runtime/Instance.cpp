@@ -18,24 +18,132 @@
 
 #include "Instance.h"
 #include "runtime/Module.h"
+#include "runtime/Function.h"
+#include "runtime/Memory.h"
+#include "runtime/Table.h"
 
 namespace Walrus {
 
-Value Instance::resolveExport(String* name)
+class InstanceSnapshot : public gc {
+public:
+    // memories are zeroed on reset, and only the chunks which were not zero are copied back
+    static const size_t s_memoryChunkSize = 4096;
+
+    struct MemoryChunk {
+        size_t m_offset;
+        uint8_t m_data[s_memoryChunkSize];
+    };
+
+    struct MemorySnapshot : public gc {
+        size_t m_sizeInByte;
+        Vector<MemoryChunk*, GCUtil::gc_malloc_allocator<MemoryChunk*>> m_chunk;
+    };
+
+    Vector<MemorySnapshot*, GCUtil::gc_malloc_allocator<MemorySnapshot*>> m_memory;
+    Vector<Table*, GCUtil::gc_malloc_allocator<Table*>> m_table;
+    Vector<ElementSegment*, GCUtil::gc_malloc_allocator<ElementSegment*>> m_elementSegment;
+    ValueVector m_global;
+};
+
+void Instance::saveSnapshot()
 {
-    for (auto me : m_module->moduleExport()) {
-        if (me->name()->equals(name)) {
-            switch (me->type()) {
-            case ModuleExport::Function:
-                return Value(function(me->itemIndex()));
-            default:
-                RELEASE_ASSERT_NOT_REACHED();
+    InstanceSnapshot* snapshot = new InstanceSnapshot();
+
+    snapshot->m_memory.reserve(m_memory.size());
+    for (size_t i = 0; i < m_memory.size(); i++) {
+        Memory* memory = m_memory[i];
+        InstanceSnapshot::MemorySnapshot* memorySnapshot = new InstanceSnapshot::MemorySnapshot();
+        memorySnapshot->m_sizeInByte = memory->sizeInByte();
+        snapshot->m_memory.pushBack(memorySnapshot);
+
+        static const uint8_t zero[InstanceSnapshot::s_memoryChunkSize] = {};
+        for (size_t offset = 0; offset < memory->sizeInByte(); offset += InstanceSnapshot::s_memoryChunkSize) {
+            if (memcmp(memory->buffer() + offset, zero, InstanceSnapshot::s_memoryChunkSize)) {
+                InstanceSnapshot::MemoryChunk* chunk = reinterpret_cast<InstanceSnapshot::MemoryChunk*>(GC_MALLOC_ATOMIC(sizeof(InstanceSnapshot::MemoryChunk)));
+                chunk->m_offset = offset;
+                memcpy(chunk->m_data, memory->buffer() + offset, InstanceSnapshot::s_memoryChunkSize);
+                memorySnapshot->m_chunk.pushBack(chunk);
             }
-            break;
+        }
+    }
+
+    snapshot->m_table.reserve(m_table.size());
+    for (size_t i = 0; i < m_table.size(); i++) {
+        snapshot->m_table.pushBack(new Table(*m_table[i]));
+    }
+
+    snapshot->m_elementSegment.reserve(m_elementSegment.size());
+    for (size_t i = 0; i < m_elementSegment.size(); i++) {
+        snapshot->m_elementSegment.pushBack(new ElementSegment(*m_elementSegment[i]));
+    }
+
+    snapshot->m_global = m_global;
+    m_snapshot = snapshot;
+}
+
+void Instance::reset()
+{
+    ASSERT(m_snapshot);
+
+    for (size_t i = 0; i < m_memory.size(); i++) {
+        Memory* memory = m_memory[i];
+        const InstanceSnapshot::MemorySnapshot* memorySnapshot = m_snapshot->m_memory[i];
+        memory->reset(memorySnapshot->m_sizeInByte);
+        for (size_t j = 0; j < memorySnapshot->m_chunk.size(); j++) {
+            memcpy(memory->buffer() + memorySnapshot->m_chunk[j]->m_offset, memorySnapshot->m_chunk[j]->m_data, InstanceSnapshot::s_memoryChunkSize);
+        }
+    }
+
+    for (size_t i = 0; i < m_table.size(); i++) {
+        m_table[i]->assign(m_snapshot->m_table[i]);
+    }
+
+    for (size_t i = 0; i < m_elementSegment.size(); i++) {
+        m_elementSegment[i]->assign(m_snapshot->m_elementSegment[i]);
+    }
+
+    ASSERT(m_global.size() == m_snapshot->m_global.size());
+    if (m_global.size()) {
+        memcpy(m_global.data(), m_snapshot->m_global.data(), m_global.size() * sizeof(Value));
+    }
+}
+
+NEVER_INLINE Function* Instance::createFunction(uint32_t index)
+{
+    ModuleFunction* moduleFunction = m_module->function(index);
+    Function* function = new DefinedFunction(m_module->store(), m_module->functionType(moduleFunction->functionTypeIndex()), this, moduleFunction);
+    m_function[index] = function;
+    return function;
+}
+
+NEVER_INLINE void Instance::growCallIndirectCache()
+{
+    ASSERT(m_module->callIndirectCacheCount() > m_callIndirectCache.size());
+    m_callIndirectCache.resize(m_module->callIndirectCacheCount(), CallIndirectCache({ 0, 0, nullptr }));
+}
+
+Value Instance::resolveExport(Optional<ModuleExport*> me)
+{
+    if (me) {
+        switch (me->type()) {
+        case ModuleExport::Function:
+            return Value(function(me->itemIndex()));
+        default:
+            RELEASE_ASSERT_NOT_REACHED();
         }
     }
 
     return Value();
 }
 
+Value Instance::resolveExport(String* name)
+{
+    return resolveExport(m_module->findExport(name));
+}
+
+Value Instance::resolveExport(const char* name, size_t length)
+{
+    return resolveExport(m_module->findExport(name, length));
+}
+
 } // namespace Walrus
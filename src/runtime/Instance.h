@@ -26,11 +26,15 @@ class Module;
 class Function;
 class Memory;
 class Table;
+class ElementSegment;
+class ModuleExport;
+class InstanceSnapshot;
 
 class Instance : public gc {
     friend class Module;
     Instance(Module* module)
         : m_module(module)
+        , m_snapshot(nullptr)
     {
     }
 
@@ -39,18 +43,61 @@ public:
 
     Module* module() const { return m_module; }
 
-    Function* function(uint32_t index) const { return m_function[index]; }
+    // defined functions are created when they are used first
+    Function* function(uint32_t index)
+    {
+        Function* function = m_function[index];
+        if (UNLIKELY(!function)) {
+            function = createFunction(index);
+        }
+        return function;
+    }
     Memory* memory(uint32_t index) const { return m_memory[index]; }
     Table* table(uint32_t index) const { return m_table[index]; }
+    ElementSegment* elementSegment(uint32_t index) const { return m_elementSegment[index]; }
     Value& global(uint32_t index) { return m_global[index]; }
     Value resolveExport(String* name);
+    // does not allocate a String for the name
+    Value resolveExport(const char* name, size_t length);
+
+    // inline cache of the last callee of a call_indirect site
+    // table versions start from 1, so an empty cache never hits
+    struct CallIndirectCache {
+        uint64_t m_tableVersion;
+        uint32_t m_elementIndex;
+        Function* m_function;
+    };
+
+    // an instance runs on one thread at a time, so its caches are not shared
+    // the reference is invalidated by calls into the instance
+    CallIndirectCache& callIndirectCache(uint32_t index)
+    {
+        if (UNLIKELY(index >= m_callIndirectCache.size())) {
+            growCallIndirectCache();
+        }
+        return m_callIndirectCache[index];
+    }
+
+    // saves the state of memories, tables, globals and element segments, which reset() restores
+    // the objects of the instance are restored in place and reused, so references to them stay valid
+    void saveSnapshot();
+    // must not be called while the instance is executing, since memories may shrink
+    void reset();
 
 private:
+    Value resolveExport(Optional<ModuleExport*> moduleExport);
+    Function* createFunction(uint32_t index);
+    void growCallIndirectCache();
+
     Module* m_module;
     Vector<Function*, GCUtil::gc_malloc_allocator<Function*>> m_function;
     Vector<Memory*, GCUtil::gc_malloc_allocator<Memory*>> m_memory;
     Vector<Table*, GCUtil::gc_malloc_allocator<Table*>> m_table;
+    Vector<ElementSegment*, GCUtil::gc_malloc_allocator<ElementSegment*>> m_elementSegment;
     ValueVector m_global;
+    // indexed by CallIndirect::cacheIndex, grows as functions are compiled lazily
+    Vector<CallIndirectCache, GCUtil::gc_malloc_allocator<CallIndirectCache>> m_callIndirectCache;
+    InstanceSnapshot* m_snapshot;
 };
 
 } // namespace Walrus
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Walrus.h"
+
+#include "runtime/InstancePool.h"
+#include "runtime/Module.h"
+
+namespace Walrus {
+
+InstancePool::InstancePool(Module* module, const ValueVector& imports)
+    : m_module(module)
+    , m_imports(imports)
+{
+    GC_REGISTER_FINALIZER_NO_ORDER(this, [](void* obj, void* cd) {
+        InstancePool* pool = reinterpret_cast<InstancePool*>(obj);
+        pool->m_lock.~mutex();
+    },
+                                   nullptr, nullptr, nullptr);
+}
+
+Instance* InstancePool::instantiate()
+{
+    Instance* instance = m_module->instantiate(m_imports);
+    instance->saveSnapshot();
+    return instance;
+}
+
+Instance* InstancePool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_instances.size()) {
+            Instance* instance = m_instances.back();
+            m_instances.pop_back();
+            return instance;
+        }
+    }
+    return instantiate();
+}
+
+void InstancePool::release(Instance* instance)
+{
+    ASSERT(instance->module() == m_module);
+    instance->reset();
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_instances.pushBack(instance);
+}
+
+void InstancePool::reserve(size_t count)
+{
+    while (size() < count) {
+        Instance* instance = instantiate();
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_instances.pushBack(instance);
+    }
+}
+
+} // namespace Walrus
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusInstancePool__
+#define __WalrusInstancePool__
+
+#include <mutex>
+#include "runtime/Instance.h"
+
+namespace Walrus {
+
+// keeps instances of a module for reuse, e.g. one instance per request
+// a released instance is reset to its state after instantiation instead of instantiating the module again
+// so instantiation (including the start function) must give the same state every time
+// the pool can be used by several threads, e.g. one instance per request on a thread pool
+class InstancePool : public gc {
+public:
+    InstancePool(Module* module, const ValueVector& imports);
+
+    Module* module() const { return m_module; }
+
+    // instantiates the module when the pool is empty
+    Instance* acquire();
+    // the instance must be acquired from this pool, and must not be used after release
+    // the instance is reset here, so no function of it may be running (e.g. release from a host function it called)
+    void release(Instance* instance);
+
+    // instantiates count instances in advance
+    void reserve(size_t count);
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_instances.size();
+    }
+
+private:
+    Instance* instantiate();
+
+    Module* m_module;
+    ValueVector m_imports;
+    // instances are instantiated and reset without holding the lock
+    mutable std::mutex m_lock;
+    Instance::InstanceVector m_instances;
+};
+
+} // namespace Walrus
+
+#endif // __WalrusInstancePool__
@@ -16,35 +16,348 @@
 #include "Walrus.h"
 
 #include "Memory.h"
+#include "runtime/Trap.h"
+
+#include <mutex>
+#include <chrono>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#endif
 
 namespace Walrus {
 
-Memory::Memory(size_t initialSizeInByte, size_t maximumSizeInByte)
+// shared memory reserves its maximum size upfront, so growing never moves the buffer
+// calloc maps fresh zero pages for large sizes, so only the touched pages are committed
+Memory::Memory(size_t initialSizeInByte, size_t maximumSizeInByte, bool isShared, bool useHugePage)
     : m_sizeInByte(initialSizeInByte)
     , m_maximumSizeInByte(maximumSizeInByte)
-    , m_buffer(reinterpret_cast<uint8_t*>(calloc(1, initialSizeInByte)))
+    , m_buffer(nullptr)
+    , m_isShared(isShared)
+    , m_useHugePage(useHugePage)
 {
+    m_buffer = allocateBuffer(isShared ? maximumSizeInByte : initialSizeInByte);
     RELEASE_ASSERT(m_buffer);
     GC_REGISTER_FINALIZER_NO_ORDER(this, [](void* obj, void* cd) {
-        free(reinterpret_cast<Memory*>(obj)->m_buffer);
+        Memory* memory = reinterpret_cast<Memory*>(obj);
+        memory->freeBuffer(memory->m_buffer, memory->m_isShared ? memory->m_maximumSizeInByte : memory->m_sizeInByte);
     },
                                    nullptr, nullptr, nullptr);
 }
 
-bool Memory::grow(size_t growSizeInByte)
+bool Memory::grow(uint64_t growSizeInByte, size_t* oldSizeInByte)
 {
-    size_t newSizeInByte = growSizeInByte + m_sizeInByte;
-    if (newSizeInByte > m_sizeInByte && newSizeInByte <= m_maximumSizeInByte) {
-        uint8_t* newBuffer = reinterpret_cast<uint8_t*>(calloc(1, newSizeInByte));
-        if (newBuffer) {
-            memcpy(newBuffer, m_buffer, m_sizeInByte);
-            free(m_buffer);
-            m_buffer = newBuffer;
-            m_sizeInByte = newSizeInByte;
-            return true;
+    if (m_isShared) {
+        // concurrent grows are serialized by the compare-exchange, each of them sees a different old size
+        size_t sizeInByte = __atomic_load_n(&m_sizeInByte, __ATOMIC_RELAXED);
+        do {
+            if (growSizeInByte > m_maximumSizeInByte - sizeInByte) {
+                return false;
+            }
+        } while (!__atomic_compare_exchange_n(&m_sizeInByte, &sizeInByte, sizeInByte + growSizeInByte, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+        if (oldSizeInByte) {
+            *oldSizeInByte = sizeInByte;
         }
+        return true;
+    }
+
+    if (growSizeInByte > m_maximumSizeInByte - m_sizeInByte) {
+        return false;
+    }
+
+    if (oldSizeInByte) {
+        *oldSizeInByte = m_sizeInByte;
+    }
+
+    if (!growSizeInByte) {
+        return true;
+    }
+
+    size_t newSizeInByte = growSizeInByte + m_sizeInByte;
+
+    uint8_t* newBuffer = allocateBuffer(newSizeInByte);
+    if (newBuffer) {
+        memcpy(newBuffer, m_buffer, m_sizeInByte);
+        freeBuffer(m_buffer, m_sizeInByte);
+        m_buffer = newBuffer;
+        m_sizeInByte = newSizeInByte;
+        return true;
     }
     return false;
 }
 
+bool Memory::discard(uint64_t offset, uint64_t sizeInByte)
+{
+    size_t currentSizeInByte = this->sizeInByte();
+    if (offset % s_memoryPageSize || sizeInByte % s_memoryPageSize || offset > currentSizeInByte || sizeInByte > currentSizeInByte - offset) {
+        return false;
+    }
+
+    uint8_t* start = m_buffer + offset;
+    uint8_t* end = start + sizeInByte;
+#if defined(__linux__)
+    // the buffer itself is not necessarily aligned to the OS page size, only the
+    // OS pages fully inside the range are dropped and the rest is cleared by hand
+    const uintptr_t osPageSize = sysconf(_SC_PAGESIZE);
+    uint8_t* alignedStart = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(start) + osPageSize - 1) & ~(osPageSize - 1));
+    uint8_t* alignedEnd = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(end) & ~(osPageSize - 1));
+    // private anonymous pages read back as zero after MADV_DONTNEED
+    if (alignedStart < alignedEnd && !madvise(alignedStart, alignedEnd - alignedStart, MADV_DONTNEED)) {
+        memset(start, 0, alignedStart - start);
+        memset(alignedEnd, 0, end - alignedEnd);
+        return true;
+    }
+#endif
+    memset(start, 0, end - start);
+    return true;
+}
+
+void Memory::reset(size_t sizeInByte)
+{
+    ASSERT(sizeInByte % s_memoryPageSize == 0);
+    if (m_isShared || m_sizeInByte == sizeInByte) {
+        ASSERT(sizeInByte <= m_sizeInByte);
+        discard(0, m_sizeInByte);
+        __atomic_store_n(&m_sizeInByte, sizeInByte, __ATOMIC_RELEASE);
+        return;
+    }
+
+    ASSERT(sizeInByte < m_sizeInByte);
+    freeBuffer(m_buffer, m_sizeInByte);
+    m_buffer = allocateBuffer(sizeInByte);
+    RELEASE_ASSERT(m_buffer);
+    m_sizeInByte = sizeInByte;
+}
+
+Memory::Statistics Memory::statistics() const
+{
+    Statistics stat;
+    stat.committedSizeInByte = m_isShared ? m_maximumSizeInByte : m_sizeInByte;
+    stat.residentSizeInByte = stat.committedSizeInByte;
+#if defined(__linux__)
+    if (!stat.committedSizeInByte) {
+        return stat;
+    }
+
+    const uintptr_t osPageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t start = reinterpret_cast<uintptr_t>(m_buffer);
+    uintptr_t end = start + stat.committedSizeInByte;
+    uintptr_t alignedStart = start & ~(osPageSize - 1);
+    size_t pageCount = (end - alignedStart + osPageSize - 1) / osPageSize;
+    std::vector<unsigned char> residency(pageCount);
+    if (mincore(reinterpret_cast<void*>(alignedStart), end - alignedStart, residency.data())) {
+        return stat;
+    }
+
+    size_t resident = 0;
+    for (size_t i = 0; i < pageCount; i++) {
+        if (residency[i] & 1) {
+            // the first and last pages can be partially covered by the buffer
+            uintptr_t pageStart = std::max(alignedStart + i * osPageSize, start);
+            uintptr_t pageEnd = std::min(alignedStart + (i + 1) * osPageSize, end);
+            resident += pageEnd - pageStart;
+        }
+    }
+    stat.residentSizeInByte = resident;
+#endif
+    return stat;
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+// Huge page backed buffers are mapped directly and aligned to the huge page size,
+// otherwise the kernel cannot use huge pages for the head and tail of the buffer.
+// Both allocateBuffer and freeBuffer take the same decision from the buffer size.
+static bool shouldUseHugePage(bool useHugePage, size_t sizeInByte)
+{
+    return useHugePage && sizeInByte >= Memory::s_hugePageSize;
+}
+#endif
+
+uint8_t* Memory::allocateBuffer(size_t sizeInByte) const
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (shouldUseHugePage(m_useHugePage, sizeInByte)) {
+        size_t alignedSize = (sizeInByte + s_hugePageSize - 1) & ~(s_hugePageSize - 1);
+        // over-allocate by one huge page, then unmap the unaligned head and tail
+        uint8_t* ptr = reinterpret_cast<uint8_t*>(mmap(nullptr, alignedSize + s_hugePageSize, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+        uint8_t* alignedPtr = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(ptr) + s_hugePageSize - 1) & ~(s_hugePageSize - 1));
+        size_t headSize = alignedPtr - ptr;
+        if (headSize) {
+            munmap(ptr, headSize);
+        }
+        munmap(alignedPtr + alignedSize, s_hugePageSize - headSize);
+        // not fatal if the kernel does not support transparent huge pages
+        madvise(alignedPtr, alignedSize, MADV_HUGEPAGE);
+        return alignedPtr;
+    }
+#endif
+    return reinterpret_cast<uint8_t*>(calloc(1, sizeInByte));
+}
+
+void Memory::freeBuffer(uint8_t* buffer, size_t sizeInByte) const
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (shouldUseHugePage(m_useHugePage, sizeInByte)) {
+        munmap(buffer, (sizeInByte + s_hugePageSize - 1) & ~(s_hugePageSize - 1));
+        return;
+    }
+#endif
+    free(buffer);
+}
+
+NEVER_INLINE void Memory::throwException()
+{
+    Trap::throwException(new String("out of bounds memory access"));
+}
+
+NEVER_INLINE void Memory::throwUnalignedAtomicException()
+{
+    Trap::throwException(new String("unaligned atomic"));
+}
+
+// Threads blocked in memory.atomic.wait are parked in a global FIFO list keyed by
+// the host address of the waited location. On linux every waiter sleeps on its own
+// futex word, so memory.atomic.notify can wake exactly the requested number of waiters.
+struct AtomicWaiter {
+    AtomicWaiter(void* address)
+        : m_address(address)
+        , m_notified(0)
+        , m_next(nullptr)
+    {
+    }
+
+    void* m_address;
+    uint32_t m_notified;
+    AtomicWaiter* m_next;
+#if !defined(__linux__)
+    std::condition_variable m_condition;
+#endif
+};
+
+static std::mutex g_atomicWaiterLock;
+static AtomicWaiter* g_atomicWaiterHead;
+
+static void removeAtomicWaiter(AtomicWaiter* waiter)
+{
+    for (AtomicWaiter** w = &g_atomicWaiterHead; *w; w = &(*w)->m_next) {
+        if (*w == waiter) {
+            *w = waiter->m_next;
+            return;
+        }
+    }
+}
+
+// returns true when the waiter was notified, false on timeout
+static bool sleepAtomicWaiter(std::unique_lock<std::mutex>& lock, AtomicWaiter& waiter, int64_t timeout)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (!waiter.m_notified) {
+        std::chrono::nanoseconds remaining(0);
+        if (timeout >= 0) {
+            // computed from the elapsed time, since start + timeout can overflow the clock
+            remaining = std::chrono::nanoseconds(timeout) - std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            if (remaining.count() <= 0) {
+                return false;
+            }
+        }
+#if defined(__linux__)
+        struct timespec ts;
+        ts.tv_sec = remaining.count() / 1000000000;
+        ts.tv_nsec = remaining.count() % 1000000000;
+        lock.unlock();
+        // the notifier sets m_notified under the lock, so the kernel only puts
+        // us to sleep if the notification has not been delivered yet
+        syscall(SYS_futex, &waiter.m_notified, FUTEX_WAIT_PRIVATE, 0, timeout >= 0 ? &ts : nullptr, nullptr, 0);
+        lock.lock();
+#else
+        if (timeout >= 0) {
+            waiter.m_condition.wait_for(lock, remaining);
+        } else {
+            waiter.m_condition.wait(lock);
+        }
+#endif
+    }
+    return true;
+}
+
+template <typename T>
+uint32_t Memory::atomicWait(T* address, T expected, int64_t timeout) const
+{
+    std::unique_lock<std::mutex> lock(g_atomicWaiterLock);
+    // atomic stores do not take the lock, but notifiers do, so a store and
+    // notify after this comparison cannot be missed
+    if (__atomic_load_n(address, __ATOMIC_SEQ_CST) != expected) {
+        return AtomicWaitNotEqual;
+    }
+
+    AtomicWaiter waiter(address);
+    AtomicWaiter** tail = &g_atomicWaiterHead;
+    while (*tail) {
+        tail = &(*tail)->m_next;
+    }
+    *tail = &waiter;
+
+    if (!sleepAtomicWaiter(lock, waiter, timeout)) {
+        removeAtomicWaiter(&waiter);
+        return AtomicWaitTimedOut;
+    }
+    return AtomicWaitOk;
+}
+
+uint32_t Memory::atomicWait(uint32_t offset, uint32_t addend, uint32_t expected, int64_t timeout) const
+{
+    uint32_t* address = atomicAddress<uint32_t>(offset, addend);
+    if (UNLIKELY(!m_isShared)) {
+        Trap::throwException(new String("expected shared memory"));
+    }
+    return atomicWait(address, expected, timeout);
+}
+
+uint32_t Memory::atomicWait(uint32_t offset, uint32_t addend, uint64_t expected, int64_t timeout) const
+{
+    uint64_t* address = atomicAddress<uint64_t>(offset, addend);
+    if (UNLIKELY(!m_isShared)) {
+        Trap::throwException(new String("expected shared memory"));
+    }
+    return atomicWait(address, expected, timeout);
+}
+
+uint32_t Memory::atomicNotify(uint32_t offset, uint32_t addend, uint32_t count) const
+{
+    uint32_t* address = atomicAddress<uint32_t>(offset, addend);
+    if (!m_isShared) {
+        // nobody can wait on an unshared memory
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> guard(g_atomicWaiterLock);
+    uint32_t woken = 0;
+    AtomicWaiter** w = &g_atomicWaiterHead;
+    while (*w && woken < count) {
+        AtomicWaiter* waiter = *w;
+        if (waiter->m_address != address) {
+            w = &waiter->m_next;
+            continue;
+        }
+        *w = waiter->m_next;
+        waiter->m_notified = 1;
+#if defined(__linux__)
+        syscall(SYS_futex, &waiter->m_notified, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+        waiter->m_condition.notify_one();
+#endif
+        woken++;
+    }
+    return woken;
+}
+
 } // namespace Walrus
@@ -21,16 +21,18 @@ namespace Walrus {
 
 class Memory : public gc {
 public:
-    Memory(size_t initialSizeInByte, size_t maximumSizeInByte = std::numeric_limits<size_t>::max());
+    Memory(size_t initialSizeInByte, size_t maximumSizeInByte = std::numeric_limits<size_t>::max(), bool isShared = false, bool useHugePage = false);
     static const size_t s_memoryPageSize = 1024 * 64;
+    static const size_t s_hugePageSize = 1024 * 1024 * 2;
     uint8_t* buffer() const
     {
         return m_buffer;
     }
 
+    // other threads can grow a shared memory, the size is published with release ordering
     size_t sizeInByte() const
     {
-        return m_sizeInByte;
+        return __atomic_load_n(&m_sizeInByte, __ATOMIC_ACQUIRE);
     }
 
     size_t sizeInPageSize() const
@@ -43,12 +45,157 @@ public:
         return m_maximumSizeInByte;
     }
 
-    bool grow(size_t growSizeInByte);
+    // the buffer of a shared memory is never relocated, other threads can access it while growing
+    bool isShared() const
+    {
+        return m_isShared;
+    }
+
+    // oldSizeInByte receives the size before this grow, which is the size memory.grow returns
+    // even when other threads grow a shared memory at the same time
+    bool grow(uint64_t growSizeInByte, size_t* oldSizeInByte = nullptr);
+
+    // Zero [offset, offset + sizeInByte) and return its pages to the OS, so
+    // the memory does not stay resident at its peak size. Both values must be
+    // aligned to the wasm page size. Returns false for invalid ranges.
+    bool discard(uint64_t offset, uint64_t sizeInByte);
+
+    // shrinks the memory back to sizeInByte, and zeroes it like discard
+    // the buffer is only reallocated if the memory has grown
+    // must not be called while the instance of the memory is executing (see loadUnchecked)
+    void reset(size_t sizeInByte);
+
+    struct Statistics {
+        // bytes allocated for the buffer, including the reserved part of shared memories
+        size_t committedSizeInByte;
+        // bytes of the buffer backed by physical pages (equals committedSizeInByte if unknown)
+        size_t residentSizeInByte;
+    };
+
+    Statistics statistics() const;
+
+    // memory32 address(offset) and static offset(addend) are both 32-bit,
+    // so the end of the access cannot overflow in 64-bit arithmetic
+    template <typename T>
+    void load(uint32_t offset, uint32_t addend, T* out) const
+    {
+        checkAccess(offset, addend, sizeof(T));
+        memcpy(out, m_buffer + (static_cast<uint64_t>(offset) + addend), sizeof(T));
+    }
+
+    template <typename T>
+    void store(uint32_t offset, uint32_t addend, const T& val) const
+    {
+        checkAccess(offset, addend, sizeof(T));
+        memcpy(m_buffer + (static_cast<uint64_t>(offset) + addend), &val, sizeof(T));
+    }
+
+    // used when an earlier access of the running function has proven that the access is in bounds,
+    // which stays true since a memory only shrinks by reset, and reset never runs while its instance is executing
+    template <typename T>
+    void loadUnchecked(uint32_t offset, uint32_t addend, T* out) const
+    {
+        ASSERT(static_cast<uint64_t>(offset) + addend + sizeof(T) <= sizeInByte());
+        memcpy(out, m_buffer + (static_cast<uint64_t>(offset) + addend), sizeof(T));
+    }
+
+    template <typename T>
+    void storeUnchecked(uint32_t offset, uint32_t addend, const T& val) const
+    {
+        ASSERT(static_cast<uint64_t>(offset) + addend + sizeof(T) <= sizeInByte());
+        memcpy(m_buffer + (static_cast<uint64_t>(offset) + addend), &val, sizeof(T));
+    }
+
+    // memory64 address and static offset can wrap around in 64-bit arithmetic
+    // and the memory can be larger than 4GiB, so we cannot rely on the 32-bit trick above
+    template <typename T>
+    void load64(uint64_t offset, uint64_t addend, T* out) const
+    {
+        checkAccess64(offset, addend, sizeof(T));
+        memcpy(out, m_buffer + (offset + addend), sizeof(T));
+    }
+
+    template <typename T>
+    void store64(uint64_t offset, uint64_t addend, const T& val) const
+    {
+        checkAccess64(offset, addend, sizeof(T));
+        memcpy(m_buffer + (offset + addend), &val, sizeof(T));
+    }
+
+    // atomic accesses must be naturally aligned, so they can be performed by
+    // the atomic instructions of the host directly on the buffer
+    template <typename T>
+    T* atomicAddress(uint32_t offset, uint32_t addend) const
+    {
+        checkAccess(offset, addend, sizeof(T));
+        uint64_t address = static_cast<uint64_t>(offset) + addend;
+        if (UNLIKELY(address % sizeof(T))) {
+            throwUnalignedAtomicException();
+        }
+        return reinterpret_cast<T*>(m_buffer + address);
+    }
+
+    template <typename T>
+    void atomicLoad(uint32_t offset, uint32_t addend, T* out) const
+    {
+        *out = __atomic_load_n(atomicAddress<T>(offset, addend), __ATOMIC_SEQ_CST);
+    }
+
+    template <typename T>
+    void atomicStore(uint32_t offset, uint32_t addend, const T& val) const
+    {
+        __atomic_store_n(atomicAddress<T>(offset, addend), val, __ATOMIC_SEQ_CST);
+    }
+
+    enum AtomicWaitResult : uint32_t {
+        AtomicWaitOk = 0,
+        AtomicWaitNotEqual = 1,
+        AtomicWaitTimedOut = 2,
+    };
+
+    // timeout is in nanoseconds, negative value means infinite wait
+    uint32_t atomicWait(uint32_t offset, uint32_t addend, uint32_t expected, int64_t timeout) const;
+    uint32_t atomicWait(uint32_t offset, uint32_t addend, uint64_t expected, int64_t timeout) const;
+    uint32_t atomicNotify(uint32_t offset, uint32_t addend, uint32_t count) const;
 
 private:
+    // the buffer of a shared memory does not move and is zeroed up to its maximum size,
+    // so a bounds check only needs to see some size which was set by grow
+    size_t accessibleSizeInByte() const
+    {
+        return __atomic_load_n(&m_sizeInByte, __ATOMIC_RELAXED);
+    }
+
+    inline void checkAccess(uint32_t offset, uint32_t addend, uint32_t size) const
+    {
+        if (UNLIKELY(static_cast<uint64_t>(offset) + addend + size > accessibleSizeInByte())) {
+            throwException();
+        }
+    }
+
+    inline void checkAccess64(uint64_t offset, uint64_t addend, uint64_t size) const
+    {
+        size_t sizeInByte = accessibleSizeInByte();
+        if (UNLIKELY(size > sizeInByte || addend > sizeInByte - size || offset > sizeInByte - size - addend)) {
+            throwException();
+        }
+    }
+
+    static void throwException();
+    static void throwUnalignedAtomicException();
+
+    template <typename T>
+    uint32_t atomicWait(T* address, T expected, int64_t timeout) const;
+
+    uint8_t* allocateBuffer(size_t sizeInByte) const;
+    void freeBuffer(uint8_t* buffer, size_t sizeInByte) const;
+
+    // only changed by grow and reset, with atomic operations for shared memories
     size_t m_sizeInByte;
     size_t m_maximumSizeInByte;
     uint8_t* m_buffer;
+    bool m_isShared;
+    bool m_useHugePage;
 };
 
 } // namespace Walrus
@@ -23,10 +23,201 @@
 #include "runtime/Memory.h"
 #include "runtime/Table.h"
 #include "interpreter/ByteCode.h"
-#include "interpreter/Interpreter.h"
+#include "parser/WASMParser.h"
 
 namespace Walrus {
 
+constexpr uint32_t FunctionType::s_invalidCanonicalIndex;
+constexpr uint32_t FunctionType::s_noModuleIndex;
+constexpr uint32_t ModuleElement::s_nullFunctionIndex;
+
+bool ConstExpression::append(Opcode opcode, uint64_t operand)
+{
+    switch (opcode) {
+    case I32Const:
+    case I64Const:
+    case F32Const:
+    case F64Const:
+    case RefNull:
+    case RefFunc:
+    case GlobalGet:
+        m_stackDepth++;
+        m_maxStackDepth = std::max(m_maxStackDepth, m_stackDepth);
+        break;
+    case I32Add:
+    case I32Sub:
+    case I32Mul:
+    case I64Add:
+    case I64Sub:
+    case I64Mul:
+        if (m_stackDepth < 2) {
+            return false;
+        }
+        m_stackDepth--;
+        break;
+    default:
+        return false;
+    }
+
+    m_instruction.pushBack({ opcode, operand });
+    return true;
+}
+
+Value ConstExpression::evaluate(Instance* instance) const
+{
+    ASSERT(isComplete());
+    Value* stack = ALLOCA(sizeof(Value) * m_maxStackDepth, Value);
+    size_t stackSize = 0;
+
+    for (size_t i = 0; i < m_instruction.size(); i++) {
+        uint64_t operand = m_instruction[i].m_operand;
+        switch (m_instruction[i].m_opcode) {
+        case I32Const:
+            stack[stackSize++] = Value(static_cast<int32_t>(operand));
+            break;
+        case I64Const:
+            stack[stackSize++] = Value(static_cast<int64_t>(operand));
+            break;
+        case F32Const: {
+            // copied by bits to keep NaN payloads
+            uint32_t bits = static_cast<uint32_t>(operand);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            stack[stackSize++] = Value(value);
+            break;
+        }
+        case F64Const: {
+            double value;
+            memcpy(&value, &operand, sizeof(value));
+            stack[stackSize++] = Value(value);
+            break;
+        }
+        case RefNull:
+            stack[stackSize++] = Value(static_cast<Value::Type>(operand));
+            break;
+        case RefFunc:
+            stack[stackSize++] = Value(instance->function(operand));
+            break;
+        case GlobalGet:
+            stack[stackSize++] = instance->global(operand);
+            break;
+        // wasm integer arithmetic wraps around, so it is done on unsigned values
+        case I32Add:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int32_t>(static_cast<uint32_t>(stack[stackSize - 1].asI32()) + static_cast<uint32_t>(stack[stackSize].asI32())));
+            break;
+        case I32Sub:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int32_t>(static_cast<uint32_t>(stack[stackSize - 1].asI32()) - static_cast<uint32_t>(stack[stackSize].asI32())));
+            break;
+        case I32Mul:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int32_t>(static_cast<uint32_t>(stack[stackSize - 1].asI32()) * static_cast<uint32_t>(stack[stackSize].asI32())));
+            break;
+        case I64Add:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int64_t>(static_cast<uint64_t>(stack[stackSize - 1].asI64()) + static_cast<uint64_t>(stack[stackSize].asI64())));
+            break;
+        case I64Sub:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int64_t>(static_cast<uint64_t>(stack[stackSize - 1].asI64()) - static_cast<uint64_t>(stack[stackSize].asI64())));
+            break;
+        case I64Mul:
+            stackSize--;
+            stack[stackSize - 1] = Value(static_cast<int64_t>(static_cast<uint64_t>(stack[stackSize - 1].asI64()) * static_cast<uint64_t>(stack[stackSize].asI64())));
+            break;
+        default:
+            RELEASE_ASSERT_NOT_REACHED();
+        }
+    }
+
+    ASSERT(stackSize == 1);
+    return stack[0];
+}
+
+bool ModuleFunction::compile()
+{
+    std::call_once(m_compileOnce, [this]() {
+        if (WASMParser::compileFunction(this)) {
+            m_isCompiled.store(true, std::memory_order_release);
+        }
+    });
+    return isCompiled();
+}
+
+void ModuleFunction::commitByteCode(const uint8_t* byteCode, size_t size)
+{
+    ASSERT(!m_byteCode);
+    m_byteCode = reinterpret_cast<uint8_t*>(GC_MALLOC_ATOMIC(size));
+    memcpy(m_byteCode, byteCode, size);
+    m_byteCodeSize = size;
+    m_module->m_compiledByteCodeSize.fetch_add(size, std::memory_order_relaxed);
+}
+
+NEVER_INLINE void ModuleFunction::throwInvalidBodyException()
+{
+    Trap::throwException(new String("invalid function body"));
+}
+
+void Module::readNameSection()
+{
+    std::call_once(m_readNameSectionOnce, [this]() {
+        WASMParser::readNameSection(this);
+        m_nameSection.clear();
+        m_hasUnreadNameSection.store(false, std::memory_order_release);
+    });
+}
+
+
+void Module::reserveExport(size_t count)
+{
+    ASSERT(m_export.size() == 0);
+    m_export.reserve(count);
+
+    size_t tableSize = 1;
+    while (tableSize < count * 2) {
+        tableSize <<= 1;
+    }
+    m_exportTable.resize(tableSize, nullptr);
+}
+
+void Module::appendExport(ModuleExport* moduleExport)
+{
+    ASSERT(m_export.size() < m_exportTable.size() / 2);
+    m_export.pushBack(moduleExport);
+
+    size_t mask = m_exportTable.size() - 1;
+    size_t index = moduleExport->name()->hash() & mask;
+    while (m_exportTable[index]) {
+        index = (index + 1) & mask;
+    }
+    m_exportTable[index] = moduleExport;
+}
+
+Optional<ModuleExport*> Module::findExport(String* name) const
+{
+    size_t mask = m_exportTable.size() - 1;
+    for (size_t index = name->hash() & mask; m_exportTable.size() && m_exportTable[index]; index = (index + 1) & mask) {
+        if (m_exportTable[index]->name()->equals(name)) {
+            return m_exportTable[index];
+        }
+    }
+    return nullptr;
+}
+
+Optional<ModuleExport*> Module::findExport(const char* name, size_t length) const
+{
+    size_t hash = String::hash(name, length);
+    size_t mask = m_exportTable.size() - 1;
+    for (size_t index = hash & mask; m_exportTable.size() && m_exportTable[index]; index = (index + 1) & mask) {
+        String* exportName = m_exportTable[index]->name();
+        if (exportName->hash() == hash && exportName->equals(name, length)) {
+            return m_exportTable[index];
+        }
+    }
+    return nullptr;
+}
+
 Instance* Module::instantiate(const ValueVector& imports)
 {
     Instance* instance = new Instance(this);
@@ -55,18 +246,15 @@ Instance* Module::instantiate(const ValueVector& imports)
         }
     }
 
-    // init defined function
-    for (size_t i = 0; i < m_function.size(); i++) {
-        auto idx = m_function[i]->functionIndex();
-        if (!instance->m_function[idx]) {
-            // TODO if there is no function at function(idx), throw exception
-            instance->m_function[idx] = new DefinedFunction(m_store, functionType(m_function[i]->functionTypeIndex()), instance, function(idx));
-        }
-    }
-
     // init memory
+    bool useHugePage = m_store->engine()->useHugePageForMemory();
     for (size_t i = 0; i < m_memory.size(); i++) {
-        instance->m_memory.pushBack(new Memory(m_memory[i].first * Memory::s_memoryPageSize, m_memory[i].second * Memory::s_memoryPageSize));
+        // the maximum size can exceed the host address space(e.g. 4GiB memory32 on 32-bit host or memory64)
+        const uint64_t maximumPageCount = std::numeric_limits<size_t>::max() / Memory::s_memoryPageSize;
+        uint64_t initialSize = std::get<0>(m_memory[i]);
+        uint64_t maximumSize = std::min(std::get<1>(m_memory[i]), maximumPageCount);
+        RELEASE_ASSERT(initialSize <= maximumPageCount);
+        instance->m_memory.pushBack(new Memory(initialSize * Memory::s_memoryPageSize, maximumSize * Memory::s_memoryPageSize, std::get<3>(m_memory[i]), useHugePage));
     }
 
     // init table
@@ -75,7 +263,34 @@ Instance* Module::instantiate(const ValueVector& imports)
     }
 
     // init global
-    if (m_globalInitBlock) {
+    for (size_t i = 0; i < m_globalInit.size(); i++) {
+        if (m_globalInit[i]) {
+            instance->m_global[i] = m_globalInit[i]->evaluate(instance);
+        }
+    }
+
+    // init element segment
+    bool hasActiveElement = false;
+    instance->m_elementSegment.reserve(m_element.size());
+    for (size_t i = 0; i < m_element.size(); i++) {
+        ModuleElement* element = m_element[i];
+        if (element->mode() == ModuleElement::Declarative) {
+            instance->m_elementSegment.pushBack(new ElementSegment(0));
+            continue;
+        }
+
+        const ModuleElement::IndexVector& functionIndex = element->functionIndex();
+        const ModuleElement::IndexVector& signature = element->signature();
+        ElementSegment* segment = new ElementSegment(functionIndex.size());
+        for (size_t j = 0; j < functionIndex.size(); j++) {
+            Function* function = functionIndex[j] == ModuleElement::s_nullFunctionIndex ? nullptr : instance->function(functionIndex[j]);
+            segment->setElement(j, function, signature[j]);
+        }
+        instance->m_elementSegment.pushBack(segment);
+        hasActiveElement |= element->mode() == ModuleElement::Active;
+    }
+
+    if (hasActiveElement) {
         struct RunData {
             Instance* instance;
             Module* module;
@@ -83,22 +298,26 @@ Instance* Module::instantiate(const ValueVector& imports)
         Walrus::Trap trap;
         trap.run([](Walrus::ExecutionState& state, void* d) {
             RunData* data = reinterpret_cast<RunData*>(d);
-            uint8_t* functionStackBase = ALLOCA(data->module->m_globalInitBlock->requiredStackSize(), uint8_t);
-            uint8_t* functionStackPointer = functionStackBase;
+            for (size_t i = 0; i < data->module->m_element.size(); i++) {
+                ModuleElement* element = data->module->m_element[i];
+                if (element->mode() != ModuleElement::Active) {
+                    continue;
+                }
 
-            FunctionType fakeFunctionType(0, FunctionType::FunctionTypeVector(), FunctionType::FunctionTypeVector());
-            DefinedFunction fakeFunction(data->module->m_store, &fakeFunctionType, data->instance,
-                                         data->module->m_globalInitBlock.value());
-            ExecutionState newState(state, &fakeFunction);
+                uint32_t offset = element->offset()->evaluate(data->instance).asI32();
 
-            Interpreter::interpret(newState, reinterpret_cast<size_t>(data->module->m_globalInitBlock->byteCode()), functionStackBase, functionStackPointer);
+                // active segments are dropped after they are copied into the table
+                ElementSegment* segment = data->instance->m_elementSegment[i];
+                data->instance->m_table[element->tableIndex()]->init(segment, offset, 0, segment->size());
+                segment->drop();
+            }
         },
                  &data);
     }
 
     if (m_seenStartAttribute) {
-        ASSERT(instance->m_function[m_start]->functionType()->param().size() == 0);
-        ASSERT(instance->m_function[m_start]->functionType()->result().size() == 0);
+        ASSERT(instance->function(m_start)->functionType()->param().size() == 0);
+        ASSERT(instance->function(m_start)->functionType()->result().size() == 0);
         struct RunData {
             Instance* instance;
             Module* module;
@@ -106,7 +325,7 @@ Instance* Module::instantiate(const ValueVector& imports)
         Walrus::Trap trap;
         trap.run([](Walrus::ExecutionState& state, void* d) {
             RunData* data = reinterpret_cast<RunData*>(d);
-            data->instance->m_function[data->module->m_start]->call(state, 0, nullptr, nullptr);
+            data->instance->function(data->module->m_start)->call(state, 0, nullptr, nullptr);
         },
                  &data);
     }
@@ -121,8 +340,8 @@ void ModuleFunction::dumpByteCode()
     printf("requiredStackSize %u, requiredStackSizeDueToLocal %u\n", m_requiredStackSize, m_requiredStackSizeDueToLocal);
 
     size_t idx = 0;
-    while (idx < m_byteCode.size()) {
-        ByteCode* code = reinterpret_cast<ByteCode*>(&m_byteCode[idx]);
+    while (idx < m_byteCodeSize) {
+        ByteCode* code = reinterpret_cast<ByteCode*>(m_byteCode + idx);
         printf("%zu: ", idx);
         printf("%s ", g_byteCodeInfo[code->opcode()].m_name);
         code->dump(idx);
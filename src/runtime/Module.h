@@ -17,9 +17,13 @@
 #ifndef __WalrusModule__
 #define __WalrusModule__
 
+#include <atomic>
+#include <mutex>
 #include <numeric>
 #include "runtime/Value.h"
+#include "runtime/FunctionType.h"
 #include "util/Vector.h"
+#include "parser/ParseOptions.h"
 
 namespace wabt {
 class WASMBinaryReader;
@@ -30,48 +34,8 @@ namespace Walrus {
 class Store;
 class Module;
 class Instance;
-
-class FunctionType : public gc {
-public:
-    typedef Vector<Value::Type, GCUtil::gc_malloc_atomic_allocator<Value::Type>>
-        FunctionTypeVector;
-    FunctionType(uint32_t index,
-                 FunctionTypeVector&& param,
-                 FunctionTypeVector&& result)
-        : m_index(index)
-        , m_param(std::move(param))
-        , m_result(std::move(result))
-        , m_paramStackSize(computeStackSize(m_param))
-        , m_resultStackSize(computeStackSize(m_result))
-    {
-    }
-
-    uint32_t index() const { return m_index; }
-
-    const FunctionTypeVector& param() const { return m_param; }
-
-    const FunctionTypeVector& result() const { return m_result; }
-
-    size_t paramStackSize() const { return m_paramStackSize; }
-
-    size_t resultStackSize() const { return m_resultStackSize; }
-
-private:
-    uint32_t m_index;
-    FunctionTypeVector m_param;
-    FunctionTypeVector m_result;
-    size_t m_paramStackSize;
-    size_t m_resultStackSize;
-
-    static size_t computeStackSize(const FunctionTypeVector& v)
-    {
-        size_t s = 0;
-        for (size_t i = 0; i < v.size(); i++) {
-            s += valueSizeInStack(v[i]);
-        }
-        return s;
-    }
-};
+class WASMParser;
+class ModuleCache;
 
 // https://webassembly.github.io/spec/core/syntax/modules.html#syntax-import
 class ModuleImport : public gc {
@@ -189,6 +153,8 @@ private:
 
 class ModuleFunction : public gc {
     friend class wabt::WASMBinaryReader;
+    friend class WASMParser;
+    friend class ModuleCache;
 
 public:
     typedef Vector<Value::Type, GCUtil::gc_malloc_atomic_allocator<Value::Type>>
@@ -200,6 +166,11 @@ public:
         , m_functionTypeIndex(functionTypeIndex)
         , m_requiredStackSize(0)
         , m_requiredStackSizeDueToLocal(0)
+        , m_byteCode(nullptr)
+        , m_byteCodeSize(0)
+        , m_isCompiled(true)
+        , m_bodyOffset(0)
+        , m_bodySize(0)
     {
     }
 
@@ -212,41 +183,30 @@ public:
     uint32_t requiredStackSize() const { return m_requiredStackSize; }
     uint32_t requiredStackSizeDueToLocal() const { return m_requiredStackSizeDueToLocal; }
 
-    template <typename CodeType>
-    void pushByteCode(const CodeType& code)
+    // with lazy compilation, the bytecode is generated when the function is called first
+    bool isCompiled() const { return m_isCompiled.load(std::memory_order_acquire); }
+    // the bodies of trusted modules are only checked when they are compiled(see WASMParser::parseBinary),
+    // so calling an invalid function traps
+    void compileIfNeeded()
     {
-        char* first = (char*)&code;
-        size_t start = m_byteCode.size();
-
-        m_byteCode.resizeWithUninitializedValues(m_byteCode.size() + sizeof(CodeType));
-        for (size_t i = 0; i < sizeof(CodeType); i++) {
-            m_byteCode[start++] = *first;
-            first++;
+        if (UNLIKELY(!isCompiled()) && !compile()) {
+            throwInvalidBodyException();
         }
     }
 
     template <typename CodeType>
     CodeType* peekByteCode(size_t position)
     {
-        return reinterpret_cast<CodeType*>(&m_byteCode[position]);
+        ASSERT(position + sizeof(CodeType) <= m_byteCodeSize);
+        return reinterpret_cast<CodeType*>(m_byteCode + position);
     }
 
-    void expandByteCode(size_t s)
-    {
-        m_byteCode.resizeWithUninitializedValues(m_byteCode.size() + s);
-    }
-
-    void shrinkByteCode(size_t s)
-    {
-        m_byteCode.resize(m_byteCode.size() - s);
-    }
+    // bytecode is emitted by the parser into its own buffer, then copied into exactly sized memory
+    // which is moved into the bytecode arena of the module once every function is compiled
+    void commitByteCode(const uint8_t* byteCode, size_t size);
 
-    size_t currentByteCodeSize() const
-    {
-        return m_byteCode.size();
-    }
-
-    uint8_t* byteCode() { return m_byteCode.data(); }
+    uint8_t* byteCode() { return m_byteCode; }
+    size_t byteCodeSize() const { return m_byteCodeSize; }
 #if !defined(NDEBUG)
     void dumpByteCode();
 #endif
@@ -258,41 +218,160 @@ private:
     uint32_t m_requiredStackSize;
     uint32_t m_requiredStackSizeDueToLocal;
     LocalValueVector m_local;
-    Vector<uint8_t, GCUtil::gc_malloc_atomic_allocator<uint8_t>> m_byteCode;
+    uint8_t* m_byteCode;
+    size_t m_byteCodeSize;
+    // positions of CallIndirect bytecodes, which hold a FunctionType pointer
+    Vector<uint32_t, GCUtil::gc_malloc_atomic_allocator<uint32_t>> m_callIndirectPosition;
+
+    // returns false when the body is rejected
+    bool compile();
+    static void throwInvalidBodyException();
+    std::atomic<bool> m_isCompiled;
+    std::once_flag m_compileOnce;
+    // location of the function body in Module::m_binary
+    size_t m_bodyOffset;
+    size_t m_bodySize;
+};
+
+// https://webassembly.github.io/spec/core/valid/instructions.html#constant-expressions
+// initializer of a global or offset of an active element segment, including the extended
+// constant expressions. it is evaluated directly by instantiate, without generating bytecode
+class ConstExpression : public gc {
+public:
+    enum Opcode : uint8_t {
+        I32Const,
+        I64Const,
+        F32Const,
+        F64Const,
+        RefNull,
+        RefFunc,
+        GlobalGet,
+        I32Add,
+        I32Sub,
+        I32Mul,
+        I64Add,
+        I64Sub,
+        I64Mul,
+        InvalidOpcode,
+    };
+
+    struct Instruction {
+        Opcode m_opcode;
+        // bits of a constant, value type of ref.null, or function or global index
+        uint64_t m_operand;
+    };
+
+    ConstExpression()
+        : m_stackDepth(0)
+        , m_maxStackDepth(0)
+    {
+    }
+
+    // returns false if the instruction is unknown or pops more values than the stack holds
+    bool append(Opcode opcode, uint64_t operand = 0);
+
+    // true if the expression leaves exactly one value
+    bool isComplete() const { return m_stackDepth == 1; }
+
+    // the offset of most element segments
+    bool isI32Const() const
+    {
+        return m_instruction.size() == 1 && m_instruction[0].m_opcode == I32Const;
+    }
+
+    const Vector<Instruction, GCUtil::gc_malloc_atomic_allocator<Instruction>>& instruction() const
+    {
+        return m_instruction;
+    }
+
+    // ref.func creates the function of the instance if it is not created yet
+    Value evaluate(Instance* instance) const;
+
+private:
+    Vector<Instruction, GCUtil::gc_malloc_atomic_allocator<Instruction>> m_instruction;
+    uint32_t m_stackDepth;
+    uint32_t m_maxStackDepth;
+};
+
+// https://webassembly.github.io/spec/core/syntax/modules.html#element-segments
+class ModuleElement : public gc {
+    friend class wabt::WASMBinaryReader;
+    friend class ModuleCache;
+
+public:
+    typedef Vector<uint32_t, GCUtil::gc_malloc_atomic_allocator<uint32_t>> IndexVector;
+
+    enum Mode { Active,
+                Passive,
+                Declarative };
+
+    // function index of ref.null elements
+    static constexpr uint32_t s_nullFunctionIndex = std::numeric_limits<uint32_t>::max();
+
+    ModuleElement(Mode mode, uint32_t tableIndex)
+        : m_mode(mode)
+        , m_tableIndex(tableIndex)
+        , m_offset(nullptr)
+    {
+    }
+
+    Mode mode() const { return m_mode; }
+
+    uint32_t tableIndex() const { return m_tableIndex; }
+
+    // offset of an active segment, null for other segments
+    ConstExpression* offset() const { return m_offset; }
+
+    const IndexVector& functionIndex() const { return m_functionIndex; }
+
+    // canonical index of the type of each element, computed at parse time
+    const IndexVector& signature() const { return m_signature; }
+
+private:
+    Mode m_mode;
+    uint32_t m_tableIndex;
+    ConstExpression* m_offset;
+    IndexVector m_functionIndex;
+    IndexVector m_signature;
 };
 
 class Module : public gc {
     friend class wabt::WASMBinaryReader;
+    friend class WASMParser;
+    friend class ModuleCache;
+    friend class ModuleFunction;
 
 public:
-    Module(Store* store)
+    Module(Store* store, const ParseOptions& parseOptions = ParseOptions())
         : m_store(store)
+        , m_parseOptions(parseOptions)
         , m_seenStartAttribute(false)
         , m_version(0)
         , m_start(0)
+        , m_dataCount(std::numeric_limits<uint32_t>::max())
+        , m_byteCodeArena(nullptr)
+        , m_byteCodeArenaSize(0)
+        , m_mappedCacheFile(nullptr)
+        , m_mappedCacheFileSize(0)
+        , m_compiledByteCodeSize(0)
+        , m_callIndirectCacheCount(0)
+        , m_name(nullptr)
+        , m_hasUnreadNameSection(false)
     {
     }
 
     ModuleFunction* function(uint32_t index)
     {
-        for (size_t i = 0; i < m_function.size(); i++) {
-            if (m_function[i]->functionIndex() == index) {
-                return m_function[i];
-            }
-        }
-        ASSERT_NOT_REACHED();
-        return nullptr;
+        ASSERT(index < m_function.size());
+        ASSERT(m_function[index]->functionIndex() == index);
+        return m_function[index];
     }
 
     FunctionType* functionType(uint32_t index)
     {
-        for (size_t i = 0; i < m_functionType.size(); i++) {
-            if (m_functionType[i]->index() == index) {
-                return m_functionType[i];
-            }
-        }
-        ASSERT_NOT_REACHED();
-        return nullptr;
+        ASSERT(index < m_functionType.size());
+        ASSERT(m_functionType[index]->index() == index);
+        return m_functionType[index];
     }
 
     const Vector<ModuleImport*, GCUtil::gc_malloc_allocator<ModuleImport*>>& moduleImport() const
@@ -305,27 +384,118 @@ public:
         return m_export;
     }
 
+    // lookup in the hash table of exports
+    // names created by Store::internString are compared by pointer
+    Optional<ModuleExport*> findExport(String* name) const;
+    Optional<ModuleExport*> findExport(const char* name, size_t length) const;
+
+    Store* store() const { return m_store; }
+
+    // only the defined functions which are referenced by element segments, constant expressions
+    // or the start function are created here, Instance::function creates the others when they are used first
     Instance* instantiate(const ValueVector& imports);
 
+    const ParseOptions& parseOptions() const { return m_parseOptions; }
+
+    // size of the bytecode of the functions compiled so far,
+    // and of the binary which is kept for lazy compilation
+    size_t byteCodeSize() const
+    {
+        return m_binary.size() + m_compiledByteCodeSize.load(std::memory_order_relaxed);
+    }
+
+    // number of call_indirect sites compiled so far
+    uint32_t callIndirectCacheCount() const
+    {
+        return m_callIndirectCacheCount.load(std::memory_order_relaxed);
+    }
+
+    // names from the name section, if it was read
+    Optional<String*> name()
+    {
+        readNameSectionIfNeeded();
+        return m_name;
+    }
+
+    Optional<String*> functionName(uint32_t index)
+    {
+        readNameSectionIfNeeded();
+        if (index < m_functionName.size()) {
+            return m_functionName[index];
+        }
+        return nullptr;
+    }
+
+    // the name section kept by ParseOptions::ReadNameSectionLazily is read when a name is requested first
+    bool hasUnreadNameSection() const
+    {
+        return m_hasUnreadNameSection.load(std::memory_order_acquire);
+    }
+
 private:
+    void readNameSectionIfNeeded()
+    {
+        if (UNLIKELY(m_hasUnreadNameSection.load(std::memory_order_acquire))) {
+            readNameSection();
+        }
+    }
+    void readNameSection();
+
+    void reserveExport(size_t count);
+
+    // functions may be compiled on several threads at once
+    uint32_t newCallIndirectCacheIndex()
+    {
+        return m_callIndirectCacheCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void appendExport(ModuleExport* moduleExport);
+
     Store* m_store;
+    ParseOptions m_parseOptions;
     bool m_seenStartAttribute;
     uint32_t m_version;
     uint32_t m_start;
     Vector<ModuleImport*, GCUtil::gc_malloc_allocator<ModuleImport*>> m_import;
     Vector<ModuleExport*, GCUtil::gc_malloc_allocator<ModuleExport*>> m_export;
+    // open addressing hash table of m_export keyed by name, its size is a power of two
+    // which is at least twice the export count
+    Vector<ModuleExport*, GCUtil::gc_malloc_allocator<ModuleExport*>> m_exportTable;
     Vector<FunctionType*, GCUtil::gc_malloc_allocator<FunctionType*>>
         m_functionType;
     Vector<ModuleFunction*, GCUtil::gc_malloc_allocator<ModuleFunction*>>
         m_function;
-    /* initialSize, maximumSize */
-    Vector<std::pair<size_t, size_t>, GCUtil::gc_malloc_atomic_allocator<std::pair<size_t, size_t>>>
+    Vector<ModuleElement*, GCUtil::gc_malloc_allocator<ModuleElement*>>
+        m_element;
+    /* initialSize, maximumSize in page size, is64, isShared */
+    Vector<std::tuple<uint64_t, uint64_t, bool, bool>, GCUtil::gc_malloc_atomic_allocator<std::tuple<uint64_t, uint64_t, bool, bool>>>
         m_memory;
     Vector<std::tuple<Value::Type, size_t, size_t>, GCUtil::gc_malloc_atomic_allocator<std::tuple<Value::Type, size_t, size_t>>>
         m_table;
     Vector<std::tuple<Value::Type, bool>, GCUtil::gc_malloc_atomic_allocator<std::tuple<Value::Type, bool>>>
         m_global;
-    Optional<ModuleFunction*> m_globalInitBlock;
+    // indexed by global index, null for imported globals
+    Vector<ConstExpression*, GCUtil::gc_malloc_allocator<ConstExpression*>> m_globalInit;
+    // copy of the binary while functions are compiled lazily
+    Vector<uint8_t, GCUtil::gc_malloc_atomic_allocator<uint8_t>> m_binary;
+    // count in the DataCount section of m_binary, needed to read bodies with memory.init or data.drop
+    uint32_t m_dataCount;
+    // bytecode of the functions compiled with the module, in call graph order
+    uint8_t* m_byteCodeArena;
+    size_t m_byteCodeArenaSize;
+    // a module read by ModuleCache keeps the mapped cache file, which m_byteCodeArena points into
+    void* m_mappedCacheFile;
+    size_t m_mappedCacheFileSize;
+    // added up as functions are compiled, which can happen on several threads
+    std::atomic<size_t> m_compiledByteCodeSize;
+    std::atomic<uint32_t> m_callIndirectCacheCount;
+
+    String* m_name;
+    // indexed by function index, null for functions without name
+    Vector<String*, GCUtil::gc_malloc_allocator<String*>> m_functionName;
+    // payload of the name section until it is read by ParseOptions::ReadNameSectionLazily
+    Vector<uint8_t, GCUtil::gc_malloc_atomic_allocator<uint8_t>> m_nameSection;
+    std::atomic<bool> m_hasUnreadNameSection;
+    std::once_flag m_readNameSectionOnce;
 };
 
 } // namespace Walrus
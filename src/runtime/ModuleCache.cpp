@@ -0,0 +1,815 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Walrus.h"
+
+#include "runtime/ModuleCache.h"
+#include "runtime/Module.h"
+#include "runtime/Store.h"
+#include "interpreter/ByteCode.h"
+#include "parser/WASMParser.h"
+
+#include <inttypes.h>
+
+#if defined(OS_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// bytecode of debug builds contains vtable pointers, so it cannot be stored
+#if defined(NDEBUG) && defined(OS_POSIX)
+#define ENABLE_MODULE_CACHE
+#endif
+
+namespace Walrus {
+
+static const char s_cacheMagic[8] = { 'W', 'A', 'L', 'R', 'U', 'S', 'M', 'C' };
+// increase when the layout of the cache file or of any bytecode changes
+static const uint32_t s_cacheFormatVersion = 4;
+// bytecode is stored aligned, so it can be used from a mapped file
+static const size_t s_byteCodeAlignment = 8;
+
+class CacheWriter {
+public:
+    CacheWriter(std::vector<uint8_t>& out)
+        : m_out(out)
+    {
+    }
+
+    void writeU8(uint8_t value)
+    {
+        m_out.push_back(value);
+    }
+
+    void writeU32(uint32_t value)
+    {
+        writeBytes(&value, sizeof(value));
+    }
+
+    void writeU64(uint64_t value)
+    {
+        writeBytes(&value, sizeof(value));
+    }
+
+    void writeString(String* string)
+    {
+        writeU32(string->length());
+        writeBytes(string->buffer(), string->length());
+    }
+
+    void writeBytes(const void* data, size_t len)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        m_out.insert(m_out.end(), bytes, bytes + len);
+    }
+
+    void align(size_t alignment)
+    {
+        while (m_out.size() % alignment) {
+            m_out.push_back(0);
+        }
+    }
+
+    size_t position() const { return m_out.size(); }
+    uint8_t* at(size_t position) { return m_out.data() + position; }
+
+private:
+    std::vector<uint8_t>& m_out;
+};
+
+// every read is bounds checked, once a read fails all further reads fail
+class CacheReader {
+public:
+    CacheReader(const uint8_t* data, size_t len)
+        : m_data(data)
+        , m_length(len)
+        , m_position(0)
+        , m_hasError(false)
+    {
+    }
+
+    bool hasError() const { return m_hasError; }
+    bool isAtEnd() const { return m_position == m_length; }
+
+    uint8_t readU8()
+    {
+        uint8_t value = 0;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    uint32_t readU32()
+    {
+        uint32_t value = 0;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t readU64()
+    {
+        uint64_t value = 0;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    // returns null on error
+    String* readString()
+    {
+        uint32_t length = readU32();
+        const uint8_t* data = readInPlace(length);
+        if (!data) {
+            return nullptr;
+        }
+        return new String(reinterpret_cast<const char*>(data), length);
+    }
+
+    // returns null on error
+    String* readInternedString(Store* store)
+    {
+        uint32_t length = readU32();
+        const uint8_t* data = readInPlace(length);
+        if (!data) {
+            return nullptr;
+        }
+        return store->internString(reinterpret_cast<const char*>(data), length);
+    }
+
+    void readBytes(void* out, size_t len)
+    {
+        const uint8_t* data = readInPlace(len);
+        if (data) {
+            memcpy(out, data, len);
+        }
+    }
+
+    // returns null on error
+    const uint8_t* readInPlace(size_t len)
+    {
+        if (m_hasError || len > m_length - m_position) {
+            m_hasError = true;
+            return nullptr;
+        }
+        const uint8_t* data = m_data + m_position;
+        m_position += len;
+        return data;
+    }
+
+    void align(size_t alignment)
+    {
+        size_t padding = (alignment - m_position % alignment) % alignment;
+        readInPlace(padding);
+    }
+
+    // the count of items which take at least itemSize bytes each
+    // fails early instead of reserving huge vectors for a corrupt count
+    uint32_t readCount(size_t itemSize)
+    {
+        uint32_t count = readU32();
+        if (!m_hasError && count > (m_length - m_position) / itemSize) {
+            m_hasError = true;
+            return 0;
+        }
+        return count;
+    }
+
+    void setError() { m_hasError = true; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_length;
+    size_t m_position;
+    bool m_hasError;
+};
+
+uint64_t ModuleCache::hash(const uint8_t* data, size_t len)
+{
+    // a 64 bit multiply-xorshift hash which consumes 8 bytes per step
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = 0xCBF29CE484222325ULL ^ (len * multiplier);
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        h ^= word * multiplier;
+        h = (h << 31) | (h >> 33);
+        h *= 0xC2B2AE3D27D4EB4FULL;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, len - i);
+    h ^= tail * multiplier;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+void ModuleCache::writeFunction(CacheWriter& writer, ModuleFunction* function, size_t arenaPosition)
+{
+    writer.writeU32(function->requiredStackSize());
+    writer.writeU32(function->requiredStackSizeDueToLocal());
+
+    writer.writeU32(function->m_local.size());
+    for (size_t i = 0; i < function->m_local.size(); i++) {
+        writer.writeU8(function->m_local[i]);
+    }
+
+    writer.writeU32(function->m_callIndirectPosition.size());
+    for (size_t i = 0; i < function->m_callIndirectPosition.size(); i++) {
+        writer.writeU32(function->m_callIndirectPosition[i]);
+    }
+
+    // bytecode in the arena of the module is stored as an offset into the stored arena
+    Module* module = function->module();
+    size_t start;
+    if (arenaPosition != SIZE_MAX && function->byteCode() >= module->m_byteCodeArena
+        && function->byteCode() < module->m_byteCodeArena + module->m_byteCodeArenaSize) {
+        size_t offset = function->byteCode() - module->m_byteCodeArena;
+        writer.writeU8(true);
+        writer.writeU64(offset);
+        writer.writeU32(function->byteCodeSize());
+        start = arenaPosition + offset;
+    } else {
+        writer.writeU8(false);
+        writer.writeU32(function->byteCodeSize());
+        writer.align(s_byteCodeAlignment);
+        start = writer.position();
+        writer.writeBytes(function->byteCode(), function->byteCodeSize());
+    }
+
+    // types are stored by index
+    for (size_t i = 0; i < function->m_callIndirectPosition.size(); i++) {
+        CallIndirect* code = reinterpret_cast<CallIndirect*>(writer.at(start + function->m_callIndirectPosition[i]));
+        uintptr_t typeIndex = code->functionType()->index();
+        code->setFunctionType(reinterpret_cast<FunctionType*>(typeIndex));
+    }
+}
+
+bool ModuleCache::readFunction(CacheReader& reader, Module* module, ModuleFunction* function, size_t functionTypeCount)
+{
+    function->m_requiredStackSize = reader.readU32();
+    function->m_requiredStackSizeDueToLocal = reader.readU32();
+
+    uint32_t localCount = reader.readCount(sizeof(uint8_t));
+    function->m_local.reserve(localCount);
+    for (uint32_t i = 0; i < localCount; i++) {
+        function->m_local.pushBack(static_cast<Value::Type>(reader.readU8()));
+    }
+
+    uint32_t callIndirectCount = reader.readCount(sizeof(uint32_t));
+    function->m_callIndirectPosition.reserve(callIndirectCount);
+    for (uint32_t i = 0; i < callIndirectCount; i++) {
+        function->m_callIndirectPosition.pushBack(reader.readU32());
+    }
+
+    bool isInArena = reader.readU8();
+    uint32_t byteCodeSize;
+    if (isInArena) {
+        uint64_t offset = reader.readU64();
+        byteCodeSize = reader.readU32();
+        if (offset > module->m_byteCodeArenaSize || module->m_byteCodeArenaSize - offset < byteCodeSize) {
+            return false;
+        }
+        function->m_byteCode = module->m_byteCodeArena + offset;
+        function->m_byteCodeSize = byteCodeSize;
+        module->m_compiledByteCodeSize.fetch_add(byteCodeSize, std::memory_order_relaxed);
+    } else {
+        byteCodeSize = reader.readU32();
+        reader.align(s_byteCodeAlignment);
+        const uint8_t* byteCode = reader.readInPlace(byteCodeSize);
+        if (!byteCode) {
+            return false;
+        }
+        // imported functions have no bytecode
+        if (byteCodeSize) {
+            function->commitByteCode(byteCode, byteCodeSize);
+        }
+    }
+
+    for (size_t i = 0; i < function->m_callIndirectPosition.size(); i++) {
+        uint32_t position = function->m_callIndirectPosition[i];
+        if (position > byteCodeSize || byteCodeSize - position < sizeof(CallIndirect)) {
+            return false;
+        }
+        CallIndirect* code = function->peekByteCode<CallIndirect>(position);
+        uintptr_t typeIndex = reinterpret_cast<uintptr_t>(code->functionType());
+        if (typeIndex >= functionTypeCount) {
+            return false;
+        }
+        code->setFunctionType(module->functionType(typeIndex));
+        code->setCacheIndex(module->newCallIndirectCacheIndex());
+    }
+
+    return !reader.hasError();
+}
+
+static void writeConstExpression(CacheWriter& writer, ConstExpression* expression)
+{
+    writer.writeU8(expression != nullptr);
+    if (!expression) {
+        return;
+    }
+    writer.writeU32(expression->instruction().size());
+    for (size_t i = 0; i < expression->instruction().size(); i++) {
+        writer.writeU8(expression->instruction()[i].m_opcode);
+        writer.writeU64(expression->instruction()[i].m_operand);
+    }
+}
+
+// the indices are checked because instantiate does not check them again
+static bool readConstExpression(CacheReader& reader, ConstExpression*& expression, size_t globalCount, size_t functionCount)
+{
+    expression = nullptr;
+    if (!reader.readU8()) {
+        return !reader.hasError();
+    }
+
+    expression = new ConstExpression();
+    uint32_t count = reader.readCount(sizeof(uint8_t) + sizeof(uint64_t));
+    for (uint32_t i = 0; i < count; i++) {
+        auto opcode = static_cast<ConstExpression::Opcode>(reader.readU8());
+        uint64_t operand = reader.readU64();
+        if ((opcode == ConstExpression::GlobalGet && operand >= globalCount)
+            || (opcode == ConstExpression::RefFunc && operand >= functionCount)
+            || (opcode == ConstExpression::RefNull && operand != Value::FuncRef && operand != Value::ExternRef)
+            || !expression->append(opcode, operand)) {
+            return false;
+        }
+    }
+    return expression->isComplete() && !reader.hasError();
+}
+
+static void writeHeader(CacheWriter& writer, uint64_t binaryHash, uint64_t binaryLength, const ParseOptions& options)
+{
+    writer.writeBytes(s_cacheMagic, sizeof(s_cacheMagic));
+    writer.writeU32(s_cacheFormatVersion);
+    // bytecode layout depends on the build
+    writer.writeU32(sizeof(void*));
+    writer.writeU32(OpcodeKind::InvalidOpcode);
+    writer.writeU32(sizeof(CallIndirectConstant));
+    writer.writeU64(binaryHash);
+    writer.writeU64(binaryLength);
+    writer.writeU8(options.m_nameSection);
+    writer.writeU8(options.m_skipCustomSections);
+    writer.writeU32(options.m_features);
+    writer.writeU8(options.m_isTrusted);
+}
+
+static bool readHeader(CacheReader& reader, uint64_t binaryHash, uint64_t binaryLength, const ParseOptions& options)
+{
+    const uint8_t* magic = reader.readInPlace(sizeof(s_cacheMagic));
+    if (!magic || memcmp(magic, s_cacheMagic, sizeof(s_cacheMagic))) {
+        return false;
+    }
+    return reader.readU32() == s_cacheFormatVersion
+        && reader.readU32() == sizeof(void*)
+        && reader.readU32() == OpcodeKind::InvalidOpcode
+        && reader.readU32() == sizeof(CallIndirectConstant)
+        && reader.readU64() == binaryHash
+        && reader.readU64() == binaryLength
+        && reader.readU8() == options.m_nameSection
+        && reader.readU8() == options.m_skipCustomSections
+        && reader.readU32() == options.m_features
+        && reader.readU8() == options.m_isTrusted
+        && !reader.hasError();
+}
+
+bool ModuleCache::serialize(Module* module, uint64_t binaryHash, uint64_t binaryLength, std::vector<uint8_t>& out)
+{
+    for (size_t i = 0; i < module->m_import.size(); i++) {
+        auto type = module->m_import[i]->type();
+        if (type != ModuleImport::Function && type != ModuleImport::Global) {
+            return false;
+        }
+    }
+
+    // every function must have bytecode
+    for (size_t i = 0; i < module->m_function.size(); i++) {
+        if (!module->m_function[i]->isCompiled() && !module->m_function[i]->compile()) {
+            return false;
+        }
+    }
+
+    CacheWriter writer(out);
+    writeHeader(writer, binaryHash, binaryLength, module->m_parseOptions);
+
+    writer.writeU32(module->m_version);
+    writer.writeU8(module->m_seenStartAttribute);
+    writer.writeU32(module->m_start);
+
+    writer.writeU32(module->m_functionType.size());
+    for (size_t i = 0; i < module->m_functionType.size(); i++) {
+        FunctionType* functionType = module->m_functionType[i];
+        writer.writeU32(functionType->param().size());
+        for (size_t j = 0; j < functionType->param().size(); j++) {
+            writer.writeU8(functionType->param()[j]);
+        }
+        writer.writeU32(functionType->result().size());
+        for (size_t j = 0; j < functionType->result().size(); j++) {
+            writer.writeU8(functionType->result()[j]);
+        }
+    }
+
+    writer.writeU32(module->m_import.size());
+    for (size_t i = 0; i < module->m_import.size(); i++) {
+        ModuleImport* import = module->m_import[i];
+        writer.writeU8(import->type());
+        writer.writeU32(import->importIndex());
+        writer.writeString(import->moduleName());
+        writer.writeString(import->fieldName());
+        if (import->type() == ModuleImport::Function) {
+            writer.writeU32(import->functionIndex());
+            writer.writeU32(import->functionTypeIndex());
+        } else {
+            writer.writeU32(import->globalIndex());
+        }
+    }
+
+    writer.writeU32(module->m_export.size());
+    for (size_t i = 0; i < module->m_export.size(); i++) {
+        ModuleExport* exp = module->m_export[i];
+        writer.writeU8(exp->type());
+        writer.writeString(exp->name());
+        writer.writeU32(exp->exportIndex());
+        writer.writeU32(exp->itemIndex());
+    }
+
+    writer.writeU32(module->m_memory.size());
+    for (size_t i = 0; i < module->m_memory.size(); i++) {
+        writer.writeU64(std::get<0>(module->m_memory[i]));
+        writer.writeU64(std::get<1>(module->m_memory[i]));
+        writer.writeU8(std::get<2>(module->m_memory[i]));
+        writer.writeU8(std::get<3>(module->m_memory[i]));
+    }
+
+    writer.writeU32(module->m_table.size());
+    for (size_t i = 0; i < module->m_table.size(); i++) {
+        writer.writeU8(std::get<0>(module->m_table[i]));
+        writer.writeU64(std::get<1>(module->m_table[i]));
+        writer.writeU64(std::get<2>(module->m_table[i]));
+    }
+
+    writer.writeU32(module->m_global.size());
+    for (size_t i = 0; i < module->m_global.size(); i++) {
+        writer.writeU8(std::get<0>(module->m_global[i]));
+        writer.writeU8(std::get<1>(module->m_global[i]));
+    }
+
+    writer.writeU64(module->m_byteCodeArenaSize);
+    writer.align(s_byteCodeAlignment);
+    size_t arenaPosition = writer.position();
+    writer.writeBytes(module->m_byteCodeArena, module->m_byteCodeArenaSize);
+
+    writer.writeU32(module->m_function.size());
+    for (size_t i = 0; i < module->m_function.size(); i++) {
+        writer.writeU32(module->m_function[i]->functionTypeIndex());
+        writeFunction(writer, module->m_function[i], arenaPosition);
+    }
+
+    writer.writeU32(module->m_globalInit.size());
+    for (size_t i = 0; i < module->m_globalInit.size(); i++) {
+        writeConstExpression(writer, module->m_globalInit[i]);
+    }
+
+    writer.writeU32(module->m_element.size());
+    for (size_t i = 0; i < module->m_element.size(); i++) {
+        ModuleElement* element = module->m_element[i];
+        writer.writeU8(element->mode());
+        writer.writeU32(element->tableIndex());
+        writeConstExpression(writer, element->offset());
+        writer.writeU32(element->functionIndex().size());
+        for (size_t j = 0; j < element->functionIndex().size(); j++) {
+            writer.writeU32(element->functionIndex()[j]);
+        }
+    }
+
+    // names which were read, and the name section if it is not read yet
+    writer.writeU8(module->m_name != nullptr);
+    if (module->m_name) {
+        writer.writeString(module->m_name);
+    }
+    writer.writeU32(module->m_functionName.size());
+    for (size_t i = 0; i < module->m_functionName.size(); i++) {
+        writer.writeU8(module->m_functionName[i] != nullptr);
+        if (module->m_functionName[i]) {
+            writer.writeString(module->m_functionName[i]);
+        }
+    }
+    bool hasUnreadNameSection = module->m_hasUnreadNameSection.load(std::memory_order_acquire);
+    writer.writeU32(hasUnreadNameSection ? module->m_nameSection.size() : 0);
+    if (hasUnreadNameSection) {
+        writer.writeBytes(module->m_nameSection.data(), module->m_nameSection.size());
+    }
+
+    return true;
+}
+
+Optional<Module*> ModuleCache::deserialize(Store* store, const uint8_t* data, size_t len, uint64_t binaryHash, uint64_t binaryLength, const ParseOptions& options, bool isPrivateMapping)
+{
+    CacheReader reader(data, len);
+    if (!readHeader(reader, binaryHash, binaryLength, options)) {
+        return nullptr;
+    }
+
+    Module* module = new Module(store, options);
+    module->m_version = reader.readU32();
+    module->m_seenStartAttribute = reader.readU8();
+    module->m_start = reader.readU32();
+
+    uint32_t functionTypeCount = reader.readCount(2 * sizeof(uint32_t));
+    module->m_functionType.reserve(functionTypeCount);
+    for (uint32_t i = 0; i < functionTypeCount; i++) {
+        FunctionType::FunctionTypeVector param;
+        uint32_t paramCount = reader.readCount(sizeof(uint8_t));
+        param.reserve(paramCount);
+        for (uint32_t j = 0; j < paramCount; j++) {
+            param.push_back(static_cast<Value::Type>(reader.readU8()));
+        }
+        FunctionType::FunctionTypeVector result;
+        uint32_t resultCount = reader.readCount(sizeof(uint8_t));
+        result.reserve(resultCount);
+        for (uint32_t j = 0; j < resultCount; j++) {
+            result.push_back(static_cast<Value::Type>(reader.readU8()));
+        }
+        auto functionType = new FunctionType(i, std::move(param), std::move(result));
+        store->internFunctionType(functionType);
+        module->m_functionType.push_back(functionType);
+    }
+
+    uint32_t importCount = reader.readCount(3 * sizeof(uint32_t));
+    module->m_import.reserve(importCount);
+    for (uint32_t i = 0; i < importCount && !reader.hasError(); i++) {
+        uint8_t type = reader.readU8();
+        uint32_t importIndex = reader.readU32();
+        String* moduleName = reader.readInternedString(store);
+        String* fieldName = reader.readInternedString(store);
+        if (type == ModuleImport::Function) {
+            uint32_t functionIndex = reader.readU32();
+            uint32_t functionTypeIndex = reader.readU32();
+            if (functionTypeIndex >= functionTypeCount) {
+                return nullptr;
+            }
+            module->m_import.push_back(new ModuleImport(importIndex, moduleName, fieldName, functionIndex, functionTypeIndex));
+        } else if (type == ModuleImport::Global) {
+            module->m_import.push_back(new ModuleImport(importIndex, moduleName, fieldName, reader.readU32()));
+        } else {
+            reader.setError();
+        }
+    }
+
+    uint32_t exportCount = reader.readCount(3 * sizeof(uint32_t));
+    module->reserveExport(exportCount);
+    for (uint32_t i = 0; i < exportCount && !reader.hasError(); i++) {
+        uint8_t type = reader.readU8();
+        String* name = reader.readInternedString(store);
+        uint32_t exportIndex = reader.readU32();
+        uint32_t itemIndex = reader.readU32();
+        if (!name || type > ModuleExport::Global) {
+            return nullptr;
+        }
+        module->appendExport(new ModuleExport(static_cast<ModuleExport::Type>(type), name, exportIndex, itemIndex));
+    }
+
+    uint32_t memoryCount = reader.readCount(2 * sizeof(uint64_t));
+    module->m_memory.reserve(memoryCount);
+    for (uint32_t i = 0; i < memoryCount; i++) {
+        uint64_t initialSize = reader.readU64();
+        uint64_t maximumSize = reader.readU64();
+        bool is64 = reader.readU8();
+        bool isShared = reader.readU8();
+        module->m_memory.pushBack(std::make_tuple(initialSize, maximumSize, is64, isShared));
+    }
+
+    uint32_t tableCount = reader.readCount(2 * sizeof(uint64_t));
+    module->m_table.reserve(tableCount);
+    for (uint32_t i = 0; i < tableCount; i++) {
+        auto type = static_cast<Value::Type>(reader.readU8());
+        size_t initialSize = reader.readU64();
+        size_t maximumSize = reader.readU64();
+        module->m_table.pushBack(std::make_tuple(type, initialSize, maximumSize));
+    }
+
+    uint32_t globalCount = reader.readCount(2 * sizeof(uint8_t));
+    module->m_global.reserve(globalCount);
+    for (uint32_t i = 0; i < globalCount; i++) {
+        auto type = static_cast<Value::Type>(reader.readU8());
+        bool mutable_ = reader.readU8();
+        module->m_global.pushBack(std::make_tuple(type, mutable_));
+    }
+
+    // the functions point into the arena, which is used in place or copied at once
+    uint64_t arenaSize = reader.readU64();
+    reader.align(s_byteCodeAlignment);
+    const uint8_t* arena = reader.readInPlace(arenaSize);
+    if (!arena) {
+        return nullptr;
+    }
+    if (arenaSize) {
+        if (isPrivateMapping) {
+            // readFunction patches call_indirect bytecode, which only copies the pages it writes
+            module->m_byteCodeArena = const_cast<uint8_t*>(arena);
+        } else {
+            module->m_byteCodeArena = reinterpret_cast<uint8_t*>(GC_MALLOC_ATOMIC(arenaSize));
+            memcpy(module->m_byteCodeArena, arena, arenaSize);
+        }
+        module->m_byteCodeArenaSize = arenaSize;
+    }
+
+    uint32_t functionCount = reader.readCount(6 * sizeof(uint32_t));
+    module->m_function.reserve(functionCount);
+    for (uint32_t i = 0; i < functionCount; i++) {
+        uint32_t functionTypeIndex = reader.readU32();
+        if (functionTypeIndex >= functionTypeCount) {
+            return nullptr;
+        }
+        ModuleFunction* function = new ModuleFunction(module, i, functionTypeIndex);
+        if (!readFunction(reader, module, function, functionTypeCount)) {
+            return nullptr;
+        }
+        module->m_function.push_back(function);
+    }
+
+    // indices which were read before the items they refer to
+    if (module->m_seenStartAttribute && module->m_start >= functionCount) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < module->m_import.size(); i++) {
+        ModuleImport* import = module->m_import[i];
+        if (import->type() == ModuleImport::Function ? import->functionIndex() >= functionCount : import->globalIndex() >= globalCount) {
+            return nullptr;
+        }
+    }
+    for (size_t i = 0; i < module->m_export.size(); i++) {
+        ModuleExport* exportItem = module->m_export[i];
+        uint32_t itemCount = globalCount;
+        if (exportItem->type() == ModuleExport::Function) {
+            itemCount = functionCount;
+        } else if (exportItem->type() == ModuleExport::Table) {
+            itemCount = tableCount;
+        } else if (exportItem->type() == ModuleExport::Memory) {
+            itemCount = memoryCount;
+        }
+        if (exportItem->itemIndex() >= itemCount) {
+            return nullptr;
+        }
+    }
+
+    uint32_t globalInitCount = reader.readCount(sizeof(uint8_t));
+    if (globalInitCount > globalCount) {
+        return nullptr;
+    }
+    module->m_globalInit.resize(globalInitCount, nullptr);
+    for (uint32_t i = 0; i < globalInitCount; i++) {
+        if (!readConstExpression(reader, module->m_globalInit[i], globalCount, functionCount)) {
+            return nullptr;
+        }
+    }
+
+    uint32_t elementCount = reader.readCount(3 * sizeof(uint32_t));
+    module->m_element.reserve(elementCount);
+    for (uint32_t i = 0; i < elementCount; i++) {
+        uint8_t mode = reader.readU8();
+        uint32_t tableIndex = reader.readU32();
+        if (mode > ModuleElement::Declarative || (mode == ModuleElement::Active && tableIndex >= tableCount)) {
+            return nullptr;
+        }
+        ModuleElement* element = new ModuleElement(static_cast<ModuleElement::Mode>(mode), tableIndex);
+        if (!readConstExpression(reader, element->m_offset, globalCount, functionCount)) {
+            return nullptr;
+        }
+        if ((mode == ModuleElement::Active) != (element->m_offset != nullptr)) {
+            return nullptr;
+        }
+        uint32_t count = reader.readCount(sizeof(uint32_t));
+        element->m_functionIndex.reserve(count);
+        element->m_signature.reserve(count);
+        for (uint32_t j = 0; j < count; j++) {
+            uint32_t functionIndex = reader.readU32();
+            element->m_functionIndex.pushBack(functionIndex);
+            if (functionIndex == ModuleElement::s_nullFunctionIndex) {
+                element->m_signature.pushBack(FunctionType::s_invalidCanonicalIndex);
+            } else if (functionIndex < functionCount) {
+                // canonical indices belong to the engine, so they are computed again
+                element->m_signature.pushBack(module->functionType(module->function(functionIndex)->functionTypeIndex())->canonicalIndex());
+            } else {
+                return nullptr;
+            }
+        }
+        module->m_element.pushBack(element);
+    }
+
+    if (reader.readU8()) {
+        module->m_name = reader.readString();
+    }
+    uint32_t functionNameCount = reader.readCount(sizeof(uint8_t));
+    if (functionNameCount > functionCount) {
+        return nullptr;
+    }
+    module->m_functionName.resize(functionNameCount, nullptr);
+    for (uint32_t i = 0; i < functionNameCount; i++) {
+        if (reader.readU8()) {
+            module->m_functionName[i] = reader.readString();
+        }
+    }
+    uint32_t nameSectionSize = reader.readU32();
+    const uint8_t* nameSection = reader.readInPlace(nameSectionSize);
+    if (nameSection && nameSectionSize) {
+        module->m_nameSection.resizeWithUninitializedValues(nameSectionSize);
+        memcpy(module->m_nameSection.data(), nameSection, nameSectionSize);
+        module->m_hasUnreadNameSection.store(true, std::memory_order_relaxed);
+    }
+
+    if (reader.hasError() || !reader.isAtEnd()) {
+        return nullptr;
+    }
+    return module;
+}
+
+std::string ModuleCache::cacheFilePath(uint64_t binaryHash) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".wmc", binaryHash);
+    return m_directory + "/" + name;
+}
+
+Optional<Module*> ModuleCache::load(Store* store, const uint8_t* data, size_t len, const ParseOptions& options)
+{
+#if defined(ENABLE_MODULE_CACHE)
+    uint64_t binaryHash = hash(data, len);
+    std::string path = cacheFilePath(binaryHash);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        Optional<Module*> module;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            // the module keeps the mapping while its bytecode arena points into it
+            // cache files are replaced by rename, never written in place, so the mapped file does not change
+            void* mapped = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                module = deserialize(store, reinterpret_cast<const uint8_t*>(mapped), st.st_size, binaryHash, len, options, true);
+                if (module && module->m_byteCodeArena) {
+                    module->m_mappedCacheFile = mapped;
+                    module->m_mappedCacheFileSize = st.st_size;
+                    GC_REGISTER_FINALIZER_NO_ORDER(module.value(), [](void* obj, void* cd) {
+                        Module* module = reinterpret_cast<Module*>(obj);
+                        munmap(module->m_mappedCacheFile, module->m_mappedCacheFileSize);
+                    },
+                                                   nullptr, nullptr, nullptr);
+                } else {
+                    munmap(mapped, st.st_size);
+                }
+            }
+        }
+        close(fd);
+        if (module) {
+            return module;
+        }
+    }
+
+    // the file is missing, corrupt or belongs to another build or options
+    Optional<Module*> module = WASMParser::parseBinary(store, data, len, options);
+    if (!module) {
+        return module;
+    }
+
+    std::vector<uint8_t> out;
+    if (serialize(module.value(), binaryHash, len, out)) {
+        // write a temporary file then rename, so readers never see a partial file
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%d.tmp", static_cast<int>(getpid()));
+        std::string tempPath = path + suffix;
+        FILE* fp = fopen(tempPath.c_str(), "wb");
+        if (fp) {
+            bool written = fwrite(out.data(), 1, out.size(), fp) == out.size();
+            written = fclose(fp) == 0 && written;
+            if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+                remove(tempPath.c_str());
+            }
+        }
+    }
+    return module;
+#else
+    return WASMParser::parseBinary(store, data, len, options);
+#endif
+}
+
+} // namespace Walrus
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusModuleCache__
+#define __WalrusModuleCache__
+
+#include "parser/ParseOptions.h"
+
+namespace Walrus {
+
+class Store;
+class Module;
+class ModuleFunction;
+class CacheReader;
+class CacheWriter;
+
+// on-disk cache of parsed modules, keyed by the hash of the binary
+// a cache file holds the metadata and bytecode of a Module, so loading it skips the parser
+// cache files depend on the exact walrus build, and are only used by release builds
+// (bytecode of debug builds contains vtable pointers)
+class ModuleCache {
+public:
+    ModuleCache(const std::string& directory)
+        : m_directory(directory)
+    {
+    }
+
+    // returns the cached module of the binary, or parses the binary and caches the result
+    // a cache file is only used with the options it was created with
+    // may return null when there is error on data
+    Optional<Module*> load(Store* store, const uint8_t* data, size_t len, const ParseOptions& options = ParseOptions());
+
+    // not a cryptographic hash, the cache directory must be trusted
+    static uint64_t hash(const uint8_t* data, size_t len);
+
+    // returns false if the module cannot be cached
+    static bool serialize(Module* module, uint64_t binaryHash, uint64_t binaryLength, std::vector<uint8_t>& out);
+    // returns null if the data is not a valid cache file of this build for the binary
+    // with isPrivateMapping, data is a private writable mapping which the module may keep(see load),
+    // so the bytecode arena is used in place instead of being copied
+    static Optional<Module*> deserialize(Store* store, const uint8_t* data, size_t len, uint64_t binaryHash, uint64_t binaryLength, const ParseOptions& options, bool isPrivateMapping = false);
+
+private:
+    static void writeFunction(CacheWriter& writer, ModuleFunction* function, size_t arenaPosition);
+    static bool readFunction(CacheReader& reader, Module* module, ModuleFunction* function, size_t functionTypeCount);
+
+    std::string cacheFilePath(uint64_t binaryHash) const;
+
+    std::string m_directory;
+};
+
+} // namespace Walrus
+
+#endif // __WalrusModuleCache__
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Walrus.h"
+
+#include "runtime/SharedModuleCache.h"
+#include "runtime/ModuleCache.h"
+#include "runtime/Module.h"
+#include "parser/WASMParser.h"
+
+namespace Walrus {
+
+static bool sameParseOptions(const ParseOptions& a, const ParseOptions& b)
+{
+    return a.m_nameSection == b.m_nameSection
+        && a.m_skipCustomSections == b.m_skipCustomSections
+        && a.m_features == b.m_features
+        && a.m_isTrusted == b.m_isTrusted;
+}
+
+SharedModuleCache::Entry::Entry(uint64_t hash, const uint8_t* data, size_t len, const ParseOptions& options)
+    : m_hash(hash)
+    , m_options(options)
+    , m_size(0)
+    , m_isLoaded(false)
+    , m_previous(nullptr)
+    , m_next(nullptr)
+{
+    m_binary.resizeWithUninitializedValues(len);
+    memcpy(m_binary.data(), data, len);
+}
+
+SharedModuleCache::SharedModuleCache()
+    : m_capacity(0)
+    , m_size(0)
+    , m_head(nullptr)
+    , m_tail(nullptr)
+{
+    GC_REGISTER_FINALIZER_NO_ORDER(this, [](void* obj, void* cd) {
+        SharedModuleCache* cache = reinterpret_cast<SharedModuleCache*>(obj);
+        cache->m_lock.~mutex();
+        cache->m_loaded.~condition_variable();
+        cache->m_entries.~unordered_multimap();
+    },
+                                   nullptr, nullptr, nullptr);
+}
+
+void SharedModuleCache::setCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_capacity = capacity;
+    evict();
+}
+
+void SharedModuleCache::clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    while (m_tail) {
+        remove(m_tail);
+    }
+}
+
+Optional<Module*> SharedModuleCache::load(Store* store, const uint8_t* data, size_t len, const ParseOptions& options)
+{
+    if (!capacity()) {
+        return WASMParser::parseBinary(store, data, len, options);
+    }
+
+    uint64_t hash = ModuleCache::hash(data, len);
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    Entry* entry = find(hash, data, len, options);
+    if (entry) {
+        m_loaded.wait(lock, [entry]() { return entry->m_isLoaded; });
+        // the entry may be evicted while the module was parsed
+        if (entry->m_module && isLinked(entry)) {
+            unlink(entry);
+            link(entry);
+            // lazy compilation adds bytecode to the module after it was cached
+            size_t size = entry->m_module->byteCodeSize() + len;
+            m_size += size - entry->m_size;
+            entry->m_size = size;
+            evict();
+        }
+        return entry->m_module;
+    }
+
+    // other threads loading the binary wait for this entry
+    entry = new Entry(hash, data, len, options);
+    m_entries.insert(std::make_pair(hash, entry));
+    lock.unlock();
+
+    Optional<Module*> module = WASMParser::parseBinary(store, data, len, options);
+
+    lock.lock();
+    entry->m_module = module;
+    entry->m_isLoaded = true;
+    if (module) {
+        entry->m_size = module->byteCodeSize() + len;
+        m_size += entry->m_size;
+        link(entry);
+        evict();
+    } else {
+        remove(entry);
+    }
+    lock.unlock();
+
+    m_loaded.notify_all();
+    return module;
+}
+
+SharedModuleCache::Entry* SharedModuleCache::find(uint64_t hash, const uint8_t* data, size_t len, const ParseOptions& options)
+{
+    auto range = m_entries.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; iter++) {
+        Entry* entry = iter->second;
+        if (entry->m_binary.size() == len && sameParseOptions(entry->m_options, options)
+            && memcmp(entry->m_binary.data(), data, len) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+void SharedModuleCache::remove(Entry* entry)
+{
+    auto range = m_entries.equal_range(entry->m_hash);
+    for (auto iter = range.first; iter != range.second; iter++) {
+        if (iter->second == entry) {
+            m_entries.erase(iter);
+            break;
+        }
+    }
+
+    if (isLinked(entry)) {
+        unlink(entry);
+        m_size -= entry->m_size;
+    }
+}
+
+void SharedModuleCache::link(Entry* entry)
+{
+    entry->m_previous = nullptr;
+    entry->m_next = m_head;
+    if (m_head) {
+        m_head->m_previous = entry;
+    } else {
+        m_tail = entry;
+    }
+    m_head = entry;
+}
+
+void SharedModuleCache::unlink(Entry* entry)
+{
+    if (entry->m_previous) {
+        entry->m_previous->m_next = entry->m_next;
+    } else {
+        m_head = entry->m_next;
+    }
+    if (entry->m_next) {
+        entry->m_next->m_previous = entry->m_previous;
+    } else {
+        m_tail = entry->m_previous;
+    }
+    entry->m_previous = nullptr;
+    entry->m_next = nullptr;
+}
+
+void SharedModuleCache::evict()
+{
+    // modules of evicted entries stay alive while they are used
+    while (m_size > m_capacity && m_tail) {
+        remove(m_tail);
+    }
+}
+
+} // namespace Walrus
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusSharedModuleCache__
+#define __WalrusSharedModuleCache__
+
+#include <condition_variable>
+#include <mutex>
+#include "parser/ParseOptions.h"
+#include "util/Vector.h"
+
+namespace Walrus {
+
+class Store;
+class Module;
+
+// in-memory cache of parsed modules of an Engine, keyed by the hash of the binary and the parse options
+// every store of the engine which loads the same binary gets the same immutable Module, which is parsed once
+// (e.g. many tenants of a server uploading the same binary)
+// the cached module belongs to the store which parsed it, but can be instantiated and linked by any store
+// of the engine, since canonical indexes of function types are shared by the engine
+// modules are evicted in least recently used order when the total size of the entries exceeds the capacity,
+// an entry holds the bytecode of its module(see Module::byteCodeSize) and a copy of the binary
+// with lazy compilation the bytecode grows while the module runs, which is counted when the entry is hit again
+class SharedModuleCache : public gc {
+public:
+    SharedModuleCache();
+
+    // the cache is disabled when the capacity is 0(default)
+    size_t capacity() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_capacity;
+    }
+    void setCapacity(size_t capacity);
+
+    // total size of the cached entries
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_size;
+    }
+
+    // returns the cached module of the binary, or parses the binary and caches the result
+    // while another thread parses the same binary, waits for its result instead of parsing it again
+    // may return null when there is error on data(errors are not cached)
+    Optional<Module*> load(Store* store, const uint8_t* data, size_t len, const ParseOptions& options = ParseOptions());
+
+    void clear();
+
+private:
+    struct Entry : public gc {
+        Entry(uint64_t hash, const uint8_t* data, size_t len, const ParseOptions& options);
+
+        uint64_t m_hash;
+        ParseOptions m_options;
+        // the hash is not a cryptographic hash, so the binary is compared on a hit
+        Vector<uint8_t, GCUtil::gc_malloc_atomic_allocator<uint8_t>> m_binary;
+        Optional<Module*> m_module;
+        size_t m_size;
+        bool m_isLoaded;
+        // least recently used list of the loaded entries
+        Entry* m_previous;
+        Entry* m_next;
+    };
+
+    Entry* find(uint64_t hash, const uint8_t* data, size_t len, const ParseOptions& options);
+    void remove(Entry* entry);
+    bool isLinked(Entry* entry) const
+    {
+        return entry->m_previous || m_head == entry;
+    }
+    void link(Entry* entry);
+    void unlink(Entry* entry);
+    void evict();
+
+    mutable std::mutex m_lock;
+    // notified when an entry is loaded
+    std::condition_variable m_loaded;
+    size_t m_capacity;
+    size_t m_size;
+    // most recently used entry first
+    Entry* m_head;
+    Entry* m_tail;
+    std::unordered_multimap<uint64_t, Entry*, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                            GCUtil::gc_malloc_allocator<std::pair<const uint64_t, Entry*>>>
+        m_entries;
+};
+
+} // namespace Walrus
+
+#endif // __WalrusSharedModuleCache__
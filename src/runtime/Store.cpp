@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Walrus.h"
+
+#include "runtime/Store.h"
+#include "runtime/Module.h"
+
+namespace Walrus {
+
+Store::Store(Engine* engine)
+    : m_engine(engine)
+{
+    GC_REGISTER_FINALIZER_NO_ORDER(this, [](void* obj, void* cd) {
+        Store* store = reinterpret_cast<Store*>(obj);
+        store->m_internedString.~unordered_map();
+        store->m_internLock.~mutex();
+    },
+                                   nullptr, nullptr, nullptr);
+}
+
+String* Store::internString(const char* buffer, size_t length)
+{
+    InternedStringKey key = { buffer, length, String::hash(buffer, length) };
+    std::lock_guard<std::mutex> guard(m_internLock);
+    auto iter = m_internedString.find(key);
+    if (iter != m_internedString.end()) {
+        return iter->second;
+    }
+
+    String* string = new String(buffer, length);
+    key.m_buffer = string->buffer();
+    m_internedString.insert(std::make_pair(key, string));
+    return string;
+}
+
+} // namespace Walrus
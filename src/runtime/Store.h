@@ -17,6 +17,7 @@
 #ifndef __WalrusStore__
 #define __WalrusStore__
 
+#include <mutex>
 #include "util/String.h"
 #include "runtime/Value.h"
 #include "runtime/Engine.h"
@@ -24,15 +25,21 @@
 namespace Walrus {
 
 class Engine;
+class FunctionType;
+class ImportedFunction;
+template <typename Signature>
+struct HostFunction;
 
 class Store : public gc {
 public:
     // <Value, mutable>
     typedef Vector<std::pair<Value, bool>, GCUtil::gc_malloc_allocator<std::pair<Value, bool>>> GlobalVariableVector;
 
-    Store(Engine* engine)
-        : m_engine(engine)
+    Store(Engine* engine);
+
+    Engine* engine() const
     {
+        return m_engine;
     }
 
     GlobalVariableVector& global()
@@ -40,9 +47,57 @@ public:
         return m_global;
     }
 
+    // assign the canonical index of functionType
+    // so signature checks of call_indirect are a single integer compare
+    // interning is thread-safe, since modules of a store can be parsed and compiled on any thread
+    uint32_t internFunctionType(FunctionType* functionType)
+    {
+        return m_engine->internFunctionType(functionType);
+    }
+
+    // returns the only String of the store with the given content,
+    // so names of modules can be compared by pointer
+    String* internString(const char* buffer, size_t length);
+    String* internString(const std::string& src)
+    {
+        return internString(src.data(), src.length());
+    }
+
+    // creates a host function of a signature known at compile time, e.g. makeHostFunction<int32_t(int32_t, int64_t)>
+    // which reads its arguments from the operand stack and writes its result back without boxing them into Values
+    // the callback is R (*)(ExecutionState& state, Args... args, void* data)
+    // defined in runtime/TypedFunction.h
+    template <typename Signature>
+    ImportedFunction* makeHostFunction(typename HostFunction<Signature>::Callback callback, void* data = nullptr);
+
 private:
+    struct InternedStringKey {
+        const char* m_buffer;
+        size_t m_length;
+        size_t m_hash;
+
+        bool operator==(const InternedStringKey& other) const
+        {
+            return m_hash == other.m_hash && m_length == other.m_length && memcmp(m_buffer, other.m_buffer, m_length) == 0;
+        }
+    };
+
+    struct InternedStringKeyHash {
+        size_t operator()(const InternedStringKey& key) const
+        {
+            return key.m_hash;
+        }
+    };
+
+
     Engine* m_engine;
     GlobalVariableVector m_global;
+    // guards m_internedString
+    std::mutex m_internLock;
+    // keys point into the buffer of their String
+    std::unordered_map<InternedStringKey, String*, InternedStringKeyHash, std::equal_to<InternedStringKey>,
+                       GCUtil::gc_malloc_allocator<std::pair<const InternedStringKey, String*>>>
+        m_internedString;
 };
 
 } // namespace Walrus
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Walrus.h"
+
+#include "runtime/Table.h"
+#include "runtime/Function.h"
+#include "runtime/Module.h"
+#include "runtime/Trap.h"
+
+namespace Walrus {
+
+Table::Table(Value::Type type, size_t initialSize, size_t maximumSize)
+    : m_type(type)
+    , m_maximumSize(maximumSize)
+    , m_version(1)
+{
+    ASSERT(type == Value::Type::FuncRef || type == Value::Type::ExternRef);
+    m_elements.resize(initialSize, nullptr);
+    if (m_type == Value::Type::FuncRef) {
+        m_signatures.resize(initialSize, FunctionType::s_invalidCanonicalIndex);
+    }
+}
+
+uint32_t Table::signatureOf(void* ref)
+{
+    if (!ref) {
+        return FunctionType::s_invalidCanonicalIndex;
+    }
+    return reinterpret_cast<Function*>(ref)->functionType()->canonicalIndex();
+}
+
+void Table::grow(size_t newSize, void* ref)
+{
+    ASSERT(newSize <= m_maximumSize);
+
+    // reserve geometrically, so repeated table.grow by small deltas stays amortized O(1)
+    if (newSize > m_elements.capacity()) {
+        size_t newCapacity = std::min(std::max(newSize, m_elements.capacity() * 2), m_maximumSize);
+        m_elements.reserve(newCapacity);
+        if (m_type == Value::Type::FuncRef) {
+            m_signatures.reserve(newCapacity);
+        }
+    }
+
+    m_elements.resize(newSize, ref);
+    if (m_type == Value::Type::FuncRef) {
+        m_signatures.resize(newSize, signatureOf(ref));
+    }
+    m_version++;
+}
+
+void Table::setElement(uint32_t elemIndex, void* ref)
+{
+    ASSERT(elemIndex < size());
+    m_elements[elemIndex] = ref;
+    if (m_type == Value::Type::FuncRef) {
+        m_signatures[elemIndex] = signatureOf(ref);
+    }
+    m_version++;
+}
+
+NEVER_INLINE void Table::throwException()
+{
+    Trap::throwException(new String("out of bounds table access"));
+}
+
+void Table::init(const ElementSegment* segment, uint32_t dstIndex, uint32_t srcIndex, uint32_t n)
+{
+    if (UNLIKELY(static_cast<uint64_t>(srcIndex) + n > segment->size() || static_cast<uint64_t>(dstIndex) + n > size())) {
+        throwException();
+    }
+    if (!n) {
+        return;
+    }
+
+    memcpy(m_elements.data() + dstIndex, segment->m_elements.data() + srcIndex, n * sizeof(void*));
+    if (m_type == Value::Type::FuncRef) {
+        memcpy(m_signatures.data() + dstIndex, segment->m_signatures.data() + srcIndex, n * sizeof(uint32_t));
+    }
+    m_version++;
+}
+
+void Table::assign(const Table* other)
+{
+    ASSERT(m_type == other->m_type);
+    m_elements.resizeWithUninitializedValues(other->size());
+    if (other->size()) {
+        memcpy(m_elements.data(), other->m_elements.data(), other->size() * sizeof(void*));
+    }
+    if (m_type == Value::Type::FuncRef) {
+        m_signatures.resizeWithUninitializedValues(other->size());
+        if (other->size()) {
+            memcpy(m_signatures.data(), other->m_signatures.data(), other->size() * sizeof(uint32_t));
+        }
+    }
+    m_version++;
+}
+
+void Table::copy(const Table* srcTable, uint32_t dstIndex, uint32_t srcIndex, uint32_t n)
+{
+    if (UNLIKELY(static_cast<uint64_t>(srcIndex) + n > srcTable->size() || static_cast<uint64_t>(dstIndex) + n > size())) {
+        throwException();
+    }
+    if (!n) {
+        return;
+    }
+
+    // source and destination can be the same table, and can overlap
+    ASSERT(m_type == srcTable->m_type);
+    memmove(m_elements.data() + dstIndex, srcTable->m_elements.data() + srcIndex, n * sizeof(void*));
+    if (m_type == Value::Type::FuncRef) {
+        memmove(m_signatures.data() + dstIndex, srcTable->m_signatures.data() + srcIndex, n * sizeof(uint32_t));
+    }
+    m_version++;
+}
+
+void Table::fill(uint32_t index, void* ref, uint32_t n)
+{
+    if (UNLIKELY(static_cast<uint64_t>(index) + n > size())) {
+        throwException();
+    }
+    if (!n) {
+        return;
+    }
+
+    std::fill_n(m_elements.data() + index, n, ref);
+    if (m_type == Value::Type::FuncRef) {
+        std::fill_n(m_signatures.data() + index, n, signatureOf(ref));
+    }
+    m_version++;
+}
+
+} // namespace Walrus
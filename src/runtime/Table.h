@@ -21,16 +21,59 @@
 
 namespace Walrus {
 
-class Table : public gc {
+class Table;
+
+// element segment of an instance, with its function references resolved
+// the layout matches Table, so table initialization is a plain copy
+class ElementSegment : public gc {
+    friend class Table;
+
 public:
-    Table(Value::Type type, size_t initialSize, size_t maximumSize)
-        : m_type(type)
-        , m_size(initialSize)
-        , m_maximumSize(maximumSize)
+    ElementSegment(size_t size)
+    {
+        m_elements.resizeWithUninitializedValues(size);
+        m_signatures.resizeWithUninitializedValues(size);
+    }
+
+    size_t size() const
     {
-        m_elements.resizeWithUninitializedValues(initialSize);
+        return m_elements.size();
     }
 
+    void setElement(uint32_t elemIndex, void* ref, uint32_t signature)
+    {
+        ASSERT(elemIndex < size());
+        m_elements[elemIndex] = ref;
+        m_signatures[elemIndex] = signature;
+    }
+
+    // elem.drop, and instantiation drops active and declarative segments
+    void drop()
+    {
+        m_elements.clear();
+        m_signatures.clear();
+    }
+
+    // restores a copy of the segment taken by Instance::saveSnapshot
+    void assign(const ElementSegment* other)
+    {
+        m_elements.resizeWithUninitializedValues(other->size());
+        m_signatures.resizeWithUninitializedValues(other->size());
+        if (other->size()) {
+            memcpy(m_elements.data(), other->m_elements.data(), other->size() * sizeof(void*));
+            memcpy(m_signatures.data(), other->m_signatures.data(), other->size() * sizeof(uint32_t));
+        }
+    }
+
+private:
+    Vector<void*, GCUtil::gc_malloc_allocator<void*>> m_elements;
+    Vector<uint32_t, GCUtil::gc_malloc_atomic_allocator<uint32_t>> m_signatures;
+};
+
+class Table : public gc {
+public:
+    Table(Value::Type type, size_t initialSize, size_t maximumSize);
+
     Value::Type type() const
     {
         return m_type;
@@ -38,7 +81,7 @@ public:
 
     size_t size() const
     {
-        return m_size;
+        return m_elements.size();
     }
 
     size_t maximumSize() const
@@ -46,34 +89,54 @@ public:
         return m_maximumSize;
     }
 
-    void grow(size_t newSize, const Value& val)
+    // changes whenever the elements change, starting from 1
+    // a table is never replaced in its instance, so a per-instance cache keyed by the version only compares versions of one table
+    uint64_t version() const
     {
-        ASSERT(newSize <= m_maximumSize);
-        m_elements.resize(newSize, val);
+        return m_version;
     }
 
-    Value getElement(uint32_t elemIndex) const
+    void grow(size_t newSize, void* ref);
+
+    void* getElement(uint32_t elemIndex) const
     {
-        ASSERT(elemIndex < m_size);
+        ASSERT(elemIndex < size());
         return m_elements[elemIndex];
     }
 
-    void setElement(uint32_t elemIndex, const Value& val)
+    void setElement(uint32_t elemIndex, void* ref);
+
+    // bulk operations trap before modifying the table when any index is out of bounds
+    void init(const ElementSegment* segment, uint32_t dstIndex, uint32_t srcIndex, uint32_t n);
+    void copy(const Table* srcTable, uint32_t dstIndex, uint32_t srcIndex, uint32_t n);
+    void fill(uint32_t index, void* ref, uint32_t n);
+
+    // restores the size and the elements of a copy of the table taken by Instance::saveSnapshot
+    void assign(const Table* other);
+
+    // canonical index of the function type of the element (funcref only)
+    // null elements have FunctionType::s_invalidCanonicalIndex, so they never match a call_indirect signature
+    uint32_t signature(uint32_t elemIndex) const
     {
-        ASSERT(elemIndex < m_size);
-        ASSERT(val.type() == m_type);
-        m_elements[elemIndex] = val;
+        ASSERT(m_type == Value::Type::FuncRef);
+        ASSERT(elemIndex < size());
+        return m_signatures[elemIndex];
     }
 
 private:
-    // Table has elements of reference type (FuncRef | ExternRef)
+    static uint32_t signatureOf(void* ref);
+    static void throwException();
+
+    // every element has the table type (FuncRef | ExternRef), so elements are stored as a single word
     Value::Type m_type;
-    size_t m_size;
     size_t m_maximumSize;
+    uint64_t m_version;
 
-    ValueVector m_elements;
+    Vector<void*, GCUtil::gc_malloc_allocator<void*>> m_elements;
+    // parallel to m_elements for funcref tables, empty for externref tables
+    Vector<uint32_t, GCUtil::gc_malloc_atomic_allocator<uint32_t>> m_signatures;
 };
 
 } // namespace Walrus
 
-#endif // __WalrusInstance__
+#endif // __WalrusTable__
@@ -16,6 +16,8 @@
 #include "Walrus.h"
 
 #include "Trap.h"
+#include "runtime/Function.h"
+#include "runtime/FunctionType.h"
 
 namespace Walrus {
 
@@ -32,6 +34,30 @@ Trap::TrapResult Trap::run(void (*runner)(ExecutionState&, void*), void* data)
     return r;
 }
 
+size_t Trap::runBatch(Function* function, size_t count, Value* argv, Value* result, TrapResult* trapResults)
+{
+    const size_t paramCount = function->functionType()->param().size();
+    const size_t resultCount = function->functionType()->result().size();
+    size_t trapCount = 0;
+    size_t i = 0;
+
+    ExecutionState state;
+    while (i < count) {
+        // the try block is only entered again after a trap
+        try {
+            for (; i < count; i++) {
+                function->call(state, paramCount, argv + i * paramCount, result + i * resultCount);
+            }
+        } catch (std::unique_ptr<Exception>& e) {
+            trapResults[i].exception = std::move(e);
+            trapCount++;
+            i++;
+        }
+    }
+
+    return trapCount;
+}
+
 void Trap::throwException(String* message)
 {
     throw Exception::create(message);
@@ -23,6 +23,8 @@
 
 namespace Walrus {
 
+class Function;
+
 class Trap {
     MAKE_STACK_ALLOCATED();
 
@@ -36,6 +38,13 @@ public:
     };
 
     TrapResult run(void (*runner)(ExecutionState&, void*), void* data);
+
+    // calls function count times in a single trap scope
+    // argv holds the parameters of each call after each other, and the results are written into result the same way
+    // a trap only stops the call which raised it, and is stored in trapResults[i]
+    // the result slots of a trapped call are left untouched, since results are only written when a call returns
+    // returns the number of calls which trapped
+    size_t runBatch(Function* function, size_t count, Value* argv, Value* result, TrapResult* trapResults);
     static void throwException(String* message);
 
 private:
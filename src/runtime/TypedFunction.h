@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2022-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WalrusTypedFunction__
+#define __WalrusTypedFunction__
+
+#include "runtime/Function.h"
+#include "runtime/Module.h"
+#include "runtime/Store.h"
+#include "interpreter/Interpreter.h"
+
+namespace Walrus {
+
+// maps the C++ types of typed calls to wasm value types
+template <typename T>
+struct TypedValue;
+
+template <>
+struct TypedValue<int32_t> {
+    static Value::Type type() { return Value::I32; }
+    static int32_t fromValue(const Value& value) { return value.asI32(); }
+};
+
+template <>
+struct TypedValue<int64_t> {
+    static Value::Type type() { return Value::I64; }
+    static int64_t fromValue(const Value& value) { return value.asI64(); }
+};
+
+template <>
+struct TypedValue<float> {
+    static Value::Type type() { return Value::F32; }
+    static float fromValue(const Value& value) { return value.asF32(); }
+};
+
+template <>
+struct TypedValue<double> {
+    static Value::Type type() { return Value::F64; }
+    static double fromValue(const Value& value) { return value.asF64(); }
+};
+
+template <>
+struct TypedValue<Function*> {
+    static Value::Type type() { return Value::FuncRef; }
+    static Function* fromValue(const Value& value) { return value.asFunction(); }
+};
+
+template <typename R>
+struct TypedResult {
+    static bool matches(const FunctionType::FunctionTypeVector& result)
+    {
+        return result.size() == 1 && result[0] == TypedValue<R>::type();
+    }
+
+    // the result is on the top of the stack
+    static FunctionType::FunctionTypeVector types()
+    {
+        FunctionType::FunctionTypeVector result;
+        result.pushBack(TypedValue<R>::type());
+        return result;
+    }
+
+    static R read(const uint8_t* stackPointer)
+    {
+        return *reinterpret_cast<const R*>(stackPointer - stackAllocatedSize<R>());
+    }
+
+    static R fromValue(const Value* result)
+    {
+        return TypedValue<R>::fromValue(result[0]);
+    }
+};
+
+template <>
+struct TypedResult<void> {
+    static bool matches(const FunctionType::FunctionTypeVector& result)
+    {
+        return result.size() == 0;
+    }
+
+    static FunctionType::FunctionTypeVector types()
+    {
+        return FunctionType::FunctionTypeVector();
+    }
+
+    static void read(const uint8_t* stackPointer)
+    {
+    }
+
+    static void fromValue(const Value* result)
+    {
+    }
+};
+
+// reads the arguments of a host function one by one from the stack, then calls it
+template <typename R, typename... Remaining>
+struct HostArgumentReader;
+
+template <typename R>
+struct HostArgumentReader<R> {
+    template <typename Callback, typename... Read>
+    static ALWAYS_INLINE R call(Callback callback, ExecutionState& state, const uint8_t* stack, void* data, Read... read)
+    {
+        return callback(state, read..., data);
+    }
+};
+
+template <typename R, typename T, typename... Remaining>
+struct HostArgumentReader<R, T, Remaining...> {
+    template <typename Callback, typename... Read>
+    static ALWAYS_INLINE R call(Callback callback, ExecutionState& state, const uint8_t* stack, void* data, Read... read)
+    {
+        T value = *reinterpret_cast<const T*>(stack);
+        return HostArgumentReader<R, Remaining...>::call(callback, state, stack + stackAllocatedSize<T>(), data, read..., value);
+    }
+};
+
+template <typename R, typename... Args>
+struct HostFunction<R(Args...)> {
+    typedef R (*Callback)(ExecutionState& state, Args... args, void* data);
+
+    struct Data : public gc {
+        Callback m_callback;
+        void* m_data;
+    };
+
+    static void callWithStack(ExecutionState& state, uint8_t* stack, void* data)
+    {
+        Data* hostData = reinterpret_cast<Data*>(data);
+        R result = HostArgumentReader<R, Args...>::call(hostData->m_callback, state, stack, hostData->m_data);
+        *reinterpret_cast<R*>(stack) = result;
+    }
+};
+
+template <typename... Args>
+struct HostFunction<void(Args...)> {
+    typedef void (*Callback)(ExecutionState& state, Args... args, void* data);
+
+    struct Data : public gc {
+        Callback m_callback;
+        void* m_data;
+    };
+
+    static void callWithStack(ExecutionState& state, uint8_t* stack, void* data)
+    {
+        Data* hostData = reinterpret_cast<Data*>(data);
+        HostArgumentReader<void, Args...>::call(hostData->m_callback, state, stack, hostData->m_data);
+    }
+};
+
+template <typename Signature>
+class TypedFunction;
+
+// call handle of a function with a signature known at compile time, e.g. TypedFunction<int32_t(int64_t, double)>
+// the signature is checked once when the handle is created, and calls of defined functions
+// write the arguments into the frame of the callee and read the result from it without boxing them into Values
+// results with more than one value are not supported
+template <typename R, typename... Args>
+class TypedFunction<R(Args...)> {
+public:
+    TypedFunction()
+        : m_function(nullptr)
+    {
+    }
+
+    // returns null if the function does not have the given signature
+    static Optional<TypedFunction> create(Function* function)
+    {
+        if (!matches(function->functionType())) {
+            return nullptr;
+        }
+        return TypedFunction(function);
+    }
+
+    static FunctionType::FunctionTypeVector paramTypes()
+    {
+        const Value::Type types[] = { TypedValue<Args>::type()..., Value::Void };
+        FunctionType::FunctionTypeVector param;
+        param.reserve(sizeof...(Args));
+        for (size_t i = 0; i < sizeof...(Args); i++) {
+            param.pushBack(types[i]);
+        }
+        return param;
+    }
+
+    static FunctionType::FunctionTypeVector resultTypes()
+    {
+        return TypedResult<R>::types();
+    }
+
+    static bool matches(FunctionType* functionType)
+    {
+        const Value::Type types[] = { TypedValue<Args>::type()..., Value::Void };
+        const FunctionType::FunctionTypeVector& param = functionType->param();
+        if (param.size() != sizeof...(Args)) {
+            return false;
+        }
+        for (size_t i = 0; i < param.size(); i++) {
+            if (param[i] != types[i]) {
+                return false;
+            }
+        }
+        return TypedResult<R>::matches(functionType->result());
+    }
+
+    Function* function() const { return m_function; }
+
+    // must be called in the runner of Trap::run, which catches the traps of the call
+    // the runner can call any number of functions
+    R call(ExecutionState& state, Args... args) const
+    {
+        if (LIKELY(m_function->isDefinedFunction())) {
+            DefinedFunction* function = m_function->asDefinedFunction();
+            ModuleFunction* moduleFunction = function->moduleFunction();
+            moduleFunction->compileIfNeeded();
+
+            ExecutionState newState(state, function);
+            uint8_t* functionStackBase = ALLOCA(moduleFunction->requiredStackSize(), uint8_t);
+            uint8_t* functionStackPointer = functionStackBase;
+            int expand[] = { 0, (writeArgument(functionStackPointer, args), 0)... };
+            UNUSED_VARIABLE(expand);
+            auto localSize = moduleFunction->requiredStackSizeDueToLocal();
+            memset(functionStackPointer, 0, localSize);
+            functionStackPointer += localSize;
+
+            Interpreter::interpret(newState, reinterpret_cast<size_t>(moduleFunction->byteCode()), functionStackBase, functionStackPointer);
+            return TypedResult<R>::read(functionStackPointer);
+        }
+
+        Value argv[] = { Value(args)..., Value() };
+        Value result[1];
+        m_function->call(state, sizeof...(Args), argv, result);
+        return TypedResult<R>::fromValue(result);
+    }
+
+private:
+    explicit TypedFunction(Function* function)
+        : m_function(function)
+    {
+    }
+
+    template <typename T>
+    static void writeArgument(uint8_t*& ptr, T value)
+    {
+        *reinterpret_cast<T*>(ptr) = value;
+        ptr += stackAllocatedSize<T>();
+    }
+
+    Function* m_function;
+};
+
+template <typename Signature>
+ImportedFunction* Store::makeHostFunction(typename HostFunction<Signature>::Callback callback, void* data)
+{
+    typedef TypedFunction<Signature> Typed;
+    FunctionType* functionType = new FunctionType(FunctionType::s_noModuleIndex, Typed::paramTypes(), Typed::resultTypes());
+    internFunctionType(functionType);
+
+    typename HostFunction<Signature>::Data* hostData = new typename HostFunction<Signature>::Data();
+    hostData->m_callback = callback;
+    hostData->m_data = data;
+    return new ImportedFunction(this, functionType, &HostFunction<Signature>::callWithStack, hostData);
+}
+
+} // namespace Walrus
+
+#endif // __WalrusTypedFunction__
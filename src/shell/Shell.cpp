@@ -3,14 +3,21 @@
 #include <sstream>
 #include <iomanip>
 #include <inttypes.h>
+#include <thread>
 
 #include "Walrus.h"
 #include "runtime/Engine.h"
 #include "runtime/Store.h"
 #include "runtime/Module.h"
+#include "runtime/ModuleCache.h"
+#include "runtime/SharedModuleCache.h"
 #include "runtime/Function.h"
+#include "runtime/TypedFunction.h"
 #include "runtime/Instance.h"
+#include "runtime/Memory.h"
+#include "runtime/InstancePool.h"
 #include "runtime/Trap.h"
+#include "runtime/GCThreadScope.h"
 #include "parser/WASMParser.h"
 
 #include "wabt/wast-lexer.h"
@@ -92,9 +99,17 @@ static void printF64(double v)
     printf("%s : f64\n", formatDecmialString(ss.str()).c_str());
 }
 
-static void executeWASM(Store* store, const std::vector<uint8_t>& src, Instance::InstanceVector& instances)
+// the instance which calls a host function
+// the state of a host function is a child of the calling wasm function's state
+static Instance* callerInstance(ExecutionState& state)
+{
+    return state.parent()->currentFunction()->asDefinedFunction()->instance();
+}
+
+// with pool, the instance is acquired from a new InstancePool of the module
+
+static void executeWASM(Store* store, Module* module, Instance::InstanceVector& instances, size_t threadCount = 1, InstancePool** pool = nullptr)
 {
-    auto module = WASMParser::parseBinary(store, src.data(), src.size());
     const auto& moduleImportData = module->moduleImport();
 
     ValueVector importValues;
@@ -126,54 +141,39 @@ static void executeWASM(Store* store, const std::vector<uint8_t>& src, Instance:
             if (import->fieldName()->equals("print_i32")) {
                 auto ft = module->functionType(import->functionTypeIndex());
                 ASSERT(ft->result().size() == 0 && ft->param().size() == 1 && ft->param()[0] == Value::Type::I32);
-                importValues[i] = Value(new ImportedFunction(
-                    store,
-                    ft,
-                    [](ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data) {
-                        printI32(argv[0].asI32());
-                    },
-                    nullptr));
+                importValues[i] = Value(store->makeHostFunction<void(int32_t)>(
+                    [](ExecutionState& state, int32_t value, void* data) {
+                        printI32(value);
+                    }));
             } else if (import->fieldName()->equals("print_i64")) {
                 auto ft = module->functionType(import->functionTypeIndex());
                 ASSERT(ft->result().size() == 0 && ft->param().size() == 1 && ft->param()[0] == Value::Type::I64);
-                importValues[i] = Value(new ImportedFunction(
-                    store,
-                    ft,
-                    [](ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data) {
-                        printI64(argv[0].asI64());
-                    },
-                    nullptr));
+                importValues[i] = Value(store->makeHostFunction<void(int64_t)>(
+                    [](ExecutionState& state, int64_t value, void* data) {
+                        printI64(value);
+                    }));
             } else if (import->fieldName()->equals("print_f32")) {
                 auto ft = module->functionType(import->functionTypeIndex());
                 ASSERT(ft->result().size() == 0 && ft->param().size() == 1 && ft->param()[0] == Value::Type::F32);
-                importValues[i] = Value(new ImportedFunction(
-                    store,
-                    ft,
-                    [](ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data) {
-                        printF32(argv[0].asF32());
-                    },
-                    nullptr));
+                importValues[i] = Value(store->makeHostFunction<void(float)>(
+                    [](ExecutionState& state, float value, void* data) {
+                        printF32(value);
+                    }));
             } else if (import->fieldName()->equals("print_f64")) {
                 auto ft = module->functionType(import->functionTypeIndex());
                 ASSERT(ft->result().size() == 0 && ft->param().size() == 1 && ft->param()[0] == Value::Type::F64);
-                importValues[i] = Value(new ImportedFunction(
-                    store,
-                    ft,
-                    [](ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data) {
-                        printF64(argv[0].asF64());
-                    },
-                    nullptr));
+                importValues[i] = Value(store->makeHostFunction<void(double)>(
+                    [](ExecutionState& state, double value, void* data) {
+                        printF64(value);
+                    }));
             } else if (import->fieldName()->equals("print_i32_f32")) {
                 auto ft = module->functionType(import->functionTypeIndex());
                 ASSERT(ft->result().size() == 0 && ft->param().size() == 2 && ft->param()[0] == Value::Type::I32 && ft->param()[1] == Value::Type::F32);
-                importValues[i] = Value(new ImportedFunction(
-                    store,
-                    ft,
-                    [](ExecutionState& state, const uint32_t argc, Value* argv, Value* result, void* data) {
-                        printI32(argv[0].asI32());
-                        printF32(argv[1].asF32());
-                    },
-                    nullptr));
+                importValues[i] = Value(store->makeHostFunction<void(int32_t, float)>(
+                    [](ExecutionState& state, int32_t i32, float f32, void* data) {
+                        printI32(i32);
+                        printF32(f32);
+                    }));
             } else if (import->fieldName()->equals("global_i32")) {
                 importValues[i] = Value(int32_t(666));
             } else if (import->fieldName()->equals("global_i64")) {
@@ -183,12 +183,115 @@ static void executeWASM(Store* store, const std::vector<uint8_t>& src, Instance:
             } else if (import->fieldName()->equals("global_f64")) {
                 importValues[i] = Value(double(0x4084d00000000000));
             }
+        } else if (import->moduleName()->equals("walrus")) {
+            // runtime APIs without a wasm instruction, for tests
+            if (import->fieldName()->equals("memory_discard")) {
+                importValues[i] = Value(store->makeHostFunction<int32_t(int64_t, int64_t)>(
+                    [](ExecutionState& state, int64_t offset, int64_t size, void* data) -> int32_t {
+                        return callerInstance(state)->memory(0)->discard(offset, size);
+                    }));
+            } else if (import->fieldName()->equals("memory_resident_size")) {
+                importValues[i] = Value(store->makeHostFunction<int64_t()>(
+                    [](ExecutionState& state, void* data) -> int64_t {
+                        return callerInstance(state)->memory(0)->statistics().residentSizeInByte;
+                    }));
+            } else if (import->fieldName()->equals("memory_committed_size")) {
+                importValues[i] = Value(store->makeHostFunction<int64_t()>(
+                    [](ExecutionState& state, void* data) -> int64_t {
+                        return callerInstance(state)->memory(0)->statistics().committedSizeInByte;
+                    }));
+            } else if (import->fieldName()->equals("has_unread_name_section")) {
+                importValues[i] = Value(store->makeHostFunction<int32_t()>(
+                    [](ExecutionState& state, void* data) -> int32_t {
+                        return callerInstance(state)->module()->hasUnreadNameSection();
+                    }));
+            } else if (import->fieldName()->equals("function_name_length")) {
+                // -1 when the function has no name
+                importValues[i] = Value(store->makeHostFunction<int32_t(int32_t)>(
+                    [](ExecutionState& state, int32_t index, void* data) -> int32_t {
+                        auto name = callerInstance(state)->module()->functionName(index);
+                        return name ? static_cast<int32_t>(name->length()) : -1;
+                    }));
+            } else if (import->fieldName()->equals("function_name_byte")) {
+                importValues[i] = Value(store->makeHostFunction<int32_t(int32_t, int32_t)>(
+                    [](ExecutionState& state, int32_t index, int32_t offset, void* data) -> int32_t {
+                        return static_cast<uint8_t>(callerInstance(state)->module()->functionName(index)->buffer()[offset]);
+                    }));
+            }
         }
     }
 
+    if (threadCount > 1) {
+        // the module is instantiated on every thread at once, e.g. to measure
+        // the throughput of independent instances of one module (see tools/thread-benchmark.py)
+        Instance::InstanceVector parallelInstances;
+        parallelInstances.resize(threadCount);
+#if defined(GC_THREADS)
+        GCThreadScope::allowRegistration();
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.push_back(std::thread([&, i]() {
+                GCThreadScope scope;
+                parallelInstances[i] = module->instantiate(importValues);
+            }));
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            threads[i].join();
+        }
+#else
+        // bdwgc does not support threads, so the instances run one after another
+        for (size_t i = 0; i < threadCount; i++) {
+            parallelInstances[i] = module->instantiate(importValues);
+        }
+#endif
+        for (size_t i = 0; i < threadCount; i++) {
+            instances.pushBack(parallelInstances[i]);
+        }
+        return;
+    }
+
+    if (pool) {
+        *pool = new InstancePool(module, importValues);
+        instances.pushBack((*pool)->acquire());
+        return;
+    }
+
     instances.pushBack(module->instantiate(importValues));
 }
 
+// the caches are keyed by the hash of the whole binary
+// with streamChunkSize, the binary is given to the streaming parser in pieces of that size
+static Optional<Module*> loadModule(Store* store, const uint8_t* data, size_t len, const ParseOptions& parseOptions, const std::string& moduleCacheDirectory,
+                                    size_t streamChunkSize = 0)
+{
+    if (streamChunkSize) {
+        WASMStreamingParser parser(store, parseOptions);
+        for (size_t offset = 0; offset < len; offset += streamChunkSize) {
+            parser.append(data + offset, std::min(streamChunkSize, len - offset));
+        }
+        return parser.finish();
+    }
+    if (moduleCacheDirectory.empty()) {
+        return store->engine()->moduleCache()->load(store, data, len, parseOptions);
+    }
+    ModuleCache cache(moduleCacheDirectory);
+    return cache.load(store, data, len, parseOptions);
+}
+
+// the ParseOptions::Feature bit of a feature named as in wabt (e.g. "sign-extension"), or 0
+static uint32_t featureBit(const std::string& name)
+{
+    uint32_t bit = 1;
+#define WABT_FEATURE(variable, flag, default_, help) \
+    if (name == flag) {                              \
+        return bit;                                  \
+    }                                                \
+    bit <<= 1;
+#include "wabt/feature.def"
+#undef WABT_FEATURE
+    return 0;
+}
+
 static bool endsWith(const std::string& str, const std::string& suffix)
 {
     return str.size() >= suffix.size() && 0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
@@ -312,6 +415,58 @@ static void printConstVector(wabt::ConstVector& v)
     }
 }
 
+static void checkInvokeResult(wabt::InvokeAction* action, Walrus::Function* fn, Walrus::Value* result, const Walrus::Trap::TrapResult& trapResult,
+                              wabt::ConstVector& expectedResult, const char* expectedException)
+{
+    if (expectedException) {
+        RELEASE_ASSERT(trapResult.exception);
+        RELEASE_ASSERT(trapResult.exception->message()->equals(expectedException, strlen(expectedException)));
+        printf("invoke %s(", action->name.data());
+        printConstVector(action->args);
+        printf("), expect exception: %s (line: %d) : OK\n", expectedException, action->loc.line);
+    } else {
+        RELEASE_ASSERT(!trapResult.exception);
+        RELEASE_ASSERT(fn->functionType()->result().size() == expectedResult.size());
+        // compare result
+        for (size_t i = 0; i < expectedResult.size(); i++) {
+            RELEASE_ASSERT(equals(result[i], expectedResult[i]));
+        }
+        printf("invoke %s(", action->name.data());
+        printConstVector(action->args);
+        printf(") expect value(");
+        printConstVector(expectedResult);
+        printf(") (line: %d) : OK\n", action->loc.line);
+    }
+}
+
+// calls of common signatures go through TypedFunction, which skips boxing arguments and results of defined functions
+static void callFunction(Walrus::ExecutionState& state, Walrus::Function* fn, Walrus::Value* argv, Walrus::Value* result)
+{
+    using Walrus::TypedFunction;
+    if (auto typed = TypedFunction<void()>::create(fn)) {
+        typed.value().call(state);
+    } else if (auto typed = TypedFunction<void(int32_t)>::create(fn)) {
+        typed.value().call(state, argv[0].asI32());
+    } else if (auto typed = TypedFunction<int32_t()>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state));
+    } else if (auto typed = TypedFunction<int32_t(int32_t)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asI32()));
+    } else if (auto typed = TypedFunction<int32_t(int32_t, int32_t)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asI32(), argv[1].asI32()));
+    } else if (auto typed = TypedFunction<int64_t(int64_t)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asI64()));
+    } else if (auto typed = TypedFunction<int64_t(int64_t, int64_t)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asI64(), argv[1].asI64()));
+    } else if (auto typed = TypedFunction<float(float, float)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asF32(), argv[1].asF32()));
+    } else if (auto typed = TypedFunction<double(double, double)>::create(fn)) {
+        result[0] = Walrus::Value(typed.value().call(state, argv[0].asF64(), argv[1].asF64()));
+    } else {
+        // e.g. functions with more than one result
+        fn->call(state, fn->functionType()->param().size(), argv, result);
+    }
+}
+
 static void executeInvokeAction(wabt::InvokeAction* action, Walrus::Function* fn, wabt::ConstVector expectedResult, const char* expectedException)
 {
     RELEASE_ASSERT(fn->functionType()->param().size() == action->args.size());
@@ -319,48 +474,90 @@ static void executeInvokeAction(wabt::InvokeAction* action, Walrus::Function* fn
     for (auto& a : action->args) {
         args.pushBack(toWalrusValue(a));
     }
+    Walrus::ValueVector result;
+    result.resize(fn->functionType()->result().size());
 
     struct RunData {
         Walrus::Function* fn;
-        wabt::ConstVector& expectedResult;
         Walrus::ValueVector& args;
-    } data = { fn, expectedResult, args };
+        Walrus::ValueVector& result;
+    } data = { fn, args, result };
     Walrus::Trap trap;
     auto trapResult = trap.run([](Walrus::ExecutionState& state, void* d) {
         RunData* data = reinterpret_cast<RunData*>(d);
-        Walrus::ValueVector result;
-        result.resize(data->expectedResult.size());
-        data->fn->call(state, data->args.size(), data->args.data(), result.data());
-        RELEASE_ASSERT(data->fn->functionType()->result().size() == data->expectedResult.size());
-        // compare result
-        for (size_t i = 0; i < result.size(); i++) {
-            RELEASE_ASSERT(equals(result[i], data->expectedResult[i]));
-        }
+        callFunction(state, data->fn, data->args.data(), data->result.data());
     },
                                &data);
-    if (expectedResult.size()) {
-        RELEASE_ASSERT(!trapResult.exception);
+    checkInvokeResult(action, fn, result.data(), trapResult, expectedResult, expectedException);
+}
+
+// assert_return or assert_trap of an invoke action
+struct InvokeCommand {
+    wabt::InvokeAction* action;
+    wabt::ConstVector* expectedResult;
+    const char* expectedException;
+};
+
+static bool toInvokeCommand(wabt::Command* command, InvokeCommand& invoke)
+{
+    static wabt::ConstVector noResult;
+    if (auto* assertReturn = dynamic_cast<wabt::AssertReturnCommand*>(command)) {
+        if (assertReturn->action->type() == wabt::ActionType::Invoke) {
+            invoke = { dynamic_cast<wabt::InvokeAction*>(assertReturn->action.get()), &assertReturn->expected, nullptr };
+            return true;
+        }
+    } else if (auto* assertTrap = dynamic_cast<wabt::AssertTrapCommand*>(command)) {
+        if (assertTrap->action->type() == wabt::ActionType::Invoke) {
+            invoke = { dynamic_cast<wabt::InvokeAction*>(assertTrap->action.get()), &noResult, assertTrap->text.data() };
+            return true;
+        }
     }
-    if (expectedException) {
-        RELEASE_ASSERT(trapResult.exception);
-        RELEASE_ASSERT(trapResult.exception->message()->equals(expectedException, strlen(expectedException)));
-        printf("invoke %s(", action->name.data());
-        printConstVector(action->args);
-        printf("), expect exception: %s (line: %d) : OK\n", expectedException, action->loc.line);
-    } else {
-        printf("invoke %s(", action->name.data());
-        printConstVector(action->args);
-        printf(") expect value(");
-        printConstVector(expectedResult);
-        printf(") (line: %d) : OK\n", action->loc.line);
+    return false;
+}
+
+// the calls of the batch are made by one Trap::runBatch, so a trap only stops its own call
+static void executeInvokeBatch(Walrus::Function* fn, std::vector<InvokeCommand>& batch)
+{
+    const size_t paramCount = fn->functionType()->param().size();
+    const size_t resultCount = fn->functionType()->result().size();
+    Walrus::ValueVector argv;
+    for (size_t i = 0; i < batch.size(); i++) {
+        RELEASE_ASSERT(batch[i].action->args.size() == paramCount);
+        for (auto& a : batch[i].action->args) {
+            argv.pushBack(toWalrusValue(a));
+        }
+    }
+    Walrus::ValueVector result;
+    result.resize(batch.size() * resultCount);
+    std::vector<Walrus::Trap::TrapResult> trapResults(batch.size());
+
+    Walrus::Trap trap;
+    trap.runBatch(fn, batch.size(), argv.data(), result.data(), trapResults.data());
+    for (size_t i = 0; i < batch.size(); i++) {
+        checkInvokeResult(batch[i].action, fn, result.data() + i * resultCount, trapResults[i], *batch[i].expectedResult, batch[i].expectedException);
+    }
+}
+
+// releases the instance of the module to its pool, so the next command starts from the state after instantiation
+static void recycleInstance(std::map<size_t, Instance*>& instanceMap, const std::map<size_t, InstancePool*>& poolMap, size_t moduleIndex)
+{
+    auto iter = poolMap.find(moduleIndex);
+    if (iter == poolMap.end()) {
+        return;
     }
+    iter->second->release(instanceMap[moduleIndex]);
+    instanceMap[moduleIndex] = iter->second->acquire();
 }
 
-static void executeWAST(Store* store, const std::vector<uint8_t>& src, Instance::InstanceVector& instances)
+// with batchInvoke, consecutive assertions which invoke the same export are run as one batch
+// with useInstancePool, every instance is reset to its state after instantiation after each assertion
+// with streamChunkSize, modules are read by the streaming parser (see loadModule)
+static bool executeWAST(Store* store, const std::vector<uint8_t>& src, Instance::InstanceVector& instances, const ParseOptions& parseOptions,
+                        const std::string& moduleCacheDirectory, bool batchInvoke = false, bool useInstancePool = false, size_t streamChunkSize = 0)
 {
     auto lexer = wabt::WastLexer::CreateBufferLexer("test.wabt", src.data(), src.size());
     if (!lexer) {
-        return;
+        return false;
     }
 
     wabt::Errors errors;
@@ -370,41 +567,104 @@ static void executeWAST(Store* store, const std::vector<uint8_t>& src, Instance:
     wabt::WastParseOptions parse_wast_options(features);
     auto result = wabt::ParseWastScript(lexer.get(), &script, &errors, &parse_wast_options);
     if (!wabt::Succeeded(result)) {
-        return;
+        printf("Cannot parse script\n");
+        return false;
     }
 
     std::map<size_t, Instance*> instanceMap;
+    std::map<size_t, InstancePool*> poolMap;
+    // keeps the pools reachable for the GC
+    Vector<InstancePool*, GCUtil::gc_malloc_allocator<InstancePool*>> pools;
     size_t commandCount = 0;
-    for (const std::unique_ptr<wabt::Command>& command : script->commands) {
-        if (auto* moduleCommand = dynamic_cast<wabt::ModuleCommand*>(command.get())) {
-            auto module = &moduleCommand->module;
-            wabt::MemoryStream stream;
-            wabt::WriteBinaryOptions options;
-            options.features = features;
-            wabt::WriteBinaryModule(&stream, module, options);
-            stream.Flush();
-            auto buf = stream.ReleaseOutputBuffer();
-            executeWASM(store, buf->data, instances);
+    for (size_t commandIndex = 0; commandIndex < script->commands.size(); commandIndex++) {
+        const std::unique_ptr<wabt::Command>& command = script->commands[commandIndex];
+        InvokeCommand invoke;
+        if (batchInvoke && toInvokeCommand(command.get(), invoke)) {
+            std::vector<InvokeCommand> batch(1, invoke);
+            InvokeCommand next;
+            while (commandIndex + 1 < script->commands.size() && toInvokeCommand(script->commands[commandIndex + 1].get(), next)
+                   && next.action->module_var.index() == invoke.action->module_var.index() && next.action->name == invoke.action->name) {
+                batch.push_back(next);
+                commandIndex++;
+                commandCount++;
+            }
+            auto value = instanceMap[invoke.action->module_var.index()]->resolveExport(invoke.action->name.data(), invoke.action->name.size());
+            RELEASE_ASSERT(value.type() == Walrus::Value::FuncRef);
+            executeInvokeBatch(value.asFunction(), batch);
+            recycleInstance(instanceMap, poolMap, invoke.action->module_var.index());
+            commandCount++;
+            continue;
+        }
+        auto* scriptModuleCommand = dynamic_cast<wabt::ScriptModuleCommand*>(command.get());
+        auto* binaryModule = scriptModuleCommand ? dynamic_cast<wabt::BinaryScriptModule*>(scriptModuleCommand->script_module.get()) : nullptr;
+        auto* moduleCommand = dynamic_cast<wabt::ModuleCommand*>(command.get());
+        if (moduleCommand || binaryModule) {
+            std::unique_ptr<wabt::OutputBuffer> buf;
+            const std::vector<uint8_t>* binary;
+            int line;
+            if (binaryModule) {
+                // binary modules are loaded as written in the script
+                binary = &binaryModule->data;
+                line = binaryModule->loc.line;
+            } else {
+                auto module = &moduleCommand->module;
+                wabt::MemoryStream stream;
+                wabt::WriteBinaryOptions options;
+                options.features = features;
+                // names are only written when the parser reads them
+                options.write_debug_names = parseOptions.m_nameSection != ParseOptions::SkipNameSection;
+                wabt::WriteBinaryModule(&stream, module, options);
+                stream.Flush();
+                buf = stream.ReleaseOutputBuffer();
+                binary = &buf->data;
+                line = module->loc.line;
+            }
+            auto loadedModule = loadModule(store, binary->data(), binary->size(), parseOptions, moduleCacheDirectory, streamChunkSize);
+            if (!loadedModule) {
+                printf("Cannot parse module (line: %d)\n", line);
+                return false;
+            }
+            InstancePool* pool = nullptr;
+            executeWASM(store, loadedModule.value(), instances, 1, useInstancePool ? &pool : nullptr);
             instanceMap[commandCount] = instances.back();
+            if (pool) {
+                pools.pushBack(pool);
+                poolMap[commandCount] = pool;
+            }
         } else if (auto* assertReturn = dynamic_cast<wabt::AssertReturnCommand*>(command.get())) {
-            auto value = instanceMap[assertReturn->action->module_var.index()]->resolveExport(new Walrus::String(assertReturn->action->name));
+            auto value = instanceMap[assertReturn->action->module_var.index()]->resolveExport(assertReturn->action->name.data(), assertReturn->action->name.size());
             if (assertReturn->action->type() == wabt::ActionType::Invoke) {
                 auto action = dynamic_cast<wabt::InvokeAction*>(assertReturn->action.get());
                 RELEASE_ASSERT(value.type() == Walrus::Value::FuncRef);
-                auto fn = instanceMap[action->module_var.index()]->resolveExport(new Walrus::String(action->name)).asFunction();
+                auto fn = instanceMap[action->module_var.index()]->resolveExport(action->name.data(), action->name.size()).asFunction();
                 executeInvokeAction(action, fn, assertReturn->expected, nullptr);
             }
+            recycleInstance(instanceMap, poolMap, assertReturn->action->module_var.index());
         } else if (auto* assertTrap = dynamic_cast<wabt::AssertTrapCommand*>(command.get())) {
-            auto value = instanceMap[assertTrap->action->module_var.index()]->resolveExport(new Walrus::String(assertTrap->action->name));
+            auto value = instanceMap[assertTrap->action->module_var.index()]->resolveExport(assertTrap->action->name.data(), assertTrap->action->name.size());
             if (assertTrap->action->type() == wabt::ActionType::Invoke) {
                 auto action = dynamic_cast<wabt::InvokeAction*>(assertTrap->action.get());
                 RELEASE_ASSERT(value.type() == Walrus::Value::FuncRef);
-                auto fn = instanceMap[action->module_var.index()]->resolveExport(new Walrus::String(action->name)).asFunction();
+                auto fn = instanceMap[action->module_var.index()]->resolveExport(action->name.data(), action->name.size()).asFunction();
                 executeInvokeAction(action, fn, wabt::ConstVector(), assertTrap->text.data());
             }
+            recycleInstance(instanceMap, poolMap, assertTrap->action->module_var.index());
+        } else if (command->type == wabt::CommandType::AssertMalformed || command->type == wabt::CommandType::AssertInvalid) {
+            // only binary modules are loaded, e.g. to check that the parser rejects broken binaries
+            auto scriptModule = command->type == wabt::CommandType::AssertMalformed
+                ? static_cast<wabt::AssertMalformedCommand*>(command.get())->module.get()
+                : static_cast<wabt::AssertInvalidCommand*>(command.get())->module.get();
+            if (auto* binaryModule = dynamic_cast<wabt::BinaryScriptModule*>(scriptModule)) {
+                auto loadedModule = loadModule(store, binaryModule->data.data(), binaryModule->data.size(), parseOptions, moduleCacheDirectory, streamChunkSize);
+                if (loadedModule) {
+                    printf("Module is not rejected (line: %d)\n", binaryModule->loc.line);
+                    return false;
+                }
+            }
         }
         commandCount++;
     }
+    return true;
 }
 
 int main(int argc, char* argv[])
@@ -427,11 +687,105 @@ int main(int argc, char* argv[])
     Store* store = new Store(engine);
 
     Instance::InstanceVector instances;
+    std::string moduleCacheDirectory;
+    size_t instanceThreadCount = 1;
+    ParseOptions parseOptions;
+    bool batchInvoke = false;
+    bool useInstancePool = false;
+    size_t streamChunkSize = 0;
 
     for (int i = 1; i < argc; i++) {
         std::string filePath = argv[i];
+        if (filePath == "--use-huge-page") {
+            engine->setUseHugePageForMemory(true);
+            continue;
+        }
+        if (filePath == "--lazy-compilation") {
+            engine->setUseLazyCompilation(true);
+            continue;
+        }
+        if (filePath.find("--compilation-threads=") == 0) {
+#if !defined(GC_THREADS)
+            fprintf(stderr, "walrus is built without WALRUS_THREADS=1, so --compilation-threads is ignored\n");
+#endif
+            engine->setCompilationThreadCount(std::stoul(filePath.substr(strlen("--compilation-threads="))));
+            continue;
+        }
+        if (filePath.find("--shared-module-cache=") == 0) {
+            engine->moduleCache()->setCapacity(std::stoul(filePath.substr(strlen("--shared-module-cache="))));
+            continue;
+        }
+        if (filePath.find("--instance-threads=") == 0) {
+            instanceThreadCount = std::stoul(filePath.substr(strlen("--instance-threads=")));
+            continue;
+        }
+        if (filePath == "--batch-invoke") {
+            batchInvoke = true;
+            continue;
+        }
+        if (filePath == "--instance-pool") {
+            useInstancePool = true;
+            continue;
+        }
+        if (filePath.find("--stream-chunk-size=") == 0) {
+            streamChunkSize = std::stoul(filePath.substr(strlen("--stream-chunk-size=")));
+            continue;
+        }
+        if (filePath.find("--name-section=") == 0) {
+            std::string mode = filePath.substr(strlen("--name-section="));
+            if (mode == "skip") {
+                parseOptions.m_nameSection = ParseOptions::SkipNameSection;
+            } else if (mode == "read") {
+                parseOptions.m_nameSection = ParseOptions::ReadNameSection;
+            } else if (mode == "lazy") {
+                parseOptions.m_nameSection = ParseOptions::ReadNameSectionLazily;
+            } else {
+                printf("Unknown name section mode %s\n", mode.data());
+                return -1;
+            }
+            continue;
+        }
+        if (filePath.find("--disable-feature=") == 0) {
+            uint32_t feature = featureBit(filePath.substr(strlen("--disable-feature=")));
+            if (!feature) {
+                printf("Unknown feature %s\n", argv[i]);
+                return -1;
+            }
+            parseOptions.m_features &= ~feature;
+            continue;
+        }
+        if (filePath == "--read-custom-sections") {
+            parseOptions.m_skipCustomSections = false;
+            continue;
+        }
+        if (filePath == "--trusted-module") {
+            parseOptions.m_isTrusted = true;
+            continue;
+        }
+        if (filePath.find("--module-cache=") == 0) {
+            moduleCacheDirectory = filePath.substr(strlen("--module-cache="));
+            continue;
+        }
         FILE* fp = fopen(filePath.data(), "r");
         if (fp) {
+            if (endsWith(filePath, "wasm") && moduleCacheDirectory.empty() && !engine->moduleCache()->capacity()) {
+                // compile while the rest of the file is still being read (e.g. from a pipe)
+                WASMStreamingParser parser(store, parseOptions);
+                std::vector<uint8_t> chunk(streamChunkSize ? streamChunkSize : 64 * 1024);
+                size_t len;
+                while ((len = fread(chunk.data(), 1, chunk.size(), fp)) > 0) {
+                    parser.append(chunk.data(), len);
+                }
+                fclose(fp);
+                auto module = parser.finish();
+                if (!module) {
+                    printf("Cannot parse file %s\n", argv[i]);
+                    return -1;
+                }
+                executeWASM(store, module.value(), instances, instanceThreadCount);
+                continue;
+            }
+
             fseek(fp, 0, SEEK_END);
             auto sz = ftell(fp);
             fseek(fp, 0, SEEK_SET);
@@ -441,9 +795,16 @@ int main(int argc, char* argv[])
             fclose(fp);
 
             if (endsWith(filePath, "wasm")) {
-                executeWASM(store, buf, instances);
+                Optional<Module*> module = loadModule(store, buf.data(), buf.size(), parseOptions, moduleCacheDirectory);
+                if (!module) {
+                    printf("Cannot parse file %s\n", argv[i]);
+                    return -1;
+                }
+                executeWASM(store, module.value(), instances, instanceThreadCount);
             } else if (endsWith(filePath, "wat") || endsWith(filePath, "wast")) {
-                executeWAST(store, buf, instances);
+                if (!executeWAST(store, buf, instances, parseOptions, moduleCacheDirectory, batchInvoke, useInstancePool, streamChunkSize)) {
+                    return -1;
+                }
             }
         } else {
             printf("Cannot open file %s\n", argv[i]);
@@ -26,6 +26,7 @@ public:
         m_buffer = reinterpret_cast<char*>(GC_MALLOC_ATOMIC(length));
         memcpy(m_buffer, buffer, length);
         m_length = length;
+        m_hash = hash(buffer, length);
     }
 
     String(const std::string& src)
@@ -39,13 +40,26 @@ public:
 
     char charAt(size_t index) const { return m_buffer[index]; }
 
+    // computed once when the string is created
+    size_t hash() const { return m_hash; }
+
+    // FNV-1a
+    static size_t hash(const char* buffer, size_t length)
+    {
+        uint64_t result = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++) {
+            result = (result ^ static_cast<uint8_t>(buffer[i])) * 1099511628211ULL;
+        }
+        return static_cast<size_t>(result);
+    }
+
     bool equals(String* src) const
     {
         if (src == this) {
             return true;
         }
 
-        if (src->m_length != m_length) {
+        if (src->m_length != m_length || src->m_hash != m_hash) {
             return false;
         }
 
@@ -72,6 +86,7 @@ public:
 private:
     char* m_buffer;
     size_t m_length;
+    size_t m_hash;
 };
 
 } // namespace Walrus
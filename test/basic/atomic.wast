@@ -0,0 +1,101 @@
+(module
+  (memory 1 2 shared)
+  (func (export "load_store")(param i32 i64)(result i64)
+    local.get 0
+    local.get 1
+    i64.atomic.store
+    local.get 0
+    i64.atomic.load
+  )
+  (func (export "load8_u")(param i32)(result i32)
+    local.get 0
+    i32.atomic.load8_u
+  )
+  (func (export "store16")(param i32 i32)
+    local.get 0
+    local.get 1
+    i32.atomic.store16
+  )
+  (func (export "rmw_add")(param i32 i32)(result i32)
+    local.get 0
+    local.get 1
+    i32.atomic.rmw.add
+  )
+  (func (export "rmw8_sub_u")(param i32 i32)(result i32)
+    local.get 0
+    local.get 1
+    i32.atomic.rmw8.sub_u
+  )
+  (func (export "rmw32_xchg_u")(param i32 i64)(result i64)
+    local.get 0
+    local.get 1
+    i64.atomic.rmw32.xchg_u
+  )
+  (func (export "cmpxchg")(param i32 i32 i32)(result i32)
+    local.get 0
+    local.get 1
+    local.get 2
+    i32.atomic.rmw.cmpxchg
+  )
+  (func (export "wait32")(param i32 i32 i64)(result i32)
+    local.get 0
+    local.get 1
+    local.get 2
+    memory.atomic.wait32
+  )
+  (func (export "wait64")(param i32 i64 i64)(result i32)
+    local.get 0
+    local.get 1
+    local.get 2
+    memory.atomic.wait64
+  )
+  (func (export "notify")(param i32 i32)(result i32)
+    atomic.fence
+    local.get 0
+    local.get 1
+    memory.atomic.notify
+  )
+  (func (export "grow")(param i32)(result i32)
+    local.get 0
+    memory.grow
+  )
+)
+
+(assert_return (invoke "load_store" (i32.const 8) (i64.const 0x0102030405060708)) (i64.const 0x0102030405060708))
+(assert_return (invoke "load8_u" (i32.const 8)) (i32.const 8))
+(assert_return (invoke "rmw_add" (i32.const 8) (i32.const 1)) (i32.const 0x05060708))
+(assert_return (invoke "rmw8_sub_u" (i32.const 8) (i32.const 0x10)) (i32.const 9))
+(assert_return (invoke "load8_u" (i32.const 8)) (i32.const 0xf9))
+(assert_return (invoke "rmw32_xchg_u" (i32.const 12) (i64.const -1)) (i64.const 0x01020304))
+(assert_return (invoke "cmpxchg" (i32.const 12) (i32.const 0) (i32.const 5)) (i32.const -1))
+(assert_return (invoke "cmpxchg" (i32.const 12) (i32.const -1) (i32.const 5)) (i32.const -1))
+(assert_return (invoke "cmpxchg" (i32.const 12) (i32.const 0) (i32.const 5)) (i32.const 5))
+(assert_return (invoke "wait32" (i32.const 12) (i32.const 0) (i64.const 0)) (i32.const 1))
+(assert_return (invoke "wait32" (i32.const 12) (i32.const 5) (i64.const 0)) (i32.const 2))
+(assert_return (invoke "wait64" (i32.const 8) (i64.const 0) (i64.const 1000)) (i32.const 1))
+(assert_return (invoke "notify" (i32.const 12) (i32.const 1)) (i32.const 0))
+(assert_trap (invoke "load8_u" (i32.const 65536)) "out of bounds memory access")
+(assert_trap (invoke "rmw_add" (i32.const 1) (i32.const 1)) "unaligned atomic")
+(assert_trap (invoke "store16" (i32.const 65535) (i32.const 1)) "out of bounds memory access")
+(assert_trap (invoke "wait32" (i32.const 2) (i32.const 0) (i64.const 0)) "unaligned atomic")
+(assert_return (invoke "grow" (i32.const 1)) (i32.const 1))
+(assert_return (invoke "load8_u" (i32.const 65536)) (i32.const 0))
+(assert_return (invoke "grow" (i32.const 1)) (i32.const -1))
+
+(module
+  (memory 1)
+  (func (export "wait32")(param i32 i32 i64)(result i32)
+    local.get 0
+    local.get 1
+    local.get 2
+    memory.atomic.wait32
+  )
+  (func (export "notify")(param i32 i32)(result i32)
+    local.get 0
+    local.get 1
+    memory.atomic.notify
+  )
+)
+
+(assert_trap (invoke "wait32" (i32.const 0) (i32.const 0) (i64.const 0)) "expected shared memory")
+(assert_return (invoke "notify" (i32.const 0) (i32.const 1)) (i32.const 0))
@@ -0,0 +1,36 @@
+;; flags: --batch-invoke
+(module
+  (global $count (mut i32) (i32.const 0))
+
+  (func (export "div") (param i32 i32) (result i32)
+    (i32.div_s (local.get 0) (local.get 1))
+  )
+
+  ;; the calls after a trap in a batch still run in order
+  (func (export "next") (param i32) (result i32)
+    (global.set $count (i32.add (global.get $count) (i32.const 1)))
+    (drop (i32.div_u (i32.const 1) (local.get 0)))
+    (global.get $count)
+  )
+
+  (func (export "swap") (param i64 i32) (result i32 i64)
+    (local.get 1)
+    (local.get 0)
+  )
+)
+
+(assert_return (invoke "div" (i32.const 7) (i32.const 2)) (i32.const 3))
+(assert_return (invoke "div" (i32.const -8) (i32.const 2)) (i32.const -4))
+(assert_trap (invoke "div" (i32.const 1) (i32.const 0)) "integer divide by zero")
+(assert_return (invoke "div" (i32.const 9) (i32.const 3)) (i32.const 3))
+(assert_trap (invoke "div" (i32.const 0x80000000) (i32.const -1)) "integer overflow")
+
+(assert_return (invoke "next" (i32.const 1)) (i32.const 1))
+(assert_return (invoke "next" (i32.const 1)) (i32.const 2))
+(assert_trap (invoke "next" (i32.const 0)) "integer divide by zero")
+(assert_trap (invoke "next" (i32.const 0)) "integer divide by zero")
+(assert_return (invoke "next" (i32.const 1)) (i32.const 5))
+
+(assert_return (invoke "swap" (i64.const 1) (i32.const 2)) (i32.const 2) (i64.const 1))
+(assert_return (invoke "swap" (i64.const -1) (i32.const 0)) (i32.const 0) (i64.const -1))
+(assert_trap (invoke "div" (i32.const 1) (i32.const 0)) "integer divide by zero")
@@ -0,0 +1,122 @@
+(module
+  (type $i32_i32 (func (param i32) (result i32)))
+  (type $i32_i32_dup (func (param i32) (result i32)))
+  (type $i64_i64 (func (param i64) (result i64)))
+  (table $t 4 funcref)
+
+  (func $inc (export "inc") (type $i32_i32)
+    (i32.add (local.get 0) (i32.const 1))
+  )
+  (func $dec (export "dec") (type $i32_i32_dup)
+    (i32.sub (local.get 0) (i32.const 1))
+  )
+  (func $double64 (export "double64") (type $i64_i64)
+    (i64.mul (local.get 0) (i64.const 2))
+  )
+
+  (func (export "init")
+    (table.set $t (i32.const 0) (ref.func $inc))
+    (table.set $t (i32.const 1) (ref.func $dec))
+    (table.set $t (i32.const 2) (ref.func $double64))
+  )
+  (func (export "swap")
+    (table.set $t (i32.const 0) (ref.func $dec))
+    (table.set $t (i32.const 1) (ref.func $inc))
+  )
+
+  (func (export "call_i32") (param i32 i32) (result i32)
+    (call_indirect $t (type $i32_i32) (local.get 1) (local.get 0))
+  )
+  (func (export "call_i64") (param i32 i64) (result i64)
+    (call_indirect $t (type $i64_i64) (local.get 1) (local.get 0))
+  )
+  ;; the same call site is hit repeatedly with one callee
+  (func (export "call_loop") (param i32 i32) (result i32)
+    (local i32)
+    (loop $l
+      (local.set 2 (call_indirect $t (type $i32_i32) (local.get 2) (local.get 0)))
+      (br_if $l (i32.ne (local.get 2) (local.get 1)))
+    )
+    (local.get 2)
+  )
+  (func (export "is_null") (param i32) (result i32)
+    (ref.is_null (table.get $t (local.get 0)))
+  )
+)
+
+(assert_trap (invoke "call_i32" (i32.const 0) (i32.const 5)) "uninitialized element")
+(assert_return (invoke "init"))
+(assert_return (invoke "call_i32" (i32.const 0) (i32.const 5)) (i32.const 6))
+(assert_return (invoke "call_i32" (i32.const 1) (i32.const 5)) (i32.const 4))
+(assert_return (invoke "call_i32" (i32.const 0) (i32.const 7)) (i32.const 8))
+(assert_return (invoke "call_i64" (i32.const 2) (i64.const 21)) (i64.const 42))
+(assert_return (invoke "call_loop" (i32.const 0) (i32.const 1000)) (i32.const 1000))
+(assert_trap (invoke "call_i32" (i32.const 2) (i32.const 5)) "indirect call type mismatch")
+(assert_trap (invoke "call_i64" (i32.const 0) (i64.const 5)) "indirect call type mismatch")
+(assert_trap (invoke "call_i32" (i32.const 3) (i32.const 5)) "uninitialized element")
+(assert_trap (invoke "call_i32" (i32.const 4) (i32.const 5)) "undefined element")
+(assert_return (invoke "is_null" (i32.const 2)) (i32.const 0))
+(assert_return (invoke "is_null" (i32.const 3)) (i32.const 1))
+
+;; rewriting the table invalidates the cached callee
+(assert_return (invoke "swap"))
+(assert_return (invoke "call_i32" (i32.const 0) (i32.const 5)) (i32.const 4))
+(assert_return (invoke "call_i32" (i32.const 1) (i32.const 5)) (i32.const 6))
+
+;; the table is never modified, so constant index sites become direct calls
+(module
+  (type $ret_i32 (func (result i32)))
+  (type $ret_i64 (func (result i64)))
+  (table $t 6 funcref)
+  (elem (table $t) (i32.const 0) func $a $b $c)
+  (elem (table $t) (i32.const 2) func $b)
+
+  (func $a (result i32) (i32.const 10))
+  (func $b (result i32) (i32.const 20))
+  (func $c (result i32) (i32.const 30))
+
+  (func (export "const0") (result i32)
+    (call_indirect $t (type $ret_i32) (i32.const 0))
+  )
+  (func (export "const2") (result i32)
+    (call_indirect $t (type $ret_i32) (i32.const 2))
+  )
+  (func (export "const_null") (result i32)
+    (call_indirect $t (type $ret_i32) (i32.const 4))
+  )
+  (func (export "const_oob") (result i32)
+    (call_indirect $t (type $ret_i32) (i32.const 6))
+  )
+  (func (export "const_mismatch") (result i64)
+    (call_indirect $t (type $ret_i64) (i32.const 1))
+  )
+  ;; the constant is only known on one path into the call
+  (func (export "const_block") (param i32) (result i32)
+    (call_indirect $t (type $ret_i32)
+      (block (result i32)
+        (br_if 0 (local.get 0) (local.get 0))
+        (drop)
+        (i32.const 0)
+      )
+    )
+  )
+  (func (export "dynamic") (param i32) (result i32)
+    (call_indirect $t (type $ret_i32) (local.get 0))
+  )
+  (func (export "dynamic_mismatch") (param i32) (result i64)
+    (call_indirect $t (type $ret_i64) (local.get 0))
+  )
+)
+
+(assert_return (invoke "const0") (i32.const 10))
+(assert_return (invoke "const2") (i32.const 20))
+(assert_trap (invoke "const_null") "uninitialized element")
+(assert_trap (invoke "const_oob") "undefined element")
+(assert_trap (invoke "const_mismatch") "indirect call type mismatch")
+(assert_return (invoke "const_block" (i32.const 0)) (i32.const 10))
+(assert_return (invoke "const_block" (i32.const 1)) (i32.const 20))
+(assert_return (invoke "const_block" (i32.const 2)) (i32.const 20))
+(assert_return (invoke "dynamic" (i32.const 1)) (i32.const 20))
+(assert_trap (invoke "dynamic" (i32.const 3)) "uninitialized element")
+(assert_trap (invoke "dynamic" (i32.const 6)) "undefined element")
+(assert_trap (invoke "dynamic_mismatch" (i32.const 0)) "indirect call type mismatch")
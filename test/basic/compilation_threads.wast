@@ -0,0 +1,58 @@
+;; flags: --compilation-threads=4
+;; the bodies are read on worker threads when walrus is built with WALRUS_THREADS=1
+(module
+  (type $binary (func (param i32 i32) (result i32)))
+  (table 4 funcref)
+  (elem (i32.const 0) $add $sub $mul $fib)
+  (memory 1)
+
+  (func $add (param i32 i32) (result i32)
+    (i32.add (local.get 0) (local.get 1))
+  )
+  (func $sub (param i32 i32) (result i32)
+    (i32.sub (local.get 0) (local.get 1))
+  )
+  (func $mul (param i32 i32) (result i32)
+    (i32.mul (local.get 0) (local.get 1))
+  )
+  ;; the second parameter is ignored
+  (func $fib (param i32 i32) (result i32)
+    (if (result i32) (i32.lt_u (local.get 0) (i32.const 2))
+      (then (local.get 0))
+      (else
+        (i32.add
+          (call $fib (i32.sub (local.get 0) (i32.const 1)) (i32.const 0))
+          (call $fib (i32.sub (local.get 0) (i32.const 2)) (i32.const 0))
+        )
+      )
+    )
+  )
+  (func $sum (param $n i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.ge_u (local.get $i) (local.get $n)))
+        (i32.store (i32.shl (local.get $i) (i32.const 2)) (local.get $i))
+        (local.set $acc (i32.add (local.get $acc) (i32.load (i32.shl (local.get $i) (i32.const 2)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $next)
+      )
+    )
+    (local.get $acc)
+  )
+
+  (func (export "apply") (param i32 i32 i32) (result i32)
+    (call_indirect (type $binary) (local.get 1) (local.get 2) (local.get 0))
+  )
+  (func (export "sum") (param i32) (result i32)
+    (call $sum (local.get 0))
+  )
+)
+
+(assert_return (invoke "apply" (i32.const 0) (i32.const 7) (i32.const 5)) (i32.const 12))
+(assert_return (invoke "apply" (i32.const 1) (i32.const 7) (i32.const 5)) (i32.const 2))
+(assert_return (invoke "apply" (i32.const 2) (i32.const 7) (i32.const 5)) (i32.const 35))
+(assert_return (invoke "apply" (i32.const 3) (i32.const 10) (i32.const 0)) (i32.const 55))
+(assert_trap (invoke "apply" (i32.const 4) (i32.const 0) (i32.const 0)) "undefined element")
+(assert_return (invoke "sum" (i32.const 100)) (i32.const 4950))
@@ -0,0 +1,100 @@
+(module
+  (type $ret (func (result i32)))
+  (table $t 8 funcref)
+  (table $u 4 funcref)
+
+  (func $f0 (result i32) (i32.const 0))
+  (func $f1 (result i32) (i32.const 1))
+  (func $f2 (result i32) (i32.const 2))
+  (func $f3 (result i32) (i32.const 3))
+
+  (elem (table $t) (i32.const 1) func $f0 $f1)
+  (elem $passive func $f2 $f3 $f0)
+  (elem $passive_expr funcref (ref.func $f3) (ref.null func))
+  (elem declare func $f1)
+
+  (func (export "call") (param i32) (result i32)
+    (call_indirect $t (type $ret) (local.get 0))
+  )
+  (func (export "call_u") (param i32) (result i32)
+    (call_indirect $u (type $ret) (local.get 0))
+  )
+  (func (export "is_null") (param i32) (result i32)
+    (ref.is_null (table.get $t (local.get 0)))
+  )
+  (func (export "init") (param i32 i32 i32)
+    (table.init $t $passive (local.get 0) (local.get 1) (local.get 2))
+  )
+  (func (export "init_expr") (param i32 i32 i32)
+    (table.init $t $passive_expr (local.get 0) (local.get 1) (local.get 2))
+  )
+  (func (export "drop")
+    (elem.drop $passive)
+  )
+  (func (export "copy") (param i32 i32 i32)
+    (table.copy $t $t (local.get 0) (local.get 1) (local.get 2))
+  )
+  (func (export "copy_to_u") (param i32 i32 i32)
+    (table.copy $u $t (local.get 0) (local.get 1) (local.get 2))
+  )
+  (func (export "fill") (param i32 i32)
+    (table.fill $t (local.get 0) (ref.func $f3) (local.get 1))
+  )
+  (func (export "fill_null") (param i32 i32)
+    (table.fill $t (local.get 0) (ref.null func) (local.get 1))
+  )
+)
+
+;; active segment
+(assert_trap (invoke "call" (i32.const 0)) "uninitialized element")
+(assert_return (invoke "call" (i32.const 1)) (i32.const 0))
+(assert_return (invoke "call" (i32.const 2)) (i32.const 1))
+
+;; table.init
+(assert_return (invoke "init" (i32.const 4) (i32.const 0) (i32.const 3)))
+(assert_return (invoke "call" (i32.const 4)) (i32.const 2))
+(assert_return (invoke "call" (i32.const 5)) (i32.const 3))
+(assert_return (invoke "call" (i32.const 6)) (i32.const 0))
+(assert_trap (invoke "init" (i32.const 6) (i32.const 0) (i32.const 3)) "out of bounds table access")
+(assert_trap (invoke "init" (i32.const 0) (i32.const 1) (i32.const 3)) "out of bounds table access")
+;; a trapping table.init writes nothing
+(assert_return (invoke "is_null" (i32.const 7)) (i32.const 1))
+(assert_return (invoke "init" (i32.const 8) (i32.const 3) (i32.const 0)))
+(assert_return (invoke "init_expr" (i32.const 6) (i32.const 0) (i32.const 2)))
+(assert_return (invoke "call" (i32.const 6)) (i32.const 3))
+(assert_return (invoke "is_null" (i32.const 7)) (i32.const 1))
+
+;; elem.drop
+(assert_return (invoke "drop"))
+(assert_return (invoke "drop"))
+(assert_return (invoke "init" (i32.const 0) (i32.const 0) (i32.const 0)))
+(assert_trap (invoke "init" (i32.const 0) (i32.const 0) (i32.const 1)) "out of bounds table access")
+
+;; table.copy with overlapping ranges in both directions
+(assert_return (invoke "copy" (i32.const 2) (i32.const 1) (i32.const 3)))
+(assert_return (invoke "call" (i32.const 1)) (i32.const 0))
+(assert_return (invoke "call" (i32.const 2)) (i32.const 0))
+(assert_return (invoke "call" (i32.const 3)) (i32.const 1))
+(assert_trap (invoke "call" (i32.const 4)) "uninitialized element")
+(assert_return (invoke "copy" (i32.const 1) (i32.const 3) (i32.const 3)))
+(assert_return (invoke "call" (i32.const 1)) (i32.const 1))
+(assert_trap (invoke "call" (i32.const 2)) "uninitialized element")
+(assert_return (invoke "call" (i32.const 3)) (i32.const 3))
+(assert_trap (invoke "copy" (i32.const 6) (i32.const 0) (i32.const 3)) "out of bounds table access")
+(assert_trap (invoke "copy" (i32.const 0) (i32.const 6) (i32.const 3)) "out of bounds table access")
+(assert_return (invoke "copy" (i32.const 8) (i32.const 8) (i32.const 0)))
+(assert_trap (invoke "copy" (i32.const 9) (i32.const 8) (i32.const 0)) "out of bounds table access")
+(assert_return (invoke "copy_to_u" (i32.const 0) (i32.const 1) (i32.const 4)))
+(assert_return (invoke "call_u" (i32.const 0)) (i32.const 1))
+(assert_return (invoke "call_u" (i32.const 2)) (i32.const 3))
+(assert_trap (invoke "call_u" (i32.const 3)) "uninitialized element")
+
+;; table.fill
+(assert_return (invoke "fill" (i32.const 0) (i32.const 8)))
+(assert_return (invoke "call" (i32.const 0)) (i32.const 3))
+(assert_return (invoke "call" (i32.const 7)) (i32.const 3))
+(assert_return (invoke "fill_null" (i32.const 6) (i32.const 2)))
+(assert_trap (invoke "call" (i32.const 6)) "uninitialized element")
+(assert_return (invoke "call" (i32.const 5)) (i32.const 3))
+(assert_trap (invoke "fill_null" (i32.const 7) (i32.const 2)) "out of bounds table access")
+(assert_return (invoke "call" (i32.const 5)) (i32.const 3))
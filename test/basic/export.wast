@@ -0,0 +1,61 @@
+(module
+  (func $id (param i32) (result i32) (local.get 0))
+  (export "" (func $id))
+  (export "id" (func $id))
+  (export "\e2\82\ac" (func $id))
+  (export "a_rather_long_export_name_which_does_not_fit_into_small_strings" (func $id))
+  (func (export "f0") (result i32) (i32.const 0))
+  (func (export "f1") (result i32) (i32.const 10))
+  (func (export "f2") (result i32) (i32.const 20))
+  (func (export "f3") (result i32) (i32.const 30))
+  (func (export "f4") (result i32) (i32.const 40))
+  (func (export "f5") (result i32) (i32.const 50))
+  (func (export "f6") (result i32) (i32.const 60))
+  (func (export "f7") (result i32) (i32.const 70))
+  (func (export "f8") (result i32) (i32.const 80))
+  (func (export "f9") (result i32) (i32.const 90))
+  (func (export "f10") (result i32) (i32.const 100))
+  (func (export "f11") (result i32) (i32.const 110))
+  (func (export "f12") (result i32) (i32.const 120))
+  (func (export "f13") (result i32) (i32.const 130))
+  (func (export "f14") (result i32) (i32.const 140))
+  (func (export "f15") (result i32) (i32.const 150))
+  (func (export "f16") (result i32) (i32.const 160))
+  (func (export "f17") (result i32) (i32.const 170))
+  (func (export "f18") (result i32) (i32.const 180))
+  (func (export "f19") (result i32) (i32.const 190))
+)
+
+(assert_return (invoke "" (i32.const 7)) (i32.const 7))
+(assert_return (invoke "id" (i32.const 7)) (i32.const 7))
+(assert_return (invoke "\e2\82\ac" (i32.const 7)) (i32.const 7))
+(assert_return (invoke "a_rather_long_export_name_which_does_not_fit_into_small_strings" (i32.const 7)) (i32.const 7))
+(assert_return (invoke "f0") (i32.const 0))
+(assert_return (invoke "f1") (i32.const 10))
+(assert_return (invoke "f2") (i32.const 20))
+(assert_return (invoke "f3") (i32.const 30))
+(assert_return (invoke "f4") (i32.const 40))
+(assert_return (invoke "f5") (i32.const 50))
+(assert_return (invoke "f6") (i32.const 60))
+(assert_return (invoke "f7") (i32.const 70))
+(assert_return (invoke "f8") (i32.const 80))
+(assert_return (invoke "f9") (i32.const 90))
+(assert_return (invoke "f10") (i32.const 100))
+(assert_return (invoke "f11") (i32.const 110))
+(assert_return (invoke "f12") (i32.const 120))
+(assert_return (invoke "f13") (i32.const 130))
+(assert_return (invoke "f14") (i32.const 140))
+(assert_return (invoke "f15") (i32.const 150))
+(assert_return (invoke "f16") (i32.const 160))
+(assert_return (invoke "f17") (i32.const 170))
+(assert_return (invoke "f18") (i32.const 180))
+(assert_return (invoke "f19") (i32.const 190))
+
+;; names are shared between modules of the store
+(module
+  (func (export "id") (param i32) (result i32) (i32.add (local.get 0) (i32.const 1)))
+  (func (export "f0") (result i32) (i32.const -1))
+)
+
+(assert_return (invoke "id" (i32.const 7)) (i32.const 8))
+(assert_return (invoke "f0") (i32.const -1))
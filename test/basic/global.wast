@@ -0,0 +1,33 @@
+(module
+  (global $a i32 (i32.const 40))
+  (global $b i64 (i64.const -3))
+  (global $c i32 (i32.add (global.get $a) (i32.const 2)))
+  (global $d i64 (i64.mul (i64.sub (global.get $b) (i64.const 1)) (i64.const 0x100000000)))
+  (global $e i32 (i32.sub (i32.const 0) (i32.mul (i32.const 0x10000) (i32.const 0x10000))))
+  (global $f f32 (f32.const -0.5))
+  (global $g (mut f64) (f64.const 1.25))
+
+  (type $ret (func (result i32)))
+  (table 8 funcref)
+  (func $f0 (result i32) (i32.const 10))
+  (func $f1 (result i32) (i32.const 11))
+  (elem (offset (i32.sub (i32.mul (i32.const 3) (i32.const 2)) (i32.const 1))) func $f0 $f1)
+
+  (func (export "c") (result i32) (global.get $c))
+  (func (export "d") (result i64) (global.get $d))
+  (func (export "e") (result i32) (global.get $e))
+  (func (export "f") (result f32) (global.get $f))
+  (func (export "g") (result f64) (global.get $g))
+  (func (export "call") (param i32) (result i32)
+    (call_indirect (type $ret) (local.get 0))
+  )
+)
+
+(assert_return (invoke "c") (i32.const 42))
+(assert_return (invoke "d") (i64.const -0x400000000))
+(assert_return (invoke "e") (i32.const 0))
+(assert_return (invoke "f") (f32.const -0.5))
+(assert_return (invoke "g") (f64.const 1.25))
+(assert_return (invoke "call" (i32.const 5)) (i32.const 10))
+(assert_return (invoke "call" (i32.const 6)) (i32.const 11))
+(assert_trap (invoke "call" (i32.const 4)) "uninitialized element")
@@ -0,0 +1,32 @@
+(module
+  (import "spectest" "print_i32" (func $print_i32 (param i32)))
+  (import "spectest" "print_i64" (func $print_i64 (param i64)))
+  (import "spectest" "print_f32" (func $print_f32 (param f32)))
+  (import "spectest" "print_f64" (func $print_f64 (param f64)))
+  (import "spectest" "print_i32_f32" (func $print_i32_f32 (param i32 f32)))
+  (table 1 funcref)
+  (elem (i32.const 0) $print_i32)
+
+  ;; the operand stack below the arguments must be kept
+  (func (export "call_between") (param i32) (result i32)
+    (i32.add
+      (local.get 0)
+      (block (result i32)
+        (call $print_i32 (i32.const 1))
+        (call $print_i64 (i64.const 2))
+        (call $print_f32 (f32.const 3.5))
+        (call $print_f64 (f64.const 4.5))
+        (call $print_i32_f32 (i32.const 5) (f32.const 6.5))
+        (i32.const 100)
+      )
+    )
+  )
+
+  (func (export "call_indirect") (param i32) (result i32)
+    (call_indirect (param i32) (i32.const 7) (i32.const 0))
+    (local.get 0)
+  )
+)
+
+(assert_return (invoke "call_between" (i32.const 23)) (i32.const 123))
+(assert_return (invoke "call_indirect" (i32.const 42)) (i32.const 42))
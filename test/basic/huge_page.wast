@@ -0,0 +1,84 @@
+;; flags: --use-huge-page
+;; buffers of 2MiB or more are mapped with 2MiB alignment, and grow copies them into a new mapping
+(module
+  (memory 32 100)
+
+  (func (export "grow") (param i32) (result i32)
+    (memory.grow (local.get 0))
+  )
+
+  (func (export "size") (result i32)
+    (memory.size)
+  )
+
+  (func (export "store") (param i32 i64)
+    (i64.store (local.get 0) (local.get 1))
+  )
+
+  (func (export "load") (param i32) (result i64)
+    (i64.load (local.get 0))
+  )
+
+  (func (export "load8") (param i32) (result i32)
+    (i32.load8_u (local.get 0))
+  )
+)
+
+(assert_return (invoke "size") (i32.const 32))
+(assert_return (invoke "store" (i32.const 0) (i64.const 0x1111111111111111)))
+(assert_return (invoke "store" (i32.const 0x100000) (i64.const 0x2222222222222222)))
+(assert_return (invoke "store" (i32.const 0x1ffff8) (i64.const 0x3333333333333333)))
+(assert_trap (invoke "store" (i32.const 0x1ffffc) (i64.const 0)) "out of bounds memory access")
+(assert_trap (invoke "load" (i32.const 0x200000)) "out of bounds memory access")
+
+;; 33 pages are not a multiple of 2MiB
+(assert_return (invoke "grow" (i32.const 1)) (i32.const 32))
+(assert_return (invoke "size") (i32.const 33))
+(assert_return (invoke "load" (i32.const 0)) (i64.const 0x1111111111111111))
+(assert_return (invoke "load" (i32.const 0x100000)) (i64.const 0x2222222222222222))
+(assert_return (invoke "load" (i32.const 0x1ffff8)) (i64.const 0x3333333333333333))
+(assert_return (invoke "load" (i32.const 0x200000)) (i64.const 0))
+(assert_return (invoke "load" (i32.const 0x20fff8)) (i64.const 0))
+
+;; an access across the old end of the memory
+(assert_return (invoke "store" (i32.const 0x1ffffc) (i64.const 0x4444444455555555)))
+(assert_return (invoke "load" (i32.const 0x1ffff8)) (i64.const 0x5555555533333333))
+(assert_return (invoke "load" (i32.const 0x200000)) (i64.const 0x44444444))
+(assert_return (invoke "store" (i32.const 0x20fff8) (i64.const 0x6666666666666666)))
+(assert_trap (invoke "load" (i32.const 0x20fffc)) "out of bounds memory access")
+
+;; the copied buffer is freed, and grown again to 4MiB
+(assert_return (invoke "grow" (i32.const 31)) (i32.const 33))
+(assert_return (invoke "size") (i32.const 64))
+(assert_return (invoke "load" (i32.const 0)) (i64.const 0x1111111111111111))
+(assert_return (invoke "load" (i32.const 0x200000)) (i64.const 0x44444444))
+(assert_return (invoke "load" (i32.const 0x20fff8)) (i64.const 0x6666666666666666))
+(assert_return (invoke "load8" (i32.const 0x3fffff)) (i32.const 0))
+(assert_return (invoke "store" (i32.const 0x3ffff8) (i64.const -1)))
+(assert_return (invoke "load8" (i32.const 0x3fffff)) (i32.const 0xff))
+(assert_return (invoke "grow" (i32.const 37)) (i32.const -1))
+(assert_return (invoke "size") (i32.const 64))
+
+;; a memory below 2MiB is allocated as usual, then mapped once it grows to 2MiB
+(module
+  (memory 16)
+
+  (func (export "grow") (param i32) (result i32)
+    (memory.grow (local.get 0))
+  )
+
+  (func (export "store") (param i32 i64)
+    (i64.store (local.get 0) (local.get 1))
+  )
+
+  (func (export "load") (param i32) (result i64)
+    (i64.load (local.get 0))
+  )
+)
+
+(assert_return (invoke "store" (i32.const 0xffff8) (i64.const 0x7777777777777777)))
+(assert_return (invoke "grow" (i32.const 32)) (i32.const 16))
+(assert_return (invoke "load" (i32.const 0xffff8)) (i64.const 0x7777777777777777))
+(assert_return (invoke "store" (i32.const 0x2ffff8) (i64.const 0x0888888888888888)))
+(assert_return (invoke "load" (i32.const 0x2ffff8)) (i64.const 0x0888888888888888))
+(assert_return (invoke "load" (i32.const 0x100000)) (i64.const 0))
@@ -0,0 +1,98 @@
+;; flags: --instance-pool
+(module
+  (memory 1 4)
+  (table $t 2 funcref)
+  (global $count (mut i32) (i32.const 7))
+  (global $wide (mut i64) (i64.const -1))
+
+  (elem $e func $forty_two)
+  (elem (table $t) (i32.const 0) func $one)
+
+  (func $one (result i32) (i32.const 1))
+  (func $forty_two (result i32) (i32.const 42))
+
+  ;; the snapshot holds the memory written by the start function
+  (func $init
+    (i32.store (i32.const 100) (i32.const 0x1234))
+  )
+  (start $init)
+
+  ;; the grown pages are freed by the reset
+  (func (export "grow_memory") (result i32)
+    (local $old i32)
+    (local.set $old (memory.grow (i32.const 2)))
+    (i32.store (i32.const 0x2fffc) (i32.const 5))
+    (i32.store (i32.const 100) (i32.const 9))
+    (i32.store (i32.const 200) (i32.const 9))
+    (local.get $old)
+  )
+
+  (func (export "memory_size") (result i32)
+    (memory.size)
+  )
+
+  (func (export "load") (param i32) (result i32)
+    (i32.load (local.get 0))
+  )
+
+  (func (export "grow_table") (result i32)
+    (table.grow $t (ref.null func) (i32.const 3))
+  )
+
+  (func (export "table_size") (result i32)
+    (table.size $t)
+  )
+
+  ;; traps unless the dropped segment is assigned again
+  (func (export "init_table") (result i32)
+    (table.init $t $e (i32.const 1) (i32.const 0) (i32.const 1))
+    (elem.drop $e)
+    (call_indirect $t (result i32) (i32.const 1))
+  )
+
+  (func (export "call") (param i32) (result i32)
+    (call_indirect $t (result i32) (local.get 0))
+  )
+
+  (func (export "bump") (result i32)
+    (global.set $count (i32.add (global.get $count) (i32.const 1)))
+    (global.set $wide (i64.add (global.get $wide) (i64.const 1)))
+    (global.get $count)
+  )
+
+  ;; the global is set before the trap
+  (func (export "bump_then_trap") (param i32) (result i32)
+    (global.set $count (i32.const 100))
+    (i32.div_u (i32.const 1) (local.get 0))
+  )
+
+  (func (export "count") (result i32)
+    (global.get $count)
+  )
+
+  (func (export "wide") (result i64)
+    (global.get $wide)
+  )
+)
+
+(assert_return (invoke "grow_memory") (i32.const 1))
+(assert_return (invoke "grow_memory") (i32.const 1))
+(assert_return (invoke "memory_size") (i32.const 1))
+(assert_return (invoke "load" (i32.const 100)) (i32.const 0x1234))
+(assert_return (invoke "load" (i32.const 200)) (i32.const 0))
+(assert_trap (invoke "load" (i32.const 0x2fffc)) "out of bounds memory access")
+
+(assert_return (invoke "grow_table") (i32.const 2))
+(assert_return (invoke "grow_table") (i32.const 2))
+(assert_return (invoke "table_size") (i32.const 2))
+
+(assert_return (invoke "init_table") (i32.const 42))
+(assert_return (invoke "init_table") (i32.const 42))
+(assert_return (invoke "call" (i32.const 0)) (i32.const 1))
+(assert_trap (invoke "call" (i32.const 1)) "uninitialized element")
+
+(assert_return (invoke "bump") (i32.const 8))
+(assert_return (invoke "bump") (i32.const 8))
+(assert_return (invoke "wide") (i64.const -1))
+(assert_trap (invoke "bump_then_trap" (i32.const 0)) "integer divide by zero")
+(assert_return (invoke "count") (i32.const 7))
@@ -0,0 +1,50 @@
+;; flags: --lazy-compilation
+(module
+  (type $i32_to_i32 (func (param i32) (result i32)))
+  (table 2 funcref)
+  (elem (i32.const 0) $double $square)
+  (global $started (mut i32) (i32.const 0))
+
+  ;; compiled when the start function calls it
+  (func $mark (param i32)
+    (global.set $started (local.get 0))
+  )
+  (func $start
+    (call $mark (i32.const 42))
+  )
+  (start $start)
+
+  ;; compiled by a direct call
+  (func $add (param i32 i32) (result i32)
+    (i32.add (local.get 0) (local.get 1))
+  )
+  ;; compiled by call_indirect
+  (func $double (param i32) (result i32)
+    (i32.shl (local.get 0) (i32.const 1))
+  )
+  (func $square (param i32) (result i32)
+    (i32.mul (local.get 0) (local.get 0))
+  )
+
+  (func (export "started") (result i32)
+    (global.get $started)
+  )
+  (func (export "add") (param i32 i32) (result i32)
+    (call $add (local.get 0) (local.get 1))
+  )
+  (func (export "apply") (param i32 i32) (result i32)
+    (call_indirect (type $i32_to_i32) (local.get 1) (local.get 0))
+  )
+  (func (export "div") (param i32 i32) (result i32)
+    (i32.div_s (local.get 0) (local.get 1))
+  )
+)
+
+(assert_return (invoke "started") (i32.const 42))
+(assert_return (invoke "add" (i32.const 1) (i32.const 2)) (i32.const 3))
+(assert_return (invoke "add" (i32.const -1) (i32.const 1)) (i32.const 0))
+(assert_return (invoke "apply" (i32.const 0) (i32.const 5)) (i32.const 10))
+(assert_return (invoke "apply" (i32.const 1) (i32.const 5)) (i32.const 25))
+(assert_trap (invoke "apply" (i32.const 2) (i32.const 5)) "undefined element")
+(assert_trap (invoke "div" (i32.const 1) (i32.const 0)) "integer divide by zero")
+(assert_return (invoke "div" (i32.const 9) (i32.const 3)) (i32.const 3))
@@ -0,0 +1,22 @@
+;; flags: --lazy-compilation --trusted-module
+;; the bodies of trusted modules are not checked before they are compiled
+(module
+  (memory i64 1)
+
+  ;; atomics are only supported on memory32, so this body fails to compile
+  (func (export "atomic_load") (result i32)
+    (i32.atomic.load (i64.const 0))
+  )
+  (func (export "load") (result i32)
+    (i32.load (i64.const 0))
+  )
+  (func (export "call_atomic_load") (result i32)
+    (call 0)
+  )
+)
+
+(assert_return (invoke "load") (i32.const 0))
+(assert_trap (invoke "atomic_load") "invalid function body")
+(assert_trap (invoke "atomic_load") "invalid function body")
+(assert_trap (invoke "call_atomic_load") "invalid function body")
+(assert_return (invoke "load") (i32.const 0))
@@ -0,0 +1,133 @@
+(module
+  (memory 1)
+  (func (export "store_load_i32")(param i32 i32)(result i32)
+    local.get 0
+    local.get 1
+    i32.store
+    local.get 0
+    i32.load
+  )
+  (func (export "store_load_i64")(param i32 i64)(result i64)
+    local.get 0
+    local.get 1
+    i64.store offset=8
+    local.get 0
+    i64.load offset=8
+  )
+  (func (export "store8_load8")(param i32)(result i32 i32)
+    i32.const 0
+    local.get 0
+    i32.store8
+    i32.const 0
+    i32.load8_s
+    i32.const 0
+    i32.load8_u
+  )
+  (func (export "load16_i64")(param i32)(result i64 i64)
+    i32.const 16
+    local.get 0
+    i32.store16
+    i32.const 16
+    i64.load16_s
+    i32.const 16
+    i64.load16_u
+  )
+  (func (export "store_load_f64")(param f64)(result f64)
+    i32.const 32
+    local.get 0
+    f64.store
+    i32.const 32
+    f64.load
+  )
+  (func (export "load_i32")(param i32)(result i32)
+    local.get 0
+    i32.load offset=4
+  )
+)
+
+(assert_return (invoke "store_load_i32" (i32.const 0) (i32.const 42)) (i32.const 42))
+(assert_return (invoke "store_load_i32" (i32.const 65532) (i32.const -1)) (i32.const -1))
+(assert_return (invoke "store_load_i64" (i32.const 100) (i64.const 0x123456789abcdef0)) (i64.const 0x123456789abcdef0))
+(assert_return (invoke "store8_load8" (i32.const 0xff)) (i32.const -1) (i32.const 255))
+(assert_return (invoke "load16_i64" (i32.const 0x8000)) (i64.const -32768) (i64.const 32768))
+(assert_return (invoke "store_load_f64" (f64.const 1.5)) (f64.const 1.5))
+(assert_return (invoke "load_i32" (i32.const 65528)) (i32.const -1))
+(assert_trap (invoke "load_i32" (i32.const 65529)) "out of bounds memory access")
+(assert_trap (invoke "load_i32" (i32.const -1)) "out of bounds memory access")
+(assert_trap (invoke "store_load_i32" (i32.const 65533) (i32.const 0)) "out of bounds memory access")
+
+(module
+  (memory 1)
+  (func (export "sum")(param i32)(result i32)
+    local.get 0
+    i32.load offset=12
+    local.get 0
+    i32.load offset=4
+    i32.add
+    local.get 0
+    i32.load8_u offset=15
+    i32.add
+    local.get 0
+    i32.const 7
+    i32.store offset=8
+    local.get 0
+    i32.const 65536
+    local.set 0
+    i32.load offset=8
+    i32.add
+  )
+  (func (export "reset")(param i32)(result i32)
+    local.get 0
+    i32.load offset=8
+    drop
+    i32.const 65535
+    local.set 0
+    local.get 0
+    i32.load offset=4
+  )
+)
+(assert_return (invoke "sum" (i32.const 0)) (i32.const 7))
+(assert_trap (invoke "sum" (i32.const 65524)) "out of bounds memory access")
+(assert_return (invoke "sum" (i32.const 65520)) (i32.const 7))
+(assert_trap (invoke "reset" (i32.const 0)) "out of bounds memory access")
+
+(module
+  (memory 1)
+  (func (export "store_locals")(param i32 i64 f32 f64)(result i64 f32 f64 i32)
+    local.get 0
+    local.get 1
+    i64.store offset=8
+    local.get 0
+    local.get 2
+    f32.store offset=16
+    local.get 0
+    local.get 3
+    f64.store offset=24
+    local.get 0
+    local.get 1
+    i64.store8 offset=32
+    local.get 0
+    i64.load offset=8
+    local.get 0
+    f32.load offset=16
+    local.get 0
+    f64.load offset=24
+    local.get 0
+    i32.load8_s offset=32
+  )
+  (func (export "block_result")(param i32 i32)(result i32)
+    (block (result i32)
+      local.get 0
+      local.get 1
+      br_if 0
+      drop
+      local.get 1)
+    i32.load offset=8
+  )
+)
+
+(assert_return (invoke "store_locals" (i32.const 0) (i64.const -2) (f32.const 1.5) (f64.const -2.5))
+  (i64.const -2) (f32.const 1.5) (f64.const -2.5) (i32.const -2))
+(assert_return (invoke "block_result" (i32.const 16) (i32.const 8)) (i32.const 0))
+(assert_return (invoke "block_result" (i32.const 16) (i32.const 0)) (i32.const -2))
+(assert_trap (invoke "store_locals" (i32.const 65528) (i64.const 0) (f32.const 0) (f64.const 0)) "out of bounds memory access")
@@ -0,0 +1,35 @@
+(module
+  (memory i64 1 3)
+  (func (export "size")(result i64)
+    memory.size
+  )
+  (func (export "grow")(param i64)(result i64)
+    local.get 0
+    memory.grow
+  )
+  (func (export "store_load")(param i64 i64)(result i64)
+    local.get 0
+    local.get 1
+    i64.store
+    local.get 0
+    i64.load
+  )
+  (func (export "load8_u")(param i64)(result i32)
+    local.get 0
+    i32.load8_u offset=1
+  )
+)
+
+(assert_return (invoke "size") (i64.const 1))
+(assert_return (invoke "store_load" (i64.const 65528) (i64.const 7)) (i64.const 7))
+(assert_trap (invoke "store_load" (i64.const 65529) (i64.const 7)) "out of bounds memory access")
+(assert_trap (invoke "load8_u" (i64.const 65535)) "out of bounds memory access")
+(assert_trap (invoke "load8_u" (i64.const 0x100000000)) "out of bounds memory access")
+(assert_trap (invoke "load8_u" (i64.const -1)) "out of bounds memory access")
+(assert_return (invoke "grow" (i64.const 1)) (i64.const 1))
+(assert_return (invoke "load8_u" (i64.const 65535)) (i32.const 0))
+(assert_return (invoke "size") (i64.const 2))
+(assert_return (invoke "grow" (i64.const 2)) (i64.const -1))
+(assert_return (invoke "grow" (i64.const 0x1000000000000)) (i64.const -1))
+(assert_return (invoke "grow" (i64.const 1)) (i64.const 2))
+(assert_return (invoke "size") (i64.const 3))
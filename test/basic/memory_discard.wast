@@ -0,0 +1,69 @@
+;; Memory::discard and Memory::statistics through the host functions of the shell
+(module
+  (import "walrus" "memory_discard" (func $discard (param i64 i64) (result i32)))
+  (import "walrus" "memory_resident_size" (func $resident (result i64)))
+  (import "walrus" "memory_committed_size" (func $committed (result i64)))
+  (memory 4)
+
+  ;; writes a byte into every 4KiB, so every OS page of the range is resident
+  (func $fill (param $offset i32) (param $end i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.ge_u (local.get $offset) (local.get $end)))
+        (i32.store8 (local.get $offset) (i32.const 0x55))
+        (local.set $offset (i32.add (local.get $offset) (i32.const 4096)))
+        (br $next)
+      )
+    )
+  )
+
+  (func (export "fill") (param i32 i32)
+    (call $fill (local.get 0) (local.get 1))
+  )
+  (func (export "load") (param i32) (result i32)
+    (i32.load8_u (local.get 0))
+  )
+  (func (export "discard") (param i64 i64) (result i32)
+    (call $discard (local.get 0) (local.get 1))
+  )
+  (func (export "committed") (result i64)
+    (call $committed)
+  )
+
+  ;; the resident size drops by the discarded pages, except the OS pages
+  ;; at both ends which are only partially covered by the buffer
+  (func (export "resident_drop") (result i32)
+    (local $before i64)
+    (call $fill (i32.const 0) (i32.const 0x40000))
+    (local.set $before (call $resident))
+    (drop (call $discard (i64.const 0x10000) (i64.const 0x20000)))
+    (i64.ge_u (i64.sub (local.get $before) (call $resident)) (i64.const 0x1e000))
+  )
+)
+
+(assert_return (invoke "committed") (i64.const 0x40000))
+
+(assert_return (invoke "fill" (i32.const 0) (i32.const 0x40000)))
+(assert_return (invoke "load" (i32.const 0x10000)) (i32.const 0x55))
+(assert_return (invoke "discard" (i64.const 0x10000) (i64.const 0x10000)) (i32.const 1))
+(assert_return (invoke "load" (i32.const 0x10000)) (i32.const 0))
+(assert_return (invoke "load" (i32.const 0x1f000)) (i32.const 0))
+(assert_return (invoke "load" (i32.const 0xf000)) (i32.const 0x55))
+(assert_return (invoke "load" (i32.const 0x20000)) (i32.const 0x55))
+(assert_return (invoke "discard" (i64.const 0) (i64.const 0x40000)) (i32.const 1))
+(assert_return (invoke "load" (i32.const 0)) (i32.const 0))
+(assert_return (invoke "load" (i32.const 0x3f000)) (i32.const 0))
+(assert_return (invoke "discard" (i64.const 0x40000) (i64.const 0)) (i32.const 1))
+
+;; unaligned and out of bounds ranges are rejected, and the memory is untouched
+(assert_return (invoke "fill" (i32.const 0) (i32.const 0x40000)))
+(assert_return (invoke "discard" (i64.const 100) (i64.const 0x10000)) (i32.const 0))
+(assert_return (invoke "discard" (i64.const 0) (i64.const 100)) (i32.const 0))
+(assert_return (invoke "discard" (i64.const 0x30000) (i64.const 0x20000)) (i32.const 0))
+(assert_return (invoke "discard" (i64.const 0x50000) (i64.const 0)) (i32.const 0))
+(assert_return (invoke "discard" (i64.const -0x10000) (i64.const 0x20000)) (i32.const 0))
+(assert_return (invoke "load" (i32.const 0)) (i32.const 0x55))
+(assert_return (invoke "load" (i32.const 0x30000)) (i32.const 0x55))
+
+(assert_return (invoke "resident_drop") (i32.const 1))
+(assert_return (invoke "committed") (i64.const 0x40000))
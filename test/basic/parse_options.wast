@@ -0,0 +1,45 @@
+;; flags: --disable-feature=sign-extension
+;; the other features are still accepted
+(module
+  (func (export "trunc_sat") (param f32) (result i32)
+    (i32.trunc_sat_f32_s (local.get 0))
+  )
+)
+
+(assert_return (invoke "trunc_sat" (f32.const 1e10)) (i32.const 2147483647))
+
+;; (func (export "f") (result i32) (i32.extend8_s (i32.const 255)))
+(assert_invalid
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\08\01\06\00\41\ff\01\c0\0b"
+  )
+  "unexpected opcode"
+)
+
+;; the second export name is not valid utf-8
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\09\02\01\66\00\00\01\ff\00\00"
+    "\0a\06\01\04\00\41\2a\0b"
+  )
+  "invalid utf-8 encoding"
+)
+
+;; custom sections are skipped, so the linking section with an unknown version is not read
+(module binary
+  "\00asm" "\01\00\00\00"
+  "\01\05\01\60\00\01\7f"
+  "\03\02\01\00"
+  "\07\05\01\01\66\00\00"
+  "\0a\06\01\04\00\41\2a\0b"
+  "\00\09\07linking\01"
+)
+
+(assert_return (invoke "f") (i32.const 42))
@@ -0,0 +1,26 @@
+;; flags: --read-custom-sections
+;; the linking section has an unknown version
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\06\01\04\00\41\2a\0b"
+    "\00\09\07linking\01"
+  )
+  "invalid linking metadata version"
+)
+
+;; a valid linking section and an unknown custom section
+(module binary
+  "\00asm" "\01\00\00\00"
+  "\01\05\01\60\00\01\7f"
+  "\03\02\01\00"
+  "\07\05\01\01\66\00\00"
+  "\0a\06\01\04\00\41\2a\0b"
+  "\00\09\07linking\02"
+  "\00\04\03abc"
+)
+
+(assert_return (invoke "f") (i32.const 42))
@@ -0,0 +1,32 @@
+;; flags: --name-section=lazy
+(module
+  (import "walrus" "has_unread_name_section" (func $has_unread_name_section (result i32)))
+  (import "walrus" "function_name_length" (func $function_name_length (param i32) (result i32)))
+  (import "walrus" "function_name_byte" (func $function_name_byte (param i32 i32) (result i32)))
+
+  ;; function 3
+  (func $ab)
+
+  (func (export "unread") (result i32)
+    (call $has_unread_name_section)
+  )
+
+  (func (export "name_length") (param i32) (result i32)
+    (call $function_name_length (local.get 0))
+  )
+
+  (func (export "name_byte") (param i32 i32) (result i32)
+    (call $function_name_byte (local.get 0) (local.get 1))
+  )
+)
+
+;; the name section is kept until the first name is requested
+(assert_return (invoke "unread") (i32.const 1))
+(assert_return (invoke "name_length" (i32.const 3)) (i32.const 2))
+(assert_return (invoke "unread") (i32.const 0))
+(assert_return (invoke "name_byte" (i32.const 3) (i32.const 0)) (i32.const 0x61))
+(assert_return (invoke "name_byte" (i32.const 3) (i32.const 1)) (i32.const 0x62))
+(assert_return (invoke "name_length" (i32.const 0)) (i32.const 23))
+;; the exported functions have no name
+(assert_return (invoke "name_length" (i32.const 4)) (i32.const -1))
+(assert_return (invoke "name_length" (i32.const 100)) (i32.const -1))
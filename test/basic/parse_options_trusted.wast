@@ -0,0 +1,12 @@
+;; flags: --trusted-module --disable-feature=sign-extension
+;; a trusted module is not checked against the feature mask
+;; (func (export "f") (result i32) (i32.extend8_s (i32.const 255)))
+(module binary
+  "\00asm" "\01\00\00\00"
+  "\01\05\01\60\00\01\7f"
+  "\03\02\01\00"
+  "\07\05\01\01\66\00\00"
+  "\0a\08\01\06\00\41\ff\01\c0\0b"
+)
+
+(assert_return (invoke "f") (i32.const -1))
@@ -0,0 +1,90 @@
+;; flags: --shared-module-cache=1024 --lazy-compilation
+;; identical modules are parsed once, and every instance of them has its own state
+(module
+  (global $count (mut i32) (i32.const 0))
+  (func (export "next") (result i32)
+    (global.set $count (i32.add (global.get $count) (i32.const 1)))
+    (global.get $count)
+  )
+)
+
+(assert_return (invoke "next") (i32.const 1))
+(assert_return (invoke "next") (i32.const 2))
+
+;; a hit of the module above
+(module
+  (global $count (mut i32) (i32.const 0))
+  (func (export "next") (result i32)
+    (global.set $count (i32.add (global.get $count) (i32.const 1)))
+    (global.get $count)
+  )
+)
+
+(assert_return (invoke "next") (i32.const 1))
+
+;; modules which do not fit together, so the older ones are evicted
+(module
+  (memory 1)
+  (func $fill (param $value i32) (param $count i32)
+    (local $i i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.ge_u (local.get $i) (local.get $count)))
+        (i32.store (i32.shl (local.get $i) (i32.const 2)) (i32.add (local.get $value) (local.get $i)))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $next)
+      )
+    )
+  )
+  (func $sum (param $count i32) (result i32)
+    (local $i i32)
+    (local $acc i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.ge_u (local.get $i) (local.get $count)))
+        (local.set $acc (i32.add (local.get $acc) (i32.load (i32.shl (local.get $i) (i32.const 2)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $next)
+      )
+    )
+    (local.get $acc)
+  )
+  (func (export "fill_and_sum") (param i32 i32) (result i32)
+    (call $fill (local.get 0) (local.get 1))
+    (call $sum (local.get 1))
+  )
+)
+
+(assert_return (invoke "fill_and_sum" (i32.const 0) (i32.const 100)) (i32.const 4950))
+(assert_return (invoke "fill_and_sum" (i32.const 1) (i32.const 100)) (i32.const 5050))
+
+(module
+  (func $fib (param i32) (result i32)
+    (if (result i32) (i32.lt_u (local.get 0) (i32.const 2))
+      (then (local.get 0))
+      (else
+        (i32.add
+          (call $fib (i32.sub (local.get 0) (i32.const 1)))
+          (call $fib (i32.sub (local.get 0) (i32.const 2)))
+        )
+      )
+    )
+  )
+  (func (export "fib") (param i32) (result i32)
+    (call $fib (local.get 0))
+  )
+)
+
+(assert_return (invoke "fib" (i32.const 20)) (i32.const 6765))
+
+;; parsed again if it was evicted
+(module
+  (global $count (mut i32) (i32.const 0))
+  (func (export "next") (result i32)
+    (global.set $count (i32.add (global.get $count) (i32.const 1)))
+    (global.get $count)
+  )
+)
+
+(assert_return (invoke "next") (i32.const 1))
+(assert_return (invoke "next") (i32.const 2))
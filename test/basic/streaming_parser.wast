@@ -0,0 +1,108 @@
+;; flags: --stream-chunk-size=3
+;; every module is given to WASMStreamingParser three bytes at a time, so the bodies are split across chunks
+(module
+  (type $ret_i32 (func (result i32)))
+  (table 2 funcref)
+  (elem (i32.const 0) $seven $add_seven)
+
+  (func $seven (result i32)
+    (i32.const 7)
+  )
+
+  (func $add_seven (result i32)
+    (i32.add (call $seven) (i32.const 7))
+  )
+
+  (func (export "sum") (param $n i32) (result i32)
+    (local $sum i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.eqz (local.get $n)))
+        (local.set $sum (i32.add (local.get $sum) (local.get $n)))
+        (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+        (br $next)
+      )
+    )
+    (local.get $sum)
+  )
+
+  (func (export "call") (param i32) (result i32)
+    (call_indirect (type $ret_i32) (local.get 0))
+  )
+)
+
+(assert_return (invoke "sum" (i32.const 100)) (i32.const 5050))
+(assert_return (invoke "call" (i32.const 0)) (i32.const 7))
+(assert_return (invoke "call" (i32.const 1)) (i32.const 14))
+
+;; a module without code section is parsed by finish()
+(module
+  (type (func))
+  (memory 1)
+)
+
+;; (func (export "f") (result i32) (i32.const 42))
+(module binary
+  "\00asm" "\01\00\00\00"
+  "\01\05\01\60\00\01\7f"
+  "\03\02\01\00"
+  "\07\05\01\01\66\00\00"
+  "\0a\06\01\04\00\41\2a\0b"
+)
+
+(assert_return (invoke "f") (i32.const 42))
+
+;; the same binary truncated in the module header
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00"
+  )
+  "unexpected end"
+)
+
+;; truncated before the code section
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01"
+  )
+  "unexpected end"
+)
+
+;; truncated before the function body count
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\06"
+  )
+  "unexpected end"
+)
+
+;; truncated in the function body
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\06\01\04\00\41"
+  )
+  "unexpected end"
+)
+
+;; the function body is larger than the code section
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\06\01\09\00\41\2a\0b"
+  )
+  "section size mismatch"
+)
@@ -0,0 +1,34 @@
+;; flags: --stream-chunk-size=3 --name-section=read
+;; the name section follows the code section, so the whole binary is parsed again by finish()
+(module
+  (type $ret_i32 (func (result i32)))
+  (table 1 funcref)
+  (elem (i32.const 0) $seven)
+
+  (func $seven (result i32)
+    (i32.const 7)
+  )
+
+  (func $twice (param $value i32) (result i32)
+    (i32.add (local.get $value) (local.get $value))
+  )
+
+  (func (export "call") (result i32)
+    (call $twice (call_indirect (type $ret_i32) (i32.const 0)))
+  )
+)
+
+(assert_return (invoke "call") (i32.const 14))
+
+;; truncated in the name section
+(assert_malformed
+  (module binary
+    "\00asm" "\01\00\00\00"
+    "\01\05\01\60\00\01\7f"
+    "\03\02\01\00"
+    "\07\05\01\01\66\00\00"
+    "\0a\06\01\04\00\41\2a\0b"
+    "\00\0b\04name\01\04\01\00\01"
+  )
+  "unexpected end"
+)
@@ -0,0 +1,50 @@
+(module
+  (table $t 1 1000 funcref)
+
+  (func $f (export "f") (result i32)
+    (i32.const 42)
+  )
+
+  (func (export "size") (result i32)
+    (table.size $t)
+  )
+  ;; grows the table by one element n times, filling it with $f
+  (func (export "grow_by_one") (param i32) (result i32)
+    (local i32)
+    (loop $l
+      (local.set 1 (table.grow $t (ref.func $f) (i32.const 1)))
+      (local.set 0 (i32.sub (local.get 0) (i32.const 1)))
+      (br_if $l (local.get 0))
+    )
+    (local.get 1)
+  )
+  (func (export "grow") (param i32) (result i32)
+    (table.grow $t (ref.null func) (local.get 0))
+  )
+  (func (export "is_null") (param i32) (result i32)
+    (ref.is_null (table.get $t (local.get 0)))
+  )
+  (func (export "call") (param i32) (result i32)
+    (call_indirect $t (result i32) (local.get 0))
+  )
+  (func (export "set_null") (param i32)
+    (table.set $t (local.get 0) (ref.null func))
+  )
+)
+
+(assert_return (invoke "size") (i32.const 1))
+(assert_return (invoke "grow_by_one" (i32.const 500)) (i32.const 500))
+(assert_return (invoke "size") (i32.const 501))
+(assert_return (invoke "is_null" (i32.const 0)) (i32.const 1))
+(assert_return (invoke "is_null" (i32.const 1)) (i32.const 0))
+(assert_return (invoke "is_null" (i32.const 500)) (i32.const 0))
+(assert_return (invoke "call" (i32.const 300)) (i32.const 42))
+(assert_return (invoke "grow" (i32.const 500)) (i32.const -1))
+(assert_return (invoke "grow" (i32.const 499)) (i32.const 501))
+(assert_return (invoke "grow" (i32.const 0)) (i32.const 1000))
+(assert_return (invoke "is_null" (i32.const 999)) (i32.const 1))
+(assert_trap (invoke "call" (i32.const 999)) "uninitialized element")
+(assert_return (invoke "set_null" (i32.const 300)))
+(assert_trap (invoke "call" (i32.const 300)) "uninitialized element")
+(assert_trap (invoke "is_null" (i32.const 1000)) "out of bounds table access")
+(assert_trap (invoke "set_null" (i32.const 1000)) "out of bounds table access")
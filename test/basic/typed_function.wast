@@ -0,0 +1,61 @@
+;; the shell calls functions of common signatures through TypedFunction
+(module
+  (import "spectest" "print_i32" (func $print_i32 (param i32)))
+  (global $value (mut i32) (i32.const 0))
+
+  (func (export "print") (param i32)
+    (call $print_i32 (local.get 0))
+  )
+  (export "print_host" (func $print_i32))
+
+  (func (export "set") (global.set $value (i32.const 42)))
+  (func (export "get") (result i32) (global.get $value))
+
+  (func (export "neg") (param i32) (result i32)
+    (i32.sub (i32.const 0) (local.get 0))
+  )
+  (func (export "div_s") (param i32 i32) (result i32)
+    (i32.div_s (local.get 0) (local.get 1))
+  )
+  (func (export "mul64") (param i64) (result i64)
+    (i64.mul (local.get 0) (i64.const 3))
+  )
+  (func (export "rem64") (param i64 i64) (result i64)
+    (i64.rem_u (local.get 0) (local.get 1))
+  )
+  (func (export "sub32") (param f32 f32) (result f32)
+    (f32.sub (local.get 0) (local.get 1))
+  )
+  (func (export "div64") (param f64 f64) (result f64)
+    (f64.div (local.get 0) (local.get 1))
+  )
+
+  ;; signatures which are called through Function::call
+  (func (export "divmod") (param i32 i32) (result i32 i32)
+    (i32.div_u (local.get 0) (local.get 1))
+    (i32.rem_u (local.get 0) (local.get 1))
+  )
+  (func (export "promote") (param f32) (result f64)
+    (f64.promote_f32 (local.get 0))
+  )
+)
+
+(assert_return (invoke "print" (i32.const 7)))
+(assert_return (invoke "print_host" (i32.const 8)))
+(assert_return (invoke "get") (i32.const 0))
+(assert_return (invoke "set"))
+(assert_return (invoke "get") (i32.const 42))
+(assert_return (invoke "neg" (i32.const 5)) (i32.const -5))
+(assert_return (invoke "div_s" (i32.const -9) (i32.const 2)) (i32.const -4))
+(assert_trap (invoke "div_s" (i32.const 1) (i32.const 0)) "integer divide by zero")
+(assert_trap (invoke "div_s" (i32.const 0x80000000) (i32.const -1)) "integer overflow")
+(assert_return (invoke "mul64" (i64.const 0x100000000)) (i64.const 0x300000000))
+(assert_return (invoke "rem64" (i64.const -1) (i64.const 10)) (i64.const 5))
+(assert_trap (invoke "rem64" (i64.const 1) (i64.const 0)) "integer divide by zero")
+(assert_return (invoke "sub32" (f32.const 1.5) (f32.const 0.25)) (f32.const 1.25))
+(assert_return (invoke "sub32" (f32.const inf) (f32.const inf)) (f32.const nan:canonical))
+(assert_return (invoke "div64" (f64.const 1) (f64.const 4)) (f64.const 0.25))
+(assert_return (invoke "div64" (f64.const -1) (f64.const 0)) (f64.const -inf))
+(assert_return (invoke "divmod" (i32.const 17) (i32.const 5)) (i32.const 3) (i32.const 2))
+(assert_trap (invoke "divmod" (i32.const 17) (i32.const 0)) "integer divide by zero")
+(assert_return (invoke "promote" (f32.const 0.5)) (f64.const 0.5))
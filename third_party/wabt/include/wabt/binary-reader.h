@@ -50,6 +50,12 @@ struct ReadBinaryOptions {
   bool stop_on_first_error = true;
   bool fail_on_custom_section_error = true;
   bool skip_function_bodies = false;
+  // custom sections other than the name section are skipped without reading
+  // their contents
+  bool skip_custom_sections = false;
+  // the module is known to be valid, so checks which only reject invalid
+  // modules (utf-8 encoding of names, enabled features of opcodes) are skipped
+  bool trusted = false;
 };
 
 // TODO: Move somewhere else?
@@ -492,6 +498,28 @@ Result ReadBinary(const void* data,
                   BinaryReaderDelegate* reader,
                   const ReadBinaryOptions& options);
 
+// Reads a single function body of a module which was read before with
+// skip_function_bodies. |memories| and |data_count| are the memory limits and
+// data count of the module, which are needed to decode the instructions.
+Result ReadBinaryFunctionBody(const void* data,
+                              size_t size,
+                              Index func_index,
+                              Offset body_offset,
+                              Offset body_size,
+                              const std::vector<Limits>& memories,
+                              Index data_count,
+                              BinaryReaderDelegate* reader,
+                              const ReadBinaryOptions& options);
+
+// Reads the payload of a name section (following the section name), which was
+// not read by ReadBinary. |num_funcs| is the number of functions of the
+// module, including imported ones.
+Result ReadBinaryNameSection(const void* data,
+                             size_t size,
+                             Index num_funcs,
+                             BinaryReaderDelegate* reader,
+                             const ReadBinaryOptions& options);
+
 size_t ReadU32Leb128(const uint8_t* ptr,
                      const uint8_t* end,
                      uint32_t* out_value);
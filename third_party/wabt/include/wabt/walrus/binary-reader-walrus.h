@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <cstdarg>
+#include <vector>
 
 #include "wabt/base-types.h"
 #include "wabt/type.h"
@@ -31,6 +32,7 @@ class WASMBinaryReaderDelegate {
 public:
     WASMBinaryReaderDelegate()
         : m_shouldContinueToGenerateByteCode(true)
+        , m_hasError(false)
     {
     }
     virtual ~WASMBinaryReaderDelegate() { }
@@ -42,14 +44,15 @@ public:
     virtual void OnFuncType(Index index, Index paramCount, Type *paramTypes, Index resultCount, Type *resultTypes) = 0;
 
     virtual void OnImportCount(Index count) = 0;
-    virtual void OnImportFunc(Index importIndex, std::string moduleName, std::string fieldName, Index funcIndex, Index sigIndex) = 0;
-    virtual void OnImportGlobal(Index importIndex, std::string moduleName, std::string fieldName, Index globalIndex, Type type, bool mutable_) = 0;
+    // names point into the binary, and are only valid during the callback
+    virtual void OnImportFunc(Index importIndex, const char* moduleName, size_t moduleNameLength, const char* fieldName, size_t fieldNameLength, Index funcIndex, Index sigIndex) = 0;
+    virtual void OnImportGlobal(Index importIndex, const char* moduleName, size_t moduleNameLength, const char* fieldName, size_t fieldNameLength, Index globalIndex, Type type, bool mutable_) = 0;
 
     virtual void OnExportCount(Index count) = 0;
-    virtual void OnExport(int kind, Index exportIndex, std::string name, Index itemIndex) = 0;
+    virtual void OnExport(int kind, Index exportIndex, const char* name, size_t nameLength, Index itemIndex) = 0;
 
     virtual void OnMemoryCount(Index count) = 0;
-    virtual void OnMemory(Index index, size_t initialSize, size_t maximumSize) = 0;
+    virtual void OnMemory(Index index, uint64_t initialSize, uint64_t maximumSize, bool is64, bool isShared) = 0;
 
     virtual void OnTableCount(Index count) = 0;
     virtual void OnTable(Index index, Type type, size_t initialSize, size_t maximumSize) = 0;
@@ -66,6 +69,20 @@ public:
 
     virtual void OnStartFunction(Index funcIndex) = 0;
 
+    virtual void OnElemSegmentCount(Index count) = 0;
+    virtual void BeginElemSegment(Index index, Index tableIndex, bool isPassive, bool isDeclared) = 0;
+    virtual void BeginElemSegmentInitExpr(Index index) = 0;
+    virtual void EndElemSegmentInitExpr(Index index) = 0;
+    virtual void OnElemSegmentElemExprCount(Index index, Index count) = 0;
+    virtual void OnElemSegmentElemExpr_RefNull(Index segmentIndex, Type type) = 0;
+    virtual void OnElemSegmentElemExpr_RefFunc(Index segmentIndex, Index funcIndex) = 0;
+    virtual void EndElemSegment(Index index) = 0;
+
+    // payload of a custom section which follows the section name
+    virtual void OnCustomSection(std::string name, const uint8_t* data, size_t size) = 0;
+    virtual void OnModuleName(std::string name) = 0;
+    virtual void OnFunctionName(Index index, std::string name) = 0;
+
     virtual void BeginFunctionBody(Index index, Offset size) = 0;
 
     virtual void OnLocalDeclCount(Index count) = 0;
@@ -74,6 +91,7 @@ public:
     virtual void OnOpcode(uint32_t opcode) = 0;
 
     virtual void OnCallExpr(Index index) = 0;
+    virtual void OnCallIndirectExpr(Index sigIndex, Index tableIndex) = 0;
     virtual void OnI32ConstExpr(uint32_t value) = 0;
     virtual void OnI64ConstExpr(uint64_t value) = 0;
     virtual void OnF32ConstExpr(uint32_t value) = 0;
@@ -96,6 +114,20 @@ public:
     virtual void OnSelectExpr(Index resultCount, Type *resultTypes) = 0;
     virtual void OnMemoryGrowExpr(Index memidx) = 0;
     virtual void OnMemorySizeExpr(Index memidx) = 0;
+    virtual void OnLoadExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnStoreExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicLoadExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicStoreExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicRmwExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicRmwCmpxchgExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicWaitExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicNotifyExpr(uint32_t opcode, Index memidx, Address alignmentLog2, Address offset) = 0;
+    virtual void OnAtomicFenceExpr(uint32_t consistencyModel) = 0;
+    virtual void OnRefFuncExpr(Index funcIndex) = 0;
+    virtual void OnRefNullExpr(Type type) = 0;
+    virtual void OnRefIsNullExpr() = 0;
+    virtual void OnTableInitExpr(Index segmentIndex, Index tableIndex) = 0;
+    virtual void OnElemDropExpr(Index segmentIndex) = 0;
     virtual void OnTableGetExpr(Index table_index) = 0;
     virtual void OnTableSetExpr(Index table_index) = 0;
     virtual void OnTableGrowExpr(Index table_index) = 0;
@@ -113,11 +145,72 @@ public:
         return m_shouldContinueToGenerateByteCode;
     }
 
+    // the delegate rejected the module, the reader stops before the callback of the next
+    // instruction, or of the current one when OnOpcode rejects it
+    bool hasError() const
+    {
+        return m_hasError;
+    }
+
 protected:
+    void setError()
+    {
+        m_hasError = true;
+    }
+
     bool m_shouldContinueToGenerateByteCode;
+    bool m_hasError;
+};
+
+struct WASMReadOptions {
+    WASMReadOptions()
+        : m_features(~0u)
+        , m_readDebugNames(false)
+        , m_skipCustomSections(false)
+        , m_isTrusted(false)
+    {
+    }
+
+    // bit i enables the i-th feature of wabt/feature.def
+    uint32_t m_features;
+    bool m_readDebugNames;
+    // custom sections other than the name section are not passed to the delegate
+    bool m_skipCustomSections;
+    // skip checks which only reject invalid modules
+    bool m_isTrusted;
+};
+
+// function bodies which were skipped by ReadWasmBinary
+// each of them can be read later by ReadWasmFunctionBody, even on different threads
+struct WASMFunctionBodies {
+    struct Body {
+        Index m_functionIndex;
+        Offset m_offset;
+        Offset m_size;
+    };
+
+    WASMFunctionBodies()
+        : m_dataCount(kInvalidIndex)
+    {
+    }
+
+    std::vector<Body> m_body;
+    // the instruction decoder needs to know the address type of each memory
+    std::vector<bool> m_memoryIs64;
+    // count in the DataCount section, which memory.init and data.drop require
+    Index m_dataCount;
 };
 
-bool ReadWasmBinary(const uint8_t *data, size_t size, WASMBinaryReaderDelegate* delegate);
+// the readers return false when the binary is malformed or the delegate rejected it
+// when skippedBodies is not null, function bodies are not passed to the delegate
+// but recorded in skippedBodies
+bool ReadWasmBinary(const uint8_t *data, size_t size, const WASMReadOptions& options, WASMBinaryReaderDelegate* delegate, WASMFunctionBodies* skippedBodies = nullptr);
+bool ReadWasmFunctionBody(const uint8_t *data, size_t size, const WASMReadOptions& options, const WASMFunctionBodies& bodies, size_t bodyIndex, WASMBinaryReaderDelegate* delegate);
+// only decodes a body which was skipped by ReadWasmBinary, and returns false when
+// ReadWasmFunctionBody would reject it
+bool CheckWasmFunctionBody(const uint8_t *data, size_t size, const WASMReadOptions& options, const WASMFunctionBodies& bodies, size_t bodyIndex);
+// reads a name section payload which was passed to OnCustomSection, functionCount includes imported functions
+bool ReadWasmNameSection(const uint8_t *data, size_t size, const WASMReadOptions& options, Index functionCount, WASMBinaryReaderDelegate* delegate);
 
 }  // namespace wabt
 
@@ -48,7 +48,8 @@
 
 #define ERROR_UNLESS_OPCODE_ENABLED(opcode)     \
   do {                                          \
-    if (!opcode.IsEnabled(options_.features)) { \
+    if (!options_.trusted &&                    \
+        !opcode.IsEnabled(options_.features)) { \
       return ReportUnexpectedOpcode(opcode);    \
     }                                           \
   } while (0)
@@ -76,6 +77,12 @@ class BinaryReader {
                const ReadBinaryOptions& options);
 
   Result ReadModule(const ReadModuleOptions& options);
+  Result ReadFunctionBodyAt(Index func_index,
+                            Offset body_offset,
+                            Offset body_size,
+                            const std::vector<Limits>& memories,
+                            Index data_count);
+  Result ReadNameSectionAt(Index num_funcs);
 
  private:
   template <typename T, T BinaryReader::*member>
@@ -149,6 +156,7 @@ class BinaryReader {
                      Index memory,
                      const char* desc) WABT_WARN_UNUSED;
   Result ReadFunctionBody(Offset end_offset) WABT_WARN_UNUSED;
+  Result ReadFunction(Index func_index, uint32_t body_size) WABT_WARN_UNUSED;
   // ReadInstructions either until and END instruction, or until
   // the given end_offset.
   Result ReadInstructions(bool stop_on_end,
@@ -389,7 +397,8 @@ Result BinaryReader::ReadStr(std::string_view* out_str, const char* desc) {
       reinterpret_cast<const char*>(state_.data) + state_.offset, str_len);
   state_.offset += str_len;
 
-  ERROR_UNLESS(IsValidUtf8(out_str->data(), out_str->length()),
+  ERROR_UNLESS(options_.trusted ||
+                   IsValidUtf8(out_str->data(), out_str->length()),
                "invalid utf-8 encoding: %s", desc);
   return Result::Ok;
 }
@@ -2358,6 +2367,11 @@ Result BinaryReader::ReadCustomSection(Index section_index,
                                        Offset section_size) {
   std::string_view section_name;
   CHECK_RESULT(ReadStr(&section_name, "section name"));
+  if (options_.skip_custom_sections &&
+      section_name != WABT_BINARY_SECTION_NAME) {
+    state_.offset = read_end_;
+    return Result::Ok;
+  }
   CALLBACK(BeginCustomSection, section_index, section_size, section_name);
   ValueRestoreGuard<bool, &BinaryReader::reading_custom_section_> guard(this);
   reading_custom_section_ = true;
@@ -2740,38 +2754,67 @@ Result BinaryReader::ReadCodeSection(Offset section_size) {
     state_.offset = func_offset;
     uint32_t body_size;
     CHECK_RESULT(ReadU32Leb128(&body_size, "function body size"));
-    Offset body_start_offset = state_.offset;
-    Offset end_offset = body_start_offset + body_size;
-    CALLBACK(BeginFunctionBody, func_index, body_size);
-
-    uint64_t total_locals = 0;
-    Index num_local_decls;
-    CHECK_RESULT(ReadCount(&num_local_decls, "local declaration count"));
-    CALLBACK(OnLocalDeclCount, num_local_decls);
-    for (Index k = 0; k < num_local_decls; ++k) {
-      Index num_local_types;
-      CHECK_RESULT(ReadIndex(&num_local_types, "local type count"));
-      total_locals += num_local_types;
-      ERROR_UNLESS(total_locals < UINT32_MAX,
-                   "local count must be < 0x10000000");
-      Type local_type;
-      CHECK_RESULT(ReadType(&local_type, "local type"));
-      ERROR_UNLESS(IsConcreteType(local_type), "expected valid local type");
-      CALLBACK(OnLocalDecl, k, num_local_types, local_type);
-    }
+    CHECK_RESULT(ReadFunction(func_index, body_size));
+  }
+  CALLBACK0(EndCodeSection);
+  return Result::Ok;
+}
 
-    if (options_.skip_function_bodies) {
-      state_.offset = end_offset;
-    } else {
-      CHECK_RESULT(ReadFunctionBody(end_offset));
-    }
+Result BinaryReader::ReadFunction(Index func_index, uint32_t body_size) {
+  Offset body_start_offset = state_.offset;
+  Offset end_offset = body_start_offset + body_size;
+  CALLBACK(BeginFunctionBody, func_index, body_size);
+
+  uint64_t total_locals = 0;
+  Index num_local_decls;
+  CHECK_RESULT(ReadCount(&num_local_decls, "local declaration count"));
+  CALLBACK(OnLocalDeclCount, num_local_decls);
+  for (Index k = 0; k < num_local_decls; ++k) {
+    Index num_local_types;
+    CHECK_RESULT(ReadIndex(&num_local_types, "local type count"));
+    total_locals += num_local_types;
+    ERROR_UNLESS(total_locals < UINT32_MAX,
+                 "local count must be < 0x10000000");
+    Type local_type;
+    CHECK_RESULT(ReadType(&local_type, "local type"));
+    ERROR_UNLESS(IsConcreteType(local_type), "expected valid local type");
+    CALLBACK(OnLocalDecl, k, num_local_types, local_type);
+  }
 
-    CALLBACK(EndFunctionBody, func_index);
+  if (options_.skip_function_bodies) {
+    state_.offset = end_offset;
+  } else {
+    CHECK_RESULT(ReadFunctionBody(end_offset));
   }
-  CALLBACK0(EndCodeSection);
+
+  CALLBACK(EndFunctionBody, func_index);
   return Result::Ok;
 }
 
+Result BinaryReader::ReadFunctionBodyAt(Index func_index,
+                                        Offset body_offset,
+                                        Offset body_size,
+                                        const std::vector<Limits>& memories,
+                                        Index data_count) {
+  ERROR_UNLESS(body_offset + body_size <= state_.size,
+               "function body out of bounds");
+  // restore the module state which the instruction decoder depends on
+  this->memories = memories;
+  data_count_ = data_count;
+  state_.offset = body_offset;
+  read_end_ = body_offset + body_size;
+  return ReadFunction(func_index, body_size);
+}
+
+Result BinaryReader::ReadNameSectionAt(Index num_funcs) {
+  // function indices of the names are checked against num_funcs
+  num_func_imports_ = 0;
+  num_function_signatures_ = num_funcs;
+  state_.offset = 0;
+  read_end_ = state_.size;
+  return ReadNameSection(state_.size);
+}
+
 Result BinaryReader::ReadDataSection(Offset section_size) {
   CALLBACK(BeginDataSection, section_size);
   Index num_data_segments;
@@ -2999,4 +3042,27 @@ Result ReadBinary(const void* data,
       BinaryReader::ReadModuleOptions{options.stop_on_first_error});
 }
 
+Result ReadBinaryFunctionBody(const void* data,
+                              size_t size,
+                              Index func_index,
+                              Offset body_offset,
+                              Offset body_size,
+                              const std::vector<Limits>& memories,
+                              Index data_count,
+                              BinaryReaderDelegate* delegate,
+                              const ReadBinaryOptions& options) {
+  BinaryReader reader(data, size, delegate, options);
+  return reader.ReadFunctionBodyAt(func_index, body_offset, body_size,
+                                   memories, data_count);
+}
+
+Result ReadBinaryNameSection(const void* data,
+                             size_t size,
+                             Index num_funcs,
+                             BinaryReaderDelegate* delegate,
+                             const ReadBinaryOptions& options) {
+  BinaryReader reader(data, size, delegate, options);
+  return reader.ReadNameSectionAt(num_funcs);
+}
+
 }  // namespace wabt
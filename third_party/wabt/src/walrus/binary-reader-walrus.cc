@@ -18,6 +18,7 @@
 #include <set>
 
 #include "wabt/binary-reader.h"
+#include "wabt/binary-reader-nop.h"
 #include "wabt/feature.h"
 #include "wabt/shared-validator.h"
 #include "wabt/stream.h"
@@ -30,8 +31,10 @@ namespace wabt {
 
 class BinaryReaderDelegateWalrus : public BinaryReaderDelegate {
 public:
-    BinaryReaderDelegateWalrus(WASMBinaryReaderDelegate* delegate)
+    BinaryReaderDelegateWalrus(WASMBinaryReaderDelegate* delegate, WASMFunctionBodies* skippedBodies = nullptr)
         : m_externalDelegate(delegate)
+        , m_skippedBodies(skippedBodies)
+        , m_sectionStart(0)
     {
 
     }
@@ -51,16 +54,18 @@ public:
     }
 
     Result BeginSection(Index section_index, BinarySection section_type, Offset size) override {
+        m_sectionStart = state->offset;
         return Result::Ok;
     }
 
     /* Custom section */
     Result BeginCustomSection(Index section_index, Offset size, std::string_view section_name) override {
-        abort();
+        // the section name is already read
+        Offset sectionEnd = m_sectionStart + size;
+        m_externalDelegate->OnCustomSection(std::string(section_name), state->data + state->offset, sectionEnd - state->offset);
         return Result::Ok;
     }
     Result EndCustomSection() override {
-        abort();
         return Result::Ok;
     }
 
@@ -100,7 +105,7 @@ public:
         return Result::Ok;
     }
     Result OnImportFunc(Index import_index, std::string_view module_name, std::string_view field_name, Index func_index, Index sig_index) override {
-        m_externalDelegate->OnImportFunc(import_index, std::string(module_name), std::string(field_name), func_index, sig_index);
+        m_externalDelegate->OnImportFunc(import_index, module_name.data(), module_name.size(), field_name.data(), field_name.size(), func_index, sig_index);
         return Result::Ok;
     }
     Result OnImportTable(Index import_index, std::string_view module_name, std::string_view field_name, Index table_index, Type elem_type, const Limits *elem_limits) override {
@@ -112,7 +117,7 @@ public:
         return Result::Ok;
     }
     Result OnImportGlobal(Index import_index, std::string_view module_name, std::string_view field_name, Index global_index, Type type, bool mutable_) override {
-        m_externalDelegate->OnImportGlobal(import_index, std::string(module_name), std::string(field_name), global_index, type, mutable_);
+        m_externalDelegate->OnImportGlobal(import_index, module_name.data(), module_name.size(), field_name.data(), field_name.size(), global_index, type, mutable_);
         return Result::Ok;
     }
     Result OnImportTag(Index import_index, std::string_view module_name, std::string_view field_name, Index tag_index, Index sig_index) override {
@@ -164,7 +169,12 @@ public:
         return Result::Ok;
     }
     Result OnMemory(Index index, const Limits *limits) override {
-        m_externalDelegate->OnMemory(index, limits->initial, limits->has_max ? limits->max : (std::numeric_limits<size_t>::max() / (1024 * 64)));
+        // memory32 may not exceed 4GiB(65536 pages), memory64 is only limited by host address space
+        uint64_t defaultMaximum = limits->is_64 ? (std::numeric_limits<size_t>::max() / (1024 * 64)) : (1ull << 16);
+        m_externalDelegate->OnMemory(index, limits->initial, limits->has_max ? limits->max : defaultMaximum, limits->is_64, limits->is_shared);
+        if (m_skippedBodies) {
+            m_skippedBodies->m_memoryIs64.push_back(limits->is_64);
+        }
         return Result::Ok;
     }
     Result EndMemorySection() override {
@@ -212,7 +222,7 @@ public:
         if (kind != ExternalKind::Func) {
             abort();
         }
-        m_externalDelegate->OnExport(static_cast<int>(kind), index, std::string(name), item_index);
+        m_externalDelegate->OnExport(static_cast<int>(kind), index, name.data(), name.size(), item_index);
         return Result::Ok;
     }
     Result EndExportSection() override {
@@ -239,14 +249,24 @@ public:
         return Result::Ok;
     }
     Result BeginFunctionBody(Index index, Offset size) override {
+        if (m_skippedBodies) {
+            m_skippedBodies->m_body.push_back({ index, state->offset, size });
+            return Result::Ok;
+        }
         m_externalDelegate->BeginFunctionBody(index, size);
         return Result::Ok;
     }
     Result OnLocalDeclCount(Index count) override {
+        if (m_skippedBodies) {
+            return Result::Ok;
+        }
         m_externalDelegate->OnLocalDeclCount(count);
         return Result::Ok;
     }
     Result OnLocalDecl(Index decl_index, Index count, Type type) override {
+        if (m_skippedBodies) {
+            return Result::Ok;
+        }
         m_externalDelegate->OnLocalDecl(decl_index, count, type);
         return Result::Ok;
     }
@@ -254,10 +274,13 @@ public:
     /* Function expressions; called between BeginFunctionBody and
      EndFunctionBody */
     Result OnOpcode(Opcode opcode) override {
-        SHOULD_GENERATE_BYTECODE;
-        Opcode::Enum e = opcode;
-        m_externalDelegate->OnOpcode(e);
-        return Result::Ok;
+        // the delegate can reject the previous instruction, or this one before its own callback
+        if (WABT_LIKELY(!m_externalDelegate->hasError())) {
+            SHOULD_GENERATE_BYTECODE;
+            Opcode::Enum e = opcode;
+            m_externalDelegate->OnOpcode(e);
+        }
+        return m_externalDelegate->hasError() ? Result::Error : Result::Ok;
     }
     Result OnOpcodeBare() override {
         return Result::Ok;
@@ -273,7 +296,6 @@ public:
         return Result::Ok;
     }
     Result OnOpcodeUint32Uint32(uint32_t value, uint32_t value2) override {
-        abort();
         return Result::Ok;
     }
     Result OnOpcodeUint32Uint32Uint32(uint32_t value, uint32_t value2, uint32_t value3) override {
@@ -301,35 +323,41 @@ public:
         return Result::Ok;
     }
     Result OnOpcodeType(Type type) override {
-        abort();
         return Result::Ok;
     }
     Result OnAtomicLoadExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicLoadExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnAtomicStoreExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicStoreExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnAtomicRmwExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicRmwExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnAtomicRmwCmpxchgExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicRmwCmpxchgExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
-    Result OnAtomicWaitExpr(Opcode, Index, Address, Address) override {
-        abort();
+    Result OnAtomicWaitExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicWaitExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
-    Result OnAtomicFenceExpr(uint32_t) override {
-        abort();
+    Result OnAtomicFenceExpr(uint32_t consistency_model) override {
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicFenceExpr(consistency_model);
         return Result::Ok;
     }
-    Result OnAtomicNotifyExpr(Opcode, Index, Address, Address) override {
-        abort();
+    Result OnAtomicNotifyExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnAtomicNotifyExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnBinaryExpr(Opcode opcode) override {
@@ -363,7 +391,8 @@ public:
         return Result::Ok;
     }
     Result OnCallIndirectExpr(Index sig_index, Index table_index) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnCallIndirectExpr(sig_index, table_index);
         return Result::Ok;
     }
     Result OnCallRefExpr() override {
@@ -447,7 +476,8 @@ public:
         return Result::Ok;
     }
     Result OnLoadExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnLoadExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnLocalGetExpr(Index local_index) override {
@@ -502,11 +532,13 @@ public:
         return Result::Ok;
     }
     Result OnElemDropExpr(Index segment_index) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnElemDropExpr(segment_index);
         return Result::Ok;
     }
     Result OnTableInitExpr(Index segment_index, Index table_index) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnTableInitExpr(segment_index, table_index);
         return Result::Ok;
     }
     Result OnTableGetExpr(Index table_index) override {
@@ -535,15 +567,18 @@ public:
         return Result::Ok;
     }
     Result OnRefFuncExpr(Index func_index) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnRefFuncExpr(func_index);
         return Result::Ok;
     }
     Result OnRefNullExpr(Type type) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnRefNullExpr(type);
         return Result::Ok;
     }
     Result OnRefIsNullExpr() override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnRefIsNullExpr();
         return Result::Ok;
     }
     Result OnNopExpr() override {
@@ -572,7 +607,8 @@ public:
         return Result::Ok;
     }
     Result OnStoreExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
-        abort();
+        SHOULD_GENERATE_BYTECODE;
+        m_externalDelegate->OnStoreExpr(opcode, memidx, alignment_log2, offset);
         return Result::Ok;
     }
     Result OnThrowExpr(Index depth) override {
@@ -597,6 +633,9 @@ public:
         return Result::Ok;
     }
     Result EndFunctionBody(Index index) override {
+        if (m_skippedBodies) {
+            return Result::Ok;
+        }
         m_externalDelegate->EndFunctionBody(index);
         return Result::Ok;
     }
@@ -630,47 +669,44 @@ public:
 
     /* Elem section */
     Result BeginElemSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnElemSegmentCount(Index count) override {
-        abort();
+        m_externalDelegate->OnElemSegmentCount(count);
         return Result::Ok;
     }
     Result BeginElemSegment(Index index, Index table_index, uint8_t flags) override {
-        abort();
+        m_externalDelegate->BeginElemSegment(index, table_index, (flags & SegDeclared) == SegPassive, (flags & SegDeclared) == SegDeclared);
         return Result::Ok;
     }
     Result BeginElemSegmentInitExpr(Index index) override {
-        abort();
+        m_externalDelegate->BeginElemSegmentInitExpr(index);
         return Result::Ok;
     }
     Result EndElemSegmentInitExpr(Index index) override {
-        abort();
+        m_externalDelegate->EndElemSegmentInitExpr(index);
         return Result::Ok;
     }
     Result OnElemSegmentElemType(Index index, Type elem_type) override {
-        abort();
         return Result::Ok;
     }
     Result OnElemSegmentElemExprCount(Index index, Index count) override {
-        abort();
+        m_externalDelegate->OnElemSegmentElemExprCount(index, count);
         return Result::Ok;
     }
     Result OnElemSegmentElemExpr_RefNull(Index segment_index, Type type) override {
-        abort();
+        m_externalDelegate->OnElemSegmentElemExpr_RefNull(segment_index, type);
         return Result::Ok;
     }
     Result OnElemSegmentElemExpr_RefFunc(Index segment_index, Index func_index) override {
-        abort();
+        m_externalDelegate->OnElemSegmentElemExpr_RefFunc(segment_index, func_index);
         return Result::Ok;
     }
     Result EndElemSegment(Index index) override {
-        abort();
+        m_externalDelegate->EndElemSegment(index);
         return Result::Ok;
     }
     Result EndElemSection() override {
-        abort();
         return Result::Ok;
     }
 
@@ -710,92 +746,76 @@ public:
 
     /* DataCount section */
     Result BeginDataCountSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnDataCount(Index count) override {
-        abort();
+        if (m_skippedBodies) {
+            m_skippedBodies->m_dataCount = count;
+        }
         return Result::Ok;
     }
     Result EndDataCountSection() override {
-        abort();
         return Result::Ok;
     }
 
     /* Names section */
     Result BeginNamesSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnModuleNameSubsection(Index index, uint32_t name_type, Offset subsection_size) override {
-        abort();
         return Result::Ok;
     }
     Result OnModuleName(std::string_view name) override {
-        abort();
+        m_externalDelegate->OnModuleName(std::string(name));
         return Result::Ok;
     }
     Result OnFunctionNameSubsection(Index index, uint32_t name_type, Offset subsection_size) override {
-        abort();
         return Result::Ok;
     }
     Result OnFunctionNamesCount(Index num_functions) override {
-        abort();
         return Result::Ok;
     }
     Result OnFunctionName(Index function_index, std::string_view function_name) override {
-        abort();
+        m_externalDelegate->OnFunctionName(function_index, std::string(function_name));
         return Result::Ok;
     }
     Result OnLocalNameSubsection(Index index, uint32_t name_type, Offset subsection_size) override {
-        abort();
         return Result::Ok;
     }
     Result OnLocalNameFunctionCount(Index num_functions) override {
-        abort();
         return Result::Ok;
     }
     Result OnLocalNameLocalCount(Index function_index, Index num_locals) override {
-        abort();
         return Result::Ok;
     }
     Result OnLocalName(Index function_index, Index local_index, std::string_view local_name) override {
-        abort();
         return Result::Ok;
     }
     Result EndNamesSection() override {
-        abort();
         return Result::Ok;
     }
 
     Result OnNameSubsection(Index index, NameSectionSubsection subsection_type, Offset subsection_size) override {
-        abort();
         return Result::Ok;
     }
     Result OnNameCount(Index num_names) override {
-        abort();
         return Result::Ok;
     }
     Result OnNameEntry(NameSectionSubsection type, Index index, std::string_view name) override {
-        abort();
         return Result::Ok;
     }
 
     /* Reloc section */
     Result BeginRelocSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnRelocCount(Index count, Index section_code) override {
-        abort();
         return Result::Ok;
     }
     Result OnReloc(RelocType type, Offset offset, Index index, uint32_t addend) override {
-        abort();
         return Result::Ok;
     }
     Result EndRelocSection() override {
-        abort();
         return Result::Ok;
     }
 
@@ -819,164 +839,220 @@ public:
 
     /* Code Metadata sections */
     Result BeginCodeMetadataSection(std::string_view name, Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnCodeMetadataFuncCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnCodeMetadataCount(Index function_index, Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnCodeMetadata(Offset offset, const void *data, Address size) override {
-        abort();
         return Result::Ok;
     }
     Result EndCodeMetadataSection() override {
-        abort();
         return Result::Ok;
     }
 
     /* Dylink section */
     Result BeginDylinkSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkInfo(uint32_t mem_size, uint32_t mem_align, uint32_t table_size, uint32_t table_align) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkNeededCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkNeeded(std::string_view so_name) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkImportCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkExportCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkImport(std::string_view module, std::string_view name, uint32_t flags) override {
-        abort();
         return Result::Ok;
     }
     Result OnDylinkExport(std::string_view name, uint32_t flags) override {
-        abort();
         return Result::Ok;
     }
     Result EndDylinkSection() override {
-        abort();
         return Result::Ok;
     }
 
     /* target_features section */
     Result BeginTargetFeaturesSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnFeatureCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnFeature(uint8_t prefix, std::string_view name) override {
-        abort();
         return Result::Ok;
     }
     Result EndTargetFeaturesSection() override {
-        abort();
         return Result::Ok;
     }
 
     /* Linking section */
     Result BeginLinkingSection(Offset size) override {
-        abort();
         return Result::Ok;
     }
     Result OnSymbolCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnDataSymbol(Index index, uint32_t flags, std::string_view name, Index segment, uint32_t offset, uint32_t size) override {
-        abort();
         return Result::Ok;
     }
     Result OnFunctionSymbol(Index index, uint32_t flags, std::string_view name, Index func_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnGlobalSymbol(Index index, uint32_t flags, std::string_view name, Index global_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnSectionSymbol(Index index, uint32_t flags, Index section_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnTagSymbol(Index index, uint32_t flags, std::string_view name, Index tag_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnTableSymbol(Index index, uint32_t flags, std::string_view name, Index table_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnSegmentInfoCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnSegmentInfo(Index index, std::string_view name, Address alignment, uint32_t flags) override {
-        abort();
         return Result::Ok;
     }
     Result OnInitFunctionCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnInitFunction(uint32_t priority, Index function_index) override {
-        abort();
         return Result::Ok;
     }
     Result OnComdatCount(Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnComdatBegin(std::string_view name, uint32_t flags, Index count) override {
-        abort();
         return Result::Ok;
     }
     Result OnComdatEntry(ComdatType kind, Index index) override {
-        abort();
         return Result::Ok;
     }
     Result EndLinkingSection() override {
-        abort();
         return Result::Ok;
     }
 
     WASMBinaryReaderDelegate* m_externalDelegate;
+    WASMFunctionBodies* m_skippedBodies;
+    Offset m_sectionStart;
 };
 
-bool ReadWasmBinary(const uint8_t* data, size_t size, WASMBinaryReaderDelegate* delegate)
+// decodes a skipped function body without generating anything, so the body is rejected
+// like the walrus delegate would reject it: atomic operations are only allowed on the
+// first memory when it is a memory32
+class BinaryReaderFunctionBodyChecker : public BinaryReaderNop {
+public:
+    BinaryReaderFunctionBodyChecker(const std::vector<bool>& memoryIs64)
+        : m_memoryIs64(memoryIs64)
+    {
+    }
+
+    Result OnAtomicLoadExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+    Result OnAtomicStoreExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+    Result OnAtomicRmwExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+    Result OnAtomicRmwCmpxchgExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+    Result OnAtomicWaitExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+    Result OnAtomicNotifyExpr(Opcode opcode, Index memidx, Address alignment_log2, Address offset) override {
+        return checkAtomicMemory(memidx);
+    }
+
+private:
+    Result checkAtomicMemory(Index memidx) {
+        return memidx == 0 && !m_memoryIs64.empty() && !m_memoryIs64[0] ? Result::Ok : Result::Error;
+    }
+
+    const std::vector<bool>& m_memoryIs64;
+};
+
+static ReadBinaryOptions readBinaryOptions(const WASMReadOptions& walrusOptions)
 {
-    const bool kReadDebugNames = true;
     const bool kStopOnFirstError = true;
     const bool kFailOnCustomSectionError = true;
     Features features;
-    features.EnableAll();
-    ReadBinaryOptions options(features, nullptr, kReadDebugNames,
-                             kStopOnFirstError, kFailOnCustomSectionError);
+    uint32_t featureBit = 1;
+#define WABT_FEATURE(variable, flag, default_, help)                                \
+    features.set_##variable##_enabled((walrusOptions.m_features & featureBit) != 0); \
+    featureBit <<= 1;
+#include "wabt/feature.def"
+#undef WABT_FEATURE
+    ReadBinaryOptions options(features, nullptr, walrusOptions.m_readDebugNames,
+                              kStopOnFirstError, kFailOnCustomSectionError);
+    options.skip_custom_sections = walrusOptions.m_skipCustomSections;
+    options.trusted = walrusOptions.m_isTrusted;
+    return options;
+}
+
+bool ReadWasmBinary(const uint8_t* data, size_t size, const WASMReadOptions& walrusOptions, WASMBinaryReaderDelegate* delegate, WASMFunctionBodies* skippedBodies)
+{
+    ReadBinaryOptions options = readBinaryOptions(walrusOptions);
+    options.skip_function_bodies = skippedBodies != nullptr;
+    BinaryReaderDelegateWalrus binaryReaderDelegateWalrus(delegate, skippedBodies);
+    Result result = ReadBinary(data, size, &binaryReaderDelegateWalrus, options);
+
+    return Succeeded(result) && !delegate->hasError();
+}
+
+bool ReadWasmFunctionBody(const uint8_t* data, size_t size, const WASMReadOptions& walrusOptions, const WASMFunctionBodies& bodies, size_t bodyIndex, WASMBinaryReaderDelegate* delegate)
+{
+    ReadBinaryOptions options = readBinaryOptions(walrusOptions);
+    std::vector<Limits> memories(bodies.m_memoryIs64.size());
+    for (size_t i = 0; i < memories.size(); i++) {
+        memories[i].is_64 = bodies.m_memoryIs64[i];
+    }
+    const WASMFunctionBodies::Body& body = bodies.m_body[bodyIndex];
+    BinaryReaderDelegateWalrus binaryReaderDelegateWalrus(delegate);
+    Result result = ReadBinaryFunctionBody(data, size, body.m_functionIndex, body.m_offset, body.m_size, memories, bodies.m_dataCount, &binaryReaderDelegateWalrus, options);
+
+    return Succeeded(result) && !delegate->hasError();
+}
+
+bool CheckWasmFunctionBody(const uint8_t* data, size_t size, const WASMReadOptions& walrusOptions, const WASMFunctionBodies& bodies, size_t bodyIndex)
+{
+    ReadBinaryOptions options = readBinaryOptions(walrusOptions);
+    std::vector<Limits> memories(bodies.m_memoryIs64.size());
+    for (size_t i = 0; i < memories.size(); i++) {
+        memories[i].is_64 = bodies.m_memoryIs64[i];
+    }
+    const WASMFunctionBodies::Body& body = bodies.m_body[bodyIndex];
+    BinaryReaderFunctionBodyChecker checker(bodies.m_memoryIs64);
+    Result result = ReadBinaryFunctionBody(data, size, body.m_functionIndex, body.m_offset, body.m_size, memories, bodies.m_dataCount, &checker, options);
+
+    return Succeeded(result);
+}
+
+bool ReadWasmNameSection(const uint8_t* data, size_t size, const WASMReadOptions& walrusOptions, Index functionCount, WASMBinaryReaderDelegate* delegate)
+{
+    ReadBinaryOptions options = readBinaryOptions(walrusOptions);
+    options.read_debug_names = true;
     BinaryReaderDelegateWalrus binaryReaderDelegateWalrus(delegate);
-    ReadBinary(data, size, &binaryReaderDelegateWalrus, options);
+    Result result = ReadBinaryNameSection(data, size, functionCount, &binaryReaderDelegateWalrus, options);
 
-    return true;
+    return Succeeded(result) && !delegate->hasError();
 }
 
 }  // namespace wabt
@@ -3316,6 +3316,9 @@ Result WastParser::ParseModuleCommand(Script* script, CommandPtr* out_command) {
       options.log_stream = log_stream.get();
 #endif
       options.features = options_->features;
+      // custom sections are not kept in the IR, and are left to the engine
+      // which loads the binary
+      options.skip_custom_sections = true;
       Errors errors;
       const char* filename = "<text>";
       ReadBinaryIr(filename, bsm->data.data(), bsm->data.size(), options,
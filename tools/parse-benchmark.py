@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+
+# Copyright 2022-present Samsung Electronics Co., Ltd.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measures module loading time of synthetic modules of growing size.
+# Loading time should grow linearly with the number of functions and locals.
+
+from __future__ import print_function
+
+import os
+import sys
+import tempfile
+import time
+
+from argparse import ArgumentParser
+from os.path import abspath, dirname, join
+from subprocess import PIPE, Popen
+
+
+PROJECT_SOURCE_DIR = dirname(dirname(abspath(__file__)))
+DEFAULT_WALRUS = join(PROJECT_SOURCE_DIR, 'walrus')
+
+I32 = 0x7f
+
+
+def uleb(value):
+    result = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            result.append(byte | 0x80)
+        else:
+            result.append(byte)
+            return bytes(result)
+
+
+def vector(items):
+    return uleb(len(items)) + b''.join(items)
+
+
+def section(sid, payload):
+    return bytes(bytearray([sid])) + uleb(len(payload)) + payload
+
+
+def op(*codes):
+    return bytes(bytearray(codes))
+
+
+def small_function_body():
+    # (block (local.get 0) (br_if 0 (local.get 0)) (drop)) (local.get 0)
+    code = op(0x02, 0x40)
+    code += op(0x20) + uleb(0) + op(0x20) + uleb(0) + op(0x0d) + uleb(0) + op(0x1a)
+    code += op(0x0b)
+    code += op(0x20) + uleb(0) + op(0x0b)
+    return vector([]) + code
+
+
+def local_heavy_function_body(local_count):
+    # each local is read and written once, the last ones dominate if
+    # local offsets were computed by summing the preceding locals
+    locals_decl = vector([uleb(local_count) + op(I32)])
+    code = b''
+    for i in range(1, local_count + 1):
+        code += op(0x20) + uleb(i - 1) + op(0x21) + uleb(i)
+    code += op(0x20) + uleb(local_count) + op(0x0b)
+    return locals_decl + code
+
+
+def build_module(function_count, local_count):
+    types = vector([op(0x60) + vector([op(I32)]) + vector([op(I32)])])
+    functions = vector([uleb(0)] * function_count)
+    bodies = [local_heavy_function_body(local_count)]
+    small = small_function_body()
+    bodies += [small] * (function_count - 1)
+    code = vector([uleb(len(b)) + b for b in bodies])
+
+    module = b'\0asm' + op(1, 0, 0, 0)
+    module += section(1, types)
+    module += section(3, functions)
+    module += section(10, code)
+    return module
+
+
+def measure(engine, path, repeat):
+    best = None
+    for _ in range(repeat):
+        start = time.time()
+        proc = Popen([engine, path], stdout=PIPE, stderr=PIPE)
+        proc.communicate()
+        elapsed = time.time() - start
+        if proc.returncode != 0:
+            raise Exception('%s failed with exit code %d' % (path, proc.returncode))
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    parser = ArgumentParser(description='Walrus Module Parsing Benchmark')
+    parser.add_argument('--engine', metavar='PATH', default=DEFAULT_WALRUS,
+                        help='path to the engine to be measured (default: %(default)s)')
+    parser.add_argument('--functions', metavar='N', type=int, default=100000,
+                        help='number of functions in the largest module (default: %(default)s)')
+    parser.add_argument('--locals', metavar='N', type=int, default=10000,
+                        help='number of locals in the largest function (default: %(default)s)')
+    parser.add_argument('--steps', metavar='N', type=int, default=4,
+                        help='number of module sizes, each twice as large as the previous (default: %(default)s)')
+    parser.add_argument('--repeat', metavar='N', type=int, default=3,
+                        help='number of runs per module, the fastest is reported (default: %(default)s)')
+    args = parser.parse_args()
+
+    print('%10s %10s %10s %14s' % ('functions', 'locals', 'seconds', 'us/function'))
+    results = []
+    for step in reversed(range(args.steps)):
+        function_count = max(args.functions >> step, 1)
+        local_count = max(args.locals >> step, 1)
+        fd, path = tempfile.mkstemp(suffix='.wasm')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(build_module(function_count, local_count))
+            elapsed = measure(args.engine, path, args.repeat)
+        finally:
+            os.remove(path)
+        results.append((function_count, elapsed))
+        print('%10d %10d %10.3f %14.3f' % (function_count, local_count, elapsed, elapsed * 1e6 / function_count))
+
+    if len(results) > 1:
+        first, last = results[0], results[-1]
+        print('size grew %.1fx, time grew %.1fx' % (float(last[0]) / first[0], last[1] / first[1]))
+
+
+if __name__ == '__main__':
+    main()
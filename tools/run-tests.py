@@ -19,6 +19,7 @@ from __future__ import print_function
 import os
 import traceback
 import sys
+import tempfile
 import time
 import re, fnmatch
 
@@ -26,7 +27,7 @@ from argparse import ArgumentParser
 from difflib import unified_diff
 from glob import glob
 from os.path import abspath, basename, dirname, join, relpath
-from shutil import copy
+from shutil import copy, rmtree
 from subprocess import PIPE, Popen
 
 
@@ -100,10 +101,18 @@ def readfile(filename):
     with open(filename, 'r') as f:
         return f.readlines()
     
+def _engine_flags(file):
+    # the first line of a test can give options to the engine, e.g. ';; flags: --batch-invoke'
+    with open(file, 'r') as f:
+        line = f.readline()
+    if line.startswith(';; flags:'):
+        return line[len(';; flags:'):].split()
+    return []
+
 def _run_wast_tests(engine, files, is_fail):
     fails = 0
     for file in files:
-        proc = Popen([engine, file], stdout=PIPE)
+        proc = Popen([engine] + _engine_flags(file) + [file], stdout=PIPE)
         out, _ = proc.communicate()
 
         if is_fail and proc.returncode or not is_fail and not proc.returncode:
@@ -151,6 +160,107 @@ def run_basic_tests(engine):
     if fail_total > 0:
         raise Exception("basic wasm-test-core failed")
 
+def _run_engine(engine, args):
+    proc = Popen([engine] + args, stdout=PIPE)
+    out, _ = proc.communicate()
+    return proc.returncode, out
+
+
+def _cache_files(cache_dir):
+    return sorted(glob(join(cache_dir, '*.wmc')))
+
+
+@runner('module-cache')
+def run_module_cache_tests(engine):
+    # the on-disk module cache (--module-cache=DIR) is only used by release builds
+    TEST_DIR = join(PROJECT_SOURCE_DIR, 'test', 'basic')
+
+    # each case changes the cache files written by the first run, then the test must pass again
+    # with the files read (kept), or with the files rejected and written again
+    def keep(path):
+        pass
+
+    def truncate(path):
+        with open(path, 'r+b') as f:
+            f.truncate(os.path.getsize(path) // 2)
+
+    def corrupt_magic(path):
+        with open(path, 'r+b') as f:
+            f.write(b'XXXXXXXX')
+
+    def change_version(path):
+        # the format version follows the 8 byte magic
+        with open(path, 'r+b') as f:
+            f.seek(8)
+            f.write(b'\xff\xff\xff\xff')
+
+    # no test uses exceptions, so disabling them changes the parse options but not the results
+    cases = [('hit', keep, [], True),
+             ('truncated file', truncate, [], False),
+             ('corrupt magic', corrupt_magic, [], False),
+             ('format version mismatch', change_version, [], False),
+             ('options mismatch', keep, ['--disable-feature=exceptions'], False),
+             ('hit of the files written again', keep, [], True)]
+
+    print('Running module cache tests:')
+    files = sorted(glob(join(TEST_DIR, '*')))
+    fails = 0
+    cached_total = 0
+    for file in files:
+        cache_dir = tempfile.mkdtemp()
+        try:
+            args = _engine_flags(file) + ['--module-cache=' + cache_dir, file]
+            returncode, out = _run_engine(engine, args)
+            if returncode:
+                print('%sFAIL(%d): %s (cache miss)%s' % (COLOR_RED, returncode, file, COLOR_RESET))
+                print(out)
+                fails += 1
+                continue
+            cache_files = _cache_files(cache_dir)
+            cached_total += len(cache_files)
+            if not cache_files:
+                # e.g. modules which import a memory are not cached
+                print('%sOK: %s (not cached)%s' % (COLOR_GREEN, file, COLOR_RESET))
+                continue
+
+            for name, change, extra_flags, is_kept in cases:
+                inodes = {}
+                for path in cache_files:
+                    change(path)
+                    inodes[path] = os.stat(path).st_ino
+                returncode, out = _run_engine(engine, extra_flags + args)
+                error = None
+                if returncode:
+                    error = 'exit code %d' % returncode
+                elif _cache_files(cache_dir) != cache_files:
+                    error = 'cache files changed'
+                else:
+                    for path in cache_files:
+                        if (os.stat(path).st_ino == inodes[path]) != is_kept:
+                            error = '%s was %s' % (basename(path), 'written again' if is_kept else 'not written again')
+                if error:
+                    print('%sFAIL: %s (%s: %s)%s' % (COLOR_RED, file, name, error, COLOR_RESET))
+                    print(out)
+                    fails += 1
+                    break
+                if extra_flags:
+                    # written with other options, so the next case starts from the original files
+                    returncode, out = _run_engine(engine, args)
+            else:
+                print('%sOK: %s (%d cache files)%s' % (COLOR_GREEN, file, len(cache_files), COLOR_RESET))
+        finally:
+            rmtree(cache_dir)
+
+    print('TOTAL: %d' % (len(files)))
+    print('%sPASS : %d%s' % (COLOR_GREEN, len(files) - fails, COLOR_RESET))
+    print('%sFAIL : %d%s' % (COLOR_RED, fails, COLOR_RESET))
+
+    if not cached_total:
+        raise Exception('no module was cached, the engine must be a release build')
+    if fails > 0:
+        raise Exception('module cache tests failed')
+
+
 def main():
     parser = ArgumentParser(description='Walrus Test Suite Runner')
     parser.add_argument('--engine', metavar='PATH', default=DEFAULT_WALRUS,
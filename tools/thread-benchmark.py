@@ -0,0 +1,182 @@
+#!/usr/bin/env python
+
+# Copyright 2022-present Samsung Electronics Co., Ltd.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measures the throughput of independent instances of one module, each running
+# on its own thread (walrus --instance-threads=N). The start function of the module
+# runs a loop with an indirect call and a memory store, so instances share the
+# bytecode but not their tables and memories. Throughput should grow linearly
+# with the number of threads up to the number of cores.
+# The table is never modified in the first variant, so the indirect call is turned
+# into a direct call. The second variant writes the table with table.set, so every
+# call goes through the call_indirect inline cache of the instance.
+# walrus must be built with WALRUS_THREADS=1, otherwise the instances run one after another.
+
+from __future__ import print_function
+
+import multiprocessing
+import os
+import sys
+import tempfile
+import time
+
+from argparse import ArgumentParser
+from os.path import abspath, dirname, join
+from subprocess import PIPE, Popen
+
+
+PROJECT_SOURCE_DIR = dirname(dirname(abspath(__file__)))
+DEFAULT_WALRUS = join(PROJECT_SOURCE_DIR, 'walrus')
+
+I32 = 0x7f
+FUNCREF = 0x70
+
+
+def uleb(value):
+    result = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            result.append(byte | 0x80)
+        else:
+            result.append(byte)
+            return bytes(result)
+
+
+def sleb(value):
+    result = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if (value == 0 and not byte & 0x40) or (value == -1 and byte & 0x40):
+            result.append(byte)
+            return bytes(result)
+        result.append(byte | 0x80)
+
+
+def vector(items):
+    return uleb(len(items)) + b''.join(items)
+
+
+def section(sid, payload):
+    return bytes(bytearray([sid])) + uleb(len(payload)) + payload
+
+
+def op(*codes):
+    return bytes(bytearray(codes))
+
+
+def i32_const(value):
+    return op(0x41) + sleb(value)
+
+
+def build_module(iterations, mutate_table):
+    # type 0: (i32) -> i32, type 1: () -> ()
+    types = vector([op(0x60) + vector([op(I32)]) + vector([op(I32)]),
+                    op(0x60) + vector([]) + vector([])])
+    functions = vector([uleb(0), uleb(1)])
+    tables = vector([op(FUNCREF, 0x00) + uleb(1)])
+    memories = vector([op(0x00) + uleb(1)])
+    start = uleb(1)
+    elements = vector([uleb(0) + i32_const(0) + op(0x0b) + vector([uleb(0)])])
+
+    # (func (param i32) (result i32) (i32.add (local.get 0) (i32.const 1)))
+    increment = vector([]) + op(0x20) + uleb(0) + i32_const(1) + op(0x6a, 0x0b)
+
+    # local 0: counter, local 1: accumulator
+    code = b''
+    if mutate_table:
+        # table[0] = ref.func 0
+        code += i32_const(0) + op(0xd2) + uleb(0) + op(0x26) + uleb(0)
+    code += op(0x03, 0x40)
+    # acc += call_indirect(counter)
+    code += op(0x20) + uleb(1) + op(0x20) + uleb(0) + i32_const(0)
+    code += op(0x11) + uleb(0) + uleb(0) + op(0x6a, 0x21) + uleb(1)
+    # memory[(counter & 1023) * 4] = acc
+    code += op(0x20) + uleb(0) + i32_const(1023) + op(0x71) + i32_const(2) + op(0x74)
+    code += op(0x20) + uleb(1) + op(0x36) + uleb(2) + uleb(0)
+    # br_if (++counter < iterations)
+    code += op(0x20) + uleb(0) + i32_const(1) + op(0x6a, 0x22) + uleb(0)
+    code += i32_const(iterations) + op(0x49, 0x0d) + uleb(0)
+    code += op(0x0b, 0x0b)
+    loop = vector([uleb(2) + op(I32)]) + code
+
+    code = vector([uleb(len(b)) + b for b in [increment, loop]])
+
+    module = b'\0asm' + op(1, 0, 0, 0)
+    module += section(1, types)
+    module += section(3, functions)
+    module += section(4, tables)
+    module += section(5, memories)
+    module += section(8, start)
+    module += section(9, elements)
+    module += section(10, code)
+    return module
+
+
+def measure(engine, path, threads, repeat):
+    best = None
+    for _ in range(repeat):
+        start = time.time()
+        proc = Popen([engine, '--instance-threads=%d' % threads, path], stdout=PIPE, stderr=PIPE)
+        proc.communicate()
+        elapsed = time.time() - start
+        if proc.returncode != 0:
+            raise Exception('%s failed with exit code %d' % (path, proc.returncode))
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    parser = ArgumentParser(description='Walrus Multi-threaded Throughput Benchmark')
+    parser.add_argument('--engine', metavar='PATH', default=DEFAULT_WALRUS,
+                        help='path to the engine to be measured (default: %(default)s)')
+    parser.add_argument('--threads', metavar='N', type=int, default=multiprocessing.cpu_count(),
+                        help='largest number of threads, each running one instance (default: %(default)s)')
+    parser.add_argument('--iterations', metavar='N', type=int, default=20000000,
+                        help='number of loop iterations per instance (default: %(default)s)')
+    parser.add_argument('--repeat', metavar='N', type=int, default=3,
+                        help='number of runs per thread count, the fastest is reported (default: %(default)s)')
+    args = parser.parse_args()
+
+    thread_counts = []
+    threads = 1
+    while threads < args.threads:
+        thread_counts.append(threads)
+        threads *= 2
+    thread_counts.append(args.threads)
+
+    fd, path = tempfile.mkstemp(suffix='.wasm')
+    try:
+        os.close(fd)
+        for title, mutate_table in [('direct call', False), ('call_indirect on a mutated table', True)]:
+            with open(path, 'wb') as f:
+                f.write(build_module(args.iterations, mutate_table))
+
+            print(title)
+            print('%8s %10s %18s %10s' % ('threads', 'seconds', 'iterations/s', 'scaling'))
+            single = None
+            for threads in thread_counts:
+                elapsed = measure(args.engine, path, threads, args.repeat)
+                throughput = threads * args.iterations / elapsed
+                single = single or throughput
+                print('%8d %10.3f %18.0f %9.2fx' % (threads, elapsed, throughput, throughput / single))
+    finally:
+        os.remove(path)
+
+
+if __name__ == '__main__':
+    main()